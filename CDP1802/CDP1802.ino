@@ -13,8 +13,16 @@
 #include "io.h"
 
 void setup() {  
+#ifdef ELF_SPI_SRAM
+  sram_init();
+#endif
   hw_init();
   loadEEPROM();
+#ifdef ELF_FAST_BOOT
+  if(loadSnapshot()){
+    cpu_outputQ();
+  }
+#endif
 }
 
 void loop() {
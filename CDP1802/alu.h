@@ -0,0 +1,82 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __ALU_H__
+#define __ALU_H__
+
+#include "cpu.h"
+
+/**
+ * Shared ALU for the ADD/SUB/shift families
+ *
+ * Subtraction is done as a + ~b + DF, which is the 1802 rule:
+ * DF=1 means no borrow, exactly the carry out of that add.
+ * So every arithmetic opcode is one add-with-carry and DF comes
+ * straight from the carry, without a 16 bits intermediate.
+ * On AVR the hardware carry flag is used, elsewhere the carry is
+ * taken from bit 8 without any branch.
+ */
+
+// D = a + b + c, DF = carry
+static inline void alu_add(uint8_t a, uint8_t b, uint8_t c){
+#if defined(__AVR__)
+    asm("lsr %[c]      \n\t"
+        "adc %[a], %[b]\n\t"
+        "rol %[c]      \n\t"
+        : [a] "+r" (a), [c] "+r" (c)
+        : [b] "r"  (b));
+    cpu.D  = a;
+    cpu.DF = c;
+#else
+    uint16_t s = (uint16_t)a + b + c;
+    cpu.D  = (uint8_t)s;
+    cpu.DF = (uint8_t)(s>>8);
+#endif
+}
+
+// D = a - b - !c, DF = 1 when there is no borrow
+static inline void alu_sub(uint8_t a, uint8_t b, uint8_t c){
+    alu_add(a, (uint8_t)~b, c);
+}
+
+// D = c:D >> 1, DF = lsb(D)
+static inline void alu_shr(uint8_t c){
+#if defined(__AVR__)
+    uint8_t d = cpu.D;
+    asm("lsr %[c]\n\t"
+        "ror %[d]\n\t"
+        "rol %[c]\n\t"
+        : [d] "+r" (d), [c] "+r" (c));
+    cpu.D  = d;
+    cpu.DF = c;
+#else
+    uint8_t d = cpu.D;
+    cpu.D  = (d>>1) | (c<<7);
+    cpu.DF = d&0x01;
+#endif
+}
+
+// D = D:c << 1, DF = msb(D)
+static inline void alu_shl(uint8_t c){
+#if defined(__AVR__)
+    uint8_t d = cpu.D;
+    asm("lsr %[c]\n\t"
+        "rol %[d]\n\t"
+        "rol %[c]\n\t"
+        : [d] "+r" (d), [c] "+r" (c));
+    cpu.D  = d;
+    cpu.DF = c;
+#else
+    uint8_t d = cpu.D;
+    cpu.D  = (d<<1) | c;
+    cpu.DF = d>>7;
+#endif
+}
+
+#endif
@@ -0,0 +1,169 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "bench.h"
+#include "cpu.h"
+#include "mem.h"
+#include "io.h"
+
+#ifdef ELF_BENCH
+
+static volatile uint16_t benchOverflows;
+
+ISR(TIMER1_OVF_vect){
+    benchOverflows++;
+}
+
+/**
+ * Clocks since the timer was cleared
+ */
+static uint32_t bench_clocks(){
+    uint8_t  sreg = SREG;
+    cli();
+    uint16_t low  = TCNT1;
+    uint32_t high = benchOverflows;
+    if((TIFR1 & _BV(TOV1)) && low < 0x8000) high++;
+    SREG = sreg;
+    return (high<<16) | low;
+}
+
+static void bench_start(){
+    uint8_t sreg = SREG;
+    cli();
+    TCNT1 = 0;
+    TIFR1 = _BV(TOV1);
+    benchOverflows = 0;
+    SREG = sreg;
+}
+
+/**
+ * Code at BENCH_BASE: the opcode and two operand bytes,
+ * every other register points to its own data byte
+ */
+static void bench_state(uint8_t op){
+    for(uint8_t i=0; i<16; i++){
+        WR_M(BENCH_BASE + 0x10 + i, 0x21 + i);
+        cpu.R[i] = BENCH_BASE + 0x10 + i;
+    }
+    WR_M(BENCH_BASE,     op);
+    WR_M(BENCH_BASE + 1, 0x10);
+    WR_M(BENCH_BASE + 2, 0x04);
+    cpu.R[0] = BENCH_BASE;
+    cpu.P = 0;
+    cpu.X = 2;
+}
+
+// Mnemonics of four characters, by I for the rows
+static const char benchGroups[] PROGMEM =
+    "LDN INC DEC     LDA STR         GLO GHI PLO PHI     SEP SEX     ";
+static const char benchRows[] PROGMEM =
+    "BR  BQ  BZ  BDF B1  B2  B3  B4  SKP BNQ BNZ BNF BN1 BN2 BN3 BN4 "
+    "RET DIS LDXASTXDADC SDB SHRCSMB SAV MARKREQ SEQ ADCISDBISHLCSMBI"
+    "LBR LBQ LBZ LBDFNOP LSNQLSNZLSNFLSKPLBNQLBNZLBNFLSIELSQ LSZ LSDF"
+    "LDX OR  AND XOR ADD SD  SHR SM  LDI ORI ANI XRI ADI SDI SHL SMI ";
+
+static void bench_print4(const char *p){
+    for(uint8_t i=0; i<4; i++){
+        char c = pgm_read_byte(&p[i]);
+        if(c != ' ') Serial.print(c);
+    }
+}
+
+/**
+ * The mnemonic, with the register or port but without the operand
+ * bytes the host elfbench also shows
+ */
+static void bench_name(uint8_t op){
+    uint8_t i = op >> 4, n = op & 0x0F;
+
+    switch(i){
+        case 0x3: bench_print4(&benchRows[4*n]);        break;
+        case 0x7: bench_print4(&benchRows[4*(16 + n)]); break;
+        case 0xC: bench_print4(&benchRows[4*(32 + n)]); break;
+        case 0xF: bench_print4(&benchRows[4*(48 + n)]); break;
+        case 0x6:
+            if(n == 0){
+                Serial.print(F("IRX"));
+            }else if(n == 8){
+                Serial.print(F("DB 68"));
+            }else{
+                Serial.print(n < 8 ? F("OUT ") : F("INP "));
+                Serial.print(n & 7);
+            }
+        break;
+        default:
+            bench_print4(&benchGroups[4*i]);
+            Serial.print(F(" R"));
+            Serial.print(n, HEX);
+        break;
+    }
+}
+
+static uint32_t bench_opcode(int16_t op){
+    uint32_t total = 0;
+    for(uint8_t i=0; i<BENCH_REPEAT; i++){
+        bench_state(op<0 ? 0xC4 : op);
+        bench_start();
+        if(op >= 0){
+            cpu_execute();
+        }
+        total += bench_clocks();
+    }
+    return total;
+}
+
+void bench_run(){
+    CDP1802 saved = cpu;
+    uint8_t window[32];
+    uint8_t tccr1a = TCCR1A, tccr1b = TCCR1B, timsk1 = TIMSK1;
+
+    for(uint8_t i=0; i<sizeof(window); i++){
+        window[i] = RD_M(BENCH_BASE + i);
+    }
+
+    // OUT and INP would time the LCD and MCP23017 on I2C
+    ioStub = 1;
+
+    // Normal mode, no prescaler
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10);
+    TIMSK1 = _BV(TOIE1);
+
+    uint32_t overhead = bench_opcode(-1);
+    Serial.println(F("kind,name,opcode,instructions,ns_per_instr,clocks_per_instr"));
+    for(int16_t op=0; op<256; op++){
+        // IDL waits for the IN button
+        if(op == 0x00) continue;
+        uint32_t clocks = bench_opcode(op);
+        clocks = clocks > overhead ? clocks - overhead : 0;
+        Serial.print(F("opcode,"));
+        bench_name(op);
+        Serial.print(',');
+        if(op < 0x10) Serial.print('0');
+        Serial.print(op, HEX);
+        Serial.print(',');
+        Serial.print(BENCH_REPEAT);
+        Serial.print(',');
+        Serial.print(clocks * (1000000000.0 / F_CPU) / BENCH_REPEAT, 1);
+        Serial.print(',');
+        Serial.println((double)clocks / BENCH_REPEAT, 2);
+    }
+
+    TIMSK1 = timsk1;
+    TCCR1B = tccr1b;
+    TCCR1A = tccr1a;
+    ioStub = 0;
+    for(uint8_t i=0; i<sizeof(window); i++){
+        WR_M(BENCH_BASE + i, window[i]);
+    }
+    cpu = saved;
+}
+
+#endif
@@ -0,0 +1,29 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+// Uncomment to build the opcode benchmark, it takes the
+// ST_OP_BENCH slot of the front panel
+//#define ELF_BENCH
+
+#define BENCH_REPEAT 64     // Timed executions of every opcode
+#define BENCH_BASE   (MEM_SIZE-32)  // Window the opcodes may touch
+
+/**
+ * Time every opcode with Timer1 running at the CPU clock and
+ * write the results to Serial with the same CSV columns as the
+ * host elfbench tool, plus the Timer1 clocks each instruction took,
+ * ns_per_instr is those at F_CPU. OUT and INP do not touch the LCD
+ * or the MCP23017 meanwhile. cpu and the memory window are restored.
+ */
+void bench_run();
+
+#endif
@@ -0,0 +1,173 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "mem.h"
+#include "block.h"
+
+// The memory is mem[] and nothing has to see the writes
+#if !defined(ELF_SPI_SRAM) && !defined(ELF_EEPROM_MEM) && !defined(MEM_WRITE_HOOK)
+#define BLK_FLAT
+#endif
+
+uint16_t blkPatched, blkBroken;
+
+// The last insert or delete, for patch_branches()
+static uint16_t mvAt, mvCount;
+static uint32_t mvEnd;
+static uint8_t  mvInsert;
+
+#ifdef BLK_FLAT
+// A SAVE running must copy the pages before they change
+static void touch(uint16_t addr, uint32_t len){
+#ifdef ELF_BG_SAVE
+    for(uint32_t a = addr & ~(SAVE_PAGE-1); a < addr + len; a += SAVE_PAGE){
+        save_touch(a);
+    }
+#else
+    (void)addr;
+    (void)len;
+#endif
+}
+#endif
+
+void blk_fill(uint16_t addr, uint32_t len, uint8_t value){
+#ifdef BLK_FLAT
+    if(addr + len <= MEM_SIZE){
+        touch(addr, len);
+        memset(&mem[addr], value, len);
+        return;
+    }
+#endif
+    for(uint32_t i=0; i<len; i++){
+        MEM_WR((uint16_t)(addr + i), value);
+    }
+}
+
+void blk_copy(uint16_t dst, uint16_t src, uint32_t len){
+#ifdef BLK_FLAT
+    if(dst + len <= MEM_SIZE && src + len <= MEM_SIZE){
+        touch(dst, len);
+        memmove(&mem[dst], &mem[src], len);
+        return;
+    }
+#endif
+    if(dst <= src){
+        for(uint32_t i=0; i<len; i++){
+            MEM_WR((uint16_t)(dst + i), MEM_RD((uint16_t)(src + i)));
+        }
+    }else{
+        for(uint32_t i=len; i-- > 0; ){
+            MEM_WR((uint16_t)(dst + i), MEM_RD((uint16_t)(src + i)));
+        }
+    }
+}
+
+static uint8_t op_length(uint8_t op){
+    uint8_t i = op>>4, n = op&0x0F;
+    if(i == 0x3) return 2;
+    if(i == 0xC) return (n<=3 || (n>=9 && n<=0xB)) ? 3 : 1;
+    if(op == 0x7C || op == 0x7D || op == 0x7F) return 2;
+    if(i == 0xF && n >= 8 && n != 0xE) return 2;
+    return 1;
+}
+
+// Where the byte now at a was before the move
+static uint16_t old_addr(uint16_t a){
+    if(mvInsert){
+        return (a >= mvAt + mvCount && a < mvEnd) ? a - mvCount : a;
+    }
+    return (a >= mvAt && a < mvEnd - mvCount) ? a + mvCount : a;
+}
+
+// Where the byte that was at t is now
+static uint16_t new_target(uint16_t t){
+    if(mvInsert){
+        return (t >= mvAt && t < mvEnd - mvCount) ? t + mvCount : t;
+    }
+    if(t >= mvAt + mvCount && t < mvEnd) return t - mvCount;
+    if(t >= mvAt && t < mvAt + mvCount) return mvAt;
+    return t;
+}
+
+// Linear sweep of [lo, mvEnd) after the move
+static void patch_branches(uint16_t lo){
+    uint32_t a = lo;
+    while(a < mvEnd){
+        uint8_t op  = MEM_RD((uint16_t)a);
+        uint8_t len = op_length(op);
+        if(a + len > mvEnd) break;
+
+        if(len == 2 && (op>>4) == 0x3 && op != 0x38){
+            uint16_t was = (old_addr(a) + 1) & 0xFF00;
+            uint16_t t   = new_target(was | MEM_RD((uint16_t)(a + 1)));
+            if((t & 0xFF00) != ((a + 1) & 0xFF00)){
+                blkBroken++;
+            }else if((uint8_t)t != MEM_RD((uint16_t)(a + 1))){
+                MEM_WR((uint16_t)(a + 1), (uint8_t)t);
+                blkPatched++;
+            }
+        }else if(len == 3){
+            uint16_t old = MEM_RD((uint16_t)(a + 1)) << 8 | MEM_RD((uint16_t)(a + 2));
+            uint16_t t   = new_target(old);
+            if(t != old){
+                MEM_WR((uint16_t)(a + 1), t >> 8);
+                MEM_WR((uint16_t)(a + 2), (uint8_t)t);
+                blkPatched++;
+            }
+        }
+        a += len;
+    }
+}
+
+static void set_move(uint16_t at, uint16_t count, uint32_t end, uint8_t insert){
+    blkPatched = blkBroken = 0;
+    mvAt     = at;
+    mvCount  = count;
+    mvEnd    = end;
+    mvInsert = insert;
+}
+
+void blk_insert(uint16_t at, uint16_t count, uint32_t end, uint16_t lo, uint8_t relocate){
+    if(at >= end) return;
+    if(count > end - at) count = end - at;
+    set_move(at, count, end, 1);
+    blk_copy(at + count, at, end - at - count);
+    blk_fill(at, count, 0x00);
+    if(relocate) patch_branches(lo);
+}
+
+void blk_delete(uint16_t at, uint16_t count, uint32_t end, uint16_t lo, uint8_t relocate){
+    if(at >= end) return;
+    if(count > end - at) count = end - at;
+    set_move(at, count, end, 0);
+    blk_copy(at, at + count, end - at - count);
+    blk_fill(end - count, count, 0x00);
+    if(relocate) patch_branches(lo);
+}
+
+uint32_t blk_search(uint16_t from, uint32_t end, const uint8_t *pat, uint8_t len){
+    if(!len || from + len > end) return BLK_NONE;
+#ifdef BLK_FLAT
+    if(end <= MEM_SIZE){
+        const uint8_t *p = &mem[from], *last = &mem[0] + end - len;
+        while(p <= last && (p = (const uint8_t *)memchr(p, pat[0], last - p + 1))){
+            if(!memcmp(p, pat, len)) return p - &mem[0];
+            p++;
+        }
+        return BLK_NONE;
+    }
+#endif
+    for(uint32_t a=from; a + len <= end; a++){
+        uint8_t i = 0;
+        while(i < len && MEM_RD((uint16_t)(a + i)) == pat[i]) i++;
+        if(i == len) return a;
+    }
+    return BLK_NONE;
+}
@@ -0,0 +1,42 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __BLOCK_H__
+#define __BLOCK_H__
+
+#include <stdint.h>
+
+/**
+ * Memory block operations
+ *
+ * Ranges are start and length or start and end, end is one past
+ * the last byte and may be 0x10000. On the plain memory array they
+ * are memmove/memset/memchr, any other backend goes byte by byte
+ * through MEM_RD/MEM_WR.
+ *
+ * Insert and delete shift [at, end): insert pushes count zeros in
+ * at `at` and drops the bytes shifted past end, delete pulls the
+ * rest down and zeros the tail. With relocate the code in [lo, end)
+ * is decoded from lo and every short and long branch target in the
+ * shifted part moves with it; a target inside deleted bytes goes
+ * to `at`. A short branch whose target or itself ends up in another
+ * page cannot be patched and is counted in blkBroken.
+ */
+#define BLK_NONE 0x10000UL      // blk_search found nothing
+
+extern uint16_t blkPatched;     // Branches changed by the last insert/delete
+extern uint16_t blkBroken;      // Short branches left pointing wrong
+
+void     blk_fill  (uint16_t addr, uint32_t len, uint8_t value);
+void     blk_copy  (uint16_t dst, uint16_t src, uint32_t len);
+void     blk_insert(uint16_t at, uint16_t count, uint32_t end, uint16_t lo, uint8_t relocate);
+void     blk_delete(uint16_t at, uint16_t count, uint32_t end, uint16_t lo, uint8_t relocate);
+uint32_t blk_search(uint16_t from, uint32_t end, const uint8_t *pat, uint8_t len);
+
+#endif
@@ -0,0 +1,471 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "cpu.h"
+#include "mem.h"
+#include "chip8.h"
+
+ELF_TLS uint8_t chip8_enabled = 1;
+
+ELF_TLS uint32_t chip8_ops;
+ELF_TLS uint64_t chip8_instr;
+
+const uint8_t chip8Image[CHIP8_LEN] PROGMEM = {
+    // 1000 Reset: stack 0EDF, display page 0F, PC 0200
+    0xF8, 0x0E, 0xB2, 0xF8, 0xDF, 0xA2, 0xF8, 0x0F,
+    0xBB, 0xF8, 0x02, 0xB5, 0xF8, 0x00, 0xA5, 0xB8,
+    0xA8, 0xF8, 0x10, 0xB4, 0xF8, 0x64, 0xA4, 0xE2,
+    0xD4,
+    // 1019 Frame flag on EF1 ticks the timers, then fetch and dispatch with SEP 3
+    0x9B, 0xFF, 0x01, 0xBF, 0xF8, 0xE0, 0xAF, 0xF8,
+    0x00, 0x3C, 0x26, 0xF8, 0x01, 0xEF, 0xF3, 0x32,
+    0x3D, 0x0F, 0xFB, 0x01, 0x5F, 0x98, 0x32, 0x34,
+    0xFF, 0x01, 0xB8, 0x88, 0x32, 0x3D, 0xFF, 0x01,
+    0xA8, 0x3A, 0x3D, 0x7A, 0xE2, 0x9B, 0xFF, 0x01,
+    0xB6, 0xB7, 0x45, 0xAD, 0xFA, 0x0F, 0xF9, 0xF0,
+    0xA6, 0x45, 0xAE, 0xF6, 0xF6, 0xF6, 0xF6, 0xF9,
+    0xF0, 0xA7, 0x8D, 0xF6, 0xF6, 0xF6, 0xFA, 0x1E,
+    0xFC, 0x66, 0xAF, 0xF8, 0x10, 0xBF, 0x4F, 0xB3,
+    0x0F, 0xA3, 0xD3, 0x30, 0x19,
+    // 1066 Routine per high nybble
+    0x10, 0x86, 0x10, 0xB1, 0x10, 0xAD, 0x10, 0xB8,
+    0x10, 0xBF, 0x10, 0xC6, 0x10, 0xEC, 0x10, 0xEF,
+    0x11, 0x1A, 0x10, 0xCD, 0x10, 0xF5, 0x10, 0xFC,
+    0x11, 0x0D, 0x11, 0x75, 0x10, 0xD4, 0x12, 0x00,
+    // 1086 00E0 CLS, 00EE RET, else 0NNN machine code
+    0x8D, 0x3A, 0x93, 0x8E, 0xFB, 0xE0, 0x32, 0x9A,
+    0x8E, 0xFB, 0xEE, 0x32, 0xA7, 0x8D, 0xFA, 0x0F,
+    0xBC, 0x8E, 0xAC, 0xDC, 0x9B, 0xBF, 0xF8, 0x00,
+    0xAF, 0xF8, 0x00, 0x5F, 0x1F, 0x8F, 0x3A, 0x9F,
+    0xD4, 0x12, 0x72, 0xB5, 0xF0, 0xA5, 0xD4,
+    // 10AD 2NNN CALL, 1NNN JP
+    0x85, 0x73, 0x95, 0x73, 0x8D, 0xFA, 0x0F, 0xB5,
+    0x8E, 0xA5, 0xD4,
+    // 10B8 3XNN, 4XNN, 5XY0, 9XY0 skips
+    0x8E, 0xE6, 0xF3, 0xE2, 0x32, 0xE9, 0xD4, 0x8E,
+    0xE6, 0xF3, 0xE2, 0x3A, 0xE9, 0xD4, 0x07, 0xE6,
+    0xF3, 0xE2, 0x32, 0xE9, 0xD4, 0x07, 0xE6, 0xF3,
+    0xE2, 0x3A, 0xE9, 0xD4,
+    // 10D4 EX9E, EXA1 key through OUT 2 and EF3
+    0xE6, 0x62, 0x26, 0xE2, 0x8E, 0xFB, 0x9E, 0x32,
+    0xE3, 0x8E, 0xFB, 0xA1, 0x32, 0xE6, 0xD4, 0x36,
+    0xE9, 0xD4, 0x3E, 0xE9, 0xD4, 0x15, 0x15, 0xD4,
+    // 10EC 6XNN, 7XNN, ANNN, BNNN, CXNN
+    0x8E, 0x56, 0xD4, 0x8E, 0xE6, 0xF4, 0x56, 0xE2,
+    0xD4, 0x8D, 0xFA, 0x0F, 0xBA, 0x8E, 0xAA, 0xD4,
+    0x96, 0xBF, 0xF8, 0xF0, 0xAF, 0x8E, 0xEF, 0xF4,
+    0xA5, 0x8D, 0xFA, 0x0F, 0x7C, 0x00, 0xB5, 0xE2,
+    0xD4, 0x89, 0x52, 0xFE, 0xFE, 0xF4, 0xFC, 0x01,
+    0xA9, 0x52, 0x8E, 0xF2, 0x56, 0xD4,
+    // 111A 8XYN
+    0xE6, 0x8E, 0xFA, 0x0F, 0x32, 0x42, 0xFF, 0x01,
+    0x32, 0x46, 0xFF, 0x01, 0x32, 0x4A, 0xFF, 0x01,
+    0x32, 0x4E, 0xFF, 0x01, 0x32, 0x55, 0xFF, 0x01,
+    0x32, 0x59, 0xFF, 0x01, 0x32, 0x5D, 0xFF, 0x01,
+    0x32, 0x61, 0xFF, 0x07, 0x32, 0x65, 0xE2, 0xD4,
+    0x07, 0x56, 0xE2, 0xD4, 0x07, 0xF1, 0x30, 0x50,
+    0x07, 0xF2, 0x30, 0x50, 0x07, 0xF3, 0x56, 0xF8,
+    0x00, 0x30, 0x6B, 0x07, 0xF4, 0x30, 0x67, 0x07,
+    0xF5, 0x30, 0x67, 0x07, 0xF6, 0x30, 0x67, 0x07,
+    0xF7, 0x30, 0x67, 0x07, 0xFE, 0x56, 0xF8, 0x00,
+    0x7E, 0xAC, 0x96, 0xBF, 0xF8, 0xFF, 0xAF, 0x8C,
+    0x5F, 0xE2, 0xD4,
+    // 1175 DXYN, VF collision
+    0x07, 0xFA, 0x1F, 0xAC, 0x06, 0xFA, 0x3F, 0xAD,
+    0xFA, 0x07, 0xBD, 0x8E, 0xFA, 0x0F, 0xBE, 0xF8,
+    0x00, 0xBC, 0x9A, 0xBF, 0x8A, 0xAF, 0x9E, 0x32,
+    0xD6, 0x8C, 0xFF, 0x20, 0x33, 0xD6, 0x8C, 0xFE,
+    0xFE, 0xFE, 0x52, 0x8D, 0xF6, 0xF6, 0xF6, 0xF4,
+    0xAB, 0x4F, 0xB7, 0xF8, 0x00, 0xA7, 0x9D, 0xA6,
+    0x86, 0x32, 0xB1, 0x97, 0xF6, 0xB7, 0x87, 0x76,
+    0xA7, 0x26, 0x30, 0xA5, 0xEB, 0x97, 0xF2, 0x32,
+    0xB9, 0xF8, 0x01, 0xBC, 0x97, 0xF3, 0x5B, 0x8D,
+    0xFA, 0x38, 0xFB, 0x38, 0x32, 0xCE, 0x1B, 0x87,
+    0xF2, 0x32, 0xCB, 0xF8, 0x01, 0xBC, 0x87, 0xF3,
+    0x5B, 0xE2, 0x1C, 0x9E, 0xFF, 0x01, 0xBE, 0x30,
+    0x8B, 0x96, 0xBF, 0xF8, 0xFF, 0xAF, 0x9C, 0x5F,
+    // 11DD Fill to the next page
+    0xD4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00,
+    // 1200 FXNN
+    0x8E, 0xFF, 0x07, 0x32, 0x26, 0xFF, 0x03, 0x32,
+    0x4C, 0xFF, 0x0B, 0x32, 0x29, 0xFF, 0x03, 0x32,
+    0x2C, 0xFF, 0x06, 0x32, 0x34, 0xFF, 0x0B, 0x32,
+    0x3E, 0xFF, 0x0A, 0x32, 0x61, 0xFF, 0x22, 0x32,
+    0x88, 0xFF, 0x10, 0x32, 0x88, 0xD4, 0x98, 0x56,
+    0xD4, 0x06, 0xB8, 0xD4, 0x06, 0xA8, 0x32, 0x32,
+    0x7B, 0xD4, 0x7A, 0xD4, 0x8A, 0xE6, 0xF4, 0xAA,
+    0x9A, 0x7C, 0x00, 0xBA, 0xE2, 0xD4, 0x06, 0xFA,
+    0x0F, 0x52, 0xFE, 0xFE, 0xF4, 0xFC, 0xAA, 0xAA,
+    0xF8, 0x12, 0xBA, 0xD4, 0xF8, 0x00, 0x52, 0x62,
+    0x22, 0x36, 0x5E, 0x02, 0xFC, 0x01, 0xFA, 0x0F,
+    0x52, 0x3A, 0x4F, 0x25, 0x25, 0xD4, 0x02, 0x56,
+    0xD4, 0x06, 0xAF, 0x9A, 0xBC, 0x8A, 0xAC, 0xF8,
+    0x00, 0xAD, 0x8F, 0xFF, 0x64, 0x3B, 0x73, 0xAF,
+    0x1D, 0x30, 0x6A, 0x8D, 0x5C, 0x1C, 0xF8, 0x00,
+    0xAD, 0x8F, 0xFF, 0x0A, 0x3B, 0x82, 0xAF, 0x1D,
+    0x30, 0x79, 0x8D, 0x5C, 0x1C, 0x8F, 0x5C, 0xD4,
+    0x96, 0xBF, 0xF8, 0xF0, 0xAF, 0x86, 0xFC, 0x01,
+    0xAC, 0x8E, 0xFB, 0x55, 0x32, 0xA0, 0x4A, 0x5F,
+    0x1F, 0x8F, 0x52, 0x8C, 0xF3, 0x3A, 0x96, 0xD4,
+    0x4F, 0x5A, 0x1A, 0x8F, 0x52, 0x8C, 0xF3, 0x3A,
+    0xA0, 0xD4,
+    // 12AA Hex digits
+    0xF0, 0x90, 0x90, 0x90, 0xF0, 0x20, 0x60, 0x20,
+    0x20, 0x70, 0xF0, 0x10, 0xF0, 0x80, 0xF0, 0xF0,
+    0x10, 0xF0, 0x10, 0xF0, 0x90, 0x90, 0xF0, 0x10,
+    0x10, 0xF0, 0x80, 0xF0, 0x10, 0xF0, 0xF0, 0x80,
+    0xF0, 0x90, 0xF0, 0xF0, 0x10, 0x20, 0x40, 0x40,
+    0xF0, 0x90, 0xF0, 0x90, 0xF0, 0xF0, 0x90, 0xF0,
+    0x10, 0xF0, 0xF0, 0x90, 0xF0, 0x90, 0x90, 0xE0,
+    0x90, 0xE0, 0x90, 0xE0, 0xF0, 0x80, 0x80, 0x80,
+    0xF0, 0xE0, 0x90, 0x90, 0x90, 0xE0, 0xF0, 0x80,
+    0xF0, 0x80, 0xF0, 0xF0, 0x80, 0xF0, 0x80, 0x80
+};
+
+void chip8_load(){
+    MEM_WR(0, 0xC0);
+    MEM_WR(1, CHIP8_BASE >> 8);
+    MEM_WR(2, CHIP8_BASE & 0xFF);
+    for(uint16_t i=0; i<CHIP8_LEN; i++){
+        MEM_WR(CHIP8_BASE + i, pgm_read_byte(&chip8Image[i]));
+    }
+}
+
+#ifdef ELF_CHIP8
+
+#if MEM_SIZE < CHIP8_BASE + CHIP8_LEN
+#error "ELF_CHIP8 needs the memory past the interpreter"
+#endif
+
+// Start of the routine being run, device accesses are timed from it
+static ELF_TLS uint64_t start;
+
+// At the i-th instruction of the routine
+static void at(uint8_t i){
+    SET_CYCLES(start + 2*i);
+}
+
+// Set by a write over the interpreter, the batch ends there
+static ELF_TLS uint8_t stale;
+
+static void put(uint16_t addr, uint8_t value){
+    WR_M(addr, value);
+    if((uint16_t)(addr - CHIP8_BASE) < CHIP8_LEN) stale = 1;
+}
+
+static uint8_t chip8_match(){
+    for(uint16_t i=0; i<CHIP8_LEN; i++){
+        if(MEM_RD(CHIP8_BASE + i) != pgm_read_byte(&chip8Image[i])) return 0;
+    }
+    return 1;
+}
+
+/**
+ * The fetch loop from BR fetch to SEP 3, returns its instructions.
+ * EF1 is tested by the 8th, REQ when the tone ends is the 22nd
+ * plus one for EF1 set and two for a delay running.
+ */
+static uint8_t fetch(uint64_t t, uint16_t work){
+    SET_CYCLES(t + 14);
+    cpu_testFlags();
+    uint8_t n = 43 + cpu.EF1;
+    uint8_t flag = RD_M(work | 0xE0);
+    if(cpu.EF1 == flag) return n;
+
+    put(work | 0xE0, flag ^ 1);
+    n += 7;
+    uint8_t delay = cpu.R[8] >> 8, sound = cpu.R[8], late = cpu.EF1;
+    if(delay){
+        delay--;
+        n += 2;
+        late += 2;
+    }
+    if(sound){
+        n += 3;
+        if(!--sound){
+            SET_CYCLES(t + 2*(21 + late));
+            cpu.Q = 0;
+            cpu_outputQ();
+            n++;
+        }
+    }
+    cpu.R[8] = (uint16_t)delay << 8 | sound;
+    return n;
+}
+
+// 8XYN, returns the instructions
+static uint8_t alu(uint16_t vx, uint16_t vy, uint16_t vf, uint8_t k){
+    uint8_t x = RD_M(vx), y = RD_M(vy), v, f;
+
+    switch(k){
+        case 0x0: put(vx, y); return 8;
+        case 0x1: v = x | y; f = 0; break;
+        case 0x2: v = x & y; f = 0; break;
+        case 0x3: v = x ^ y; f = 0; break;
+        case 0x4: v = x + y; f = v < x; break;
+        case 0x5: v = x - y; f = x >= y; break;
+        case 0x6: v = y >> 1; f = y & 1; break;
+        case 0x7: v = y - x; f = y >= x; break;
+        case 0xE: v = y << 1; f = y >> 7; break;
+        default:  return 22;
+    }
+    put(vx, v);
+    put(vf, f);
+    // The SMI chain, then the operation and storing VF
+    if(k == 0xE) return 34;
+    return 4 + 2*k + (k == 3 ? 14 : 15);
+}
+
+// DXYN
+static uint16_t draw(uint16_t page, uint16_t vx, uint16_t vy, uint16_t vf, uint8_t rows){
+    uint8_t  y = RD_M(vy) & 0x1F, x = RD_M(vx) & 0x3F, shift = x & 7, hit = 0;
+    uint16_t sprite = cpu.R[0xA];
+    uint16_t m = 17;
+
+    for(;;){
+        m += 2;
+        if(!rows) break;
+        m += 3;
+        if(y >= 32) break;
+        uint16_t a    = page | (uint8_t)(y*8 + (x>>3));
+        uint16_t bits = (uint16_t)RD_M(sprite++) << 8 >> shift;
+        put(cpu.R[2], y*8);
+        m += 11 + 6 + 10*shift + 2 + 4 + 3 + 4 + 6;
+
+        uint8_t b = RD_M(a);
+        if(b & (bits >> 8)){
+            hit = 1;
+            m += 2;
+        }
+        put(a, b ^ (bits >> 8));
+        // Not past the right edge
+        if((x & 0x38) != 0x38){
+            m += 7;
+            b = RD_M(a + 1);
+            if(b & (uint8_t)bits){
+                hit = 1;
+                m += 2;
+            }
+            put(a + 1, b ^ (uint8_t)bits);
+            a++;
+        }
+        // RB.0 is the display pointer
+        cpu.R[0xB] = a;
+        y++;
+        rows--;
+    }
+    put(vf, hit);
+    return m + 7;
+}
+
+// FXNN
+static uint16_t misc(uint16_t vx, uint8_t x, uint8_t lo){
+    uint8_t  v = RD_M(vx);
+    uint16_t i = cpu.R[0xA];
+
+    switch(lo){
+        case 0x07:
+            put(vx, cpu.R[8] >> 8);
+            return 6;
+        case 0x0A:
+            // OUT 2 and B3 for every key, again from the fetch when none is down
+            for(uint8_t k=0; k<16; k++){
+                put(cpu.R[2], k);
+                at(7 + 8*k);
+                cpu_output(k, 2);
+                at(9 + 8*k);
+                cpu_testFlags();
+                if(cpu.EF3){
+                    put(vx, k);
+                    return 13 + 8*k;
+                }
+            }
+            put(cpu.R[2], 0);
+            cpu.R[5] -= 2;
+            return 138;
+        case 0x15:
+            cpu.R[8] = (uint16_t)v << 8 | (cpu.R[8] & 0xFF);
+            return 10;
+        case 0x18:
+            cpu.R[8] = (cpu.R[8] & 0xFF00) | v;
+            at(12);
+            cpu.Q = v ? 1 : 0;
+            cpu_outputQ();
+            return 14;
+        case 0x1E:
+            cpu.R[0xA] = i + v;
+            return 20;
+        case 0x29:
+            put(cpu.R[2], v & 0x0F);
+            cpu.R[0xA] = CHIP8_FONT + (v & 0x0F)*5;
+            return 24;
+        case 0x33: {
+            uint8_t h = v / 100, t = v / 10 % 10;
+            put(i, h);
+            put((uint16_t)(i + 1), t);
+            put((uint16_t)(i + 2), v % 10);
+            return 40 + 6*(h + t);
+        }
+        case 0x55:
+        case 0x65: {
+            uint16_t vr = vx - x;
+            for(uint8_t r=0; r<=x; r++){
+                if(lo == 0x55){
+                    put(i, RD_M(vr + r));
+                }else{
+                    put(vr + r, RD_M(i));
+                }
+                i++;
+            }
+            cpu.R[0xA] = i;
+            put(cpu.R[2], (uint8_t)(vr + x + 1));
+            return (lo == 0x55 ? 28 : 30) + 8*(x + 1);
+        }
+    }
+    return 20;
+}
+
+/**
+ * One instruction from the fetch at t, returns 0 for 0NNN, which
+ * runs 1802 code and is left to the interpreter
+ */
+static uint8_t step(uint64_t *t){
+    uint16_t pc = cpu.R[5];
+    uint8_t  hi = MEM_RD(pc), lo = MEM_RD((uint16_t)(pc + 1));
+    if(hi < 0x10 && !(hi == 0 && (lo == 0xE0 || lo == 0xEE))) return 0;
+
+    uint16_t page = cpu.R[0xB] & 0xFF00;
+    uint16_t work = (uint16_t)(page - 0x100);
+    uint16_t vx   = work | 0xF0 | (hi & 0x0F);
+    uint16_t vy   = work | 0xF0 | (lo >> 4);
+    uint16_t vf   = work | 0xFF;
+    uint16_t nnn  = (hi & 0x0F) << 8 | lo;
+    uint16_t m;
+
+    start = *t + 2*fetch(*t, work);
+    cpu.R[5] += 2;
+
+    switch(hi >> 4){
+        case 0x0:
+            if(lo == 0xE0){
+                for(uint16_t a=0; a<256; a++){
+                    put(page | a, 0);
+                }
+                m = 1290;
+            }else{
+                cpu.R[2]++;
+                hi = RD_M(cpu.R[2]);
+                cpu.R[2]++;
+                cpu.R[5] = hi << 8 | RD_M(cpu.R[2]);
+                m = 14;
+            }
+            break;
+        case 0x1:
+            cpu.R[5] = nnn;
+            m = 6;
+            break;
+        case 0x2:
+            put(cpu.R[2], cpu.R[5] & 0xFF);
+            cpu.R[2]--;
+            put(cpu.R[2], cpu.R[5] >> 8);
+            cpu.R[2]--;
+            cpu.R[5] = nnn;
+            m = 10;
+            break;
+        case 0x3:
+        case 0x4:
+        case 0x5:
+        case 0x9: {
+            uint8_t equal = RD_M(vx) == ((hi >> 4) == 0x3 || (hi >> 4) == 0x4 ? lo : RD_M(vy));
+            uint8_t skip  = ((hi >> 4) == 0x3 || (hi >> 4) == 0x5) ? equal : !equal;
+            if(skip) cpu.R[5] += 2;
+            m = skip ? 8 : 6;
+            break;
+        }
+        case 0x6:
+            put(vx, lo);
+            m = 3;
+            break;
+        case 0x7:
+            put(vx, RD_M(vx) + lo);
+            m = 6;
+            break;
+        case 0x8:
+            m = alu(vx, vy, vf, lo & 0x0F);
+            break;
+        case 0xA:
+            cpu.R[0xA] = nnn;
+            m = 6;
+            break;
+        case 0xB:
+            cpu.R[5] = nnn + RD_M(work | 0xF0);
+            m = 14;
+            break;
+        case 0xC: {
+            uint8_t r = (uint8_t)cpu.R[9] * 5 + 1;
+            cpu.R[9] = (cpu.R[9] & 0xFF00) | r;
+            put(cpu.R[2], r);
+            put(vx, r & lo);
+            m = 12;
+            break;
+        }
+        case 0xD:
+            m = draw(page, vx, vy, vf, lo & 0x0F);
+            break;
+        case 0xE:
+            at(1);
+            cpu_output(RD_M(vx), 2);
+            if(lo == 0x9E){
+                at(7);
+                cpu_testFlags();
+                if(cpu.EF3) cpu.R[5] += 2;
+                m = cpu.EF3 ? 11 : 9;
+            }else if(lo == 0xA1){
+                at(10);
+                cpu_testFlags();
+                if(!cpu.EF3) cpu.R[5] += 2;
+                m = cpu.EF3 ? 12 : 14;
+            }else{
+                m = 11;
+            }
+            break;
+        default:
+            m = misc(vx, hi & 0x0F, lo);
+            break;
+    }
+    *t = start + 2*m;
+    return 1;
+}
+
+uint8_t chip8_execute(){
+    if(cpu.R[4] != CHIP8_RESUME || !chip8_match()) return 0;
+
+    // The SEP 4, then every instruction from BR fetch on
+    uint64_t from = GET_CYCLES();
+    uint64_t t    = from + 2;
+    uint16_t n    = 0;
+    stale = 0;
+    while(n < CHIP8_BATCH && !stale && step(&t)) n++;
+    chip8_ops   += n;
+    chip8_instr += (t - from) / 2 - 1;
+
+    SET_CYCLES(t);
+    if(n) cpu.X = 2;
+    cpu.P = 4;
+    cpu.I = 0xD;
+    cpu.N = 4;
+    return 1;
+}
+
+#endif
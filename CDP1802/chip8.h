@@ -0,0 +1,68 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __CHIP8_H__
+#define __CHIP8_H__
+
+#include "cpu.h"
+
+// Build with -DELF_CHIP8 to run CHIP-8 programs natively, memory
+// must reach past the interpreter (SPI SRAM on the board)
+
+/**
+ * CHIP-8
+ *
+ * chip8Image is a CHIP-8 interpreter for the 1802 laid out like
+ * the VIP one: programs at 0200, the call stack down from 0EDF,
+ * the frame flag at 0EE0, V0-VF at 0EF0 and the 64x32 display in
+ * page 0F, the page the 1861 shows. It sits at CHIP8_BASE, above the
+ * 4 KB, with LBR to it at 0000.
+ *
+ *   R2 stack  R4 fetch loop  R5 PC  R8.1 delay  R8.0 sound
+ *   R9.0 random  RA I  RB.1 display page
+ *
+ * The keypad is latched with OUT 2 and read on EF3, EF1 toggles
+ * every frame and ticks the timers, Q is the tone. 0NNN runs 1802
+ * code at NNN with P=C, it returns with SEP 4.
+ *
+ * Each routine returns to the fetch loop with SEP 4. With ELF_CHIP8
+ * that SEP runs the next CHIP8_BATCH instructions natively, with
+ * the same memory, device accesses and cycles as the interpreter,
+ * and leaves the CPU back in the fetch loop.
+ */
+#define CHIP8_BASE   0x1000
+#define CHIP8_LEN    762
+#define CHIP8_RESUME 0x1064     // R4 when a routine returns
+#define CHIP8_FONT   0x12AA
+#define CHIP8_PROG   0x0200
+
+#define CHIP8_BATCH  256
+
+extern const uint8_t chip8Image[CHIP8_LEN];
+
+// Runtime switch, clear it to interpret the interpreter
+extern ELF_TLS uint8_t chip8_enabled;
+
+// Instructions run natively
+extern ELF_TLS uint32_t chip8_ops;
+
+// 1802 instructions the batches stand for, without the SEP 4 that
+// starts them, callers counting instructions add them
+extern ELF_TLS uint64_t chip8_instr;
+
+// LBR at 0000 and the interpreter, the program goes at CHIP8_PROG
+void    chip8_load();
+
+/**
+ * Called for SEP 4, runs CHIP-8 instructions when R4 is the fetch
+ * loop of chip8Image, else returns 0 without touching anything
+ */
+uint8_t chip8_execute();
+
+#endif
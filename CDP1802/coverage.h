@@ -0,0 +1,53 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __COVERAGE_H__
+#define __COVERAGE_H__
+
+#include <stdio.h>
+
+/**
+ * Coverage and access counts, host builds with -DELF_COVERAGE
+ *
+ * Every address has a byte of COV_* flags telling how it was used
+ * and a count of accesses for the heatmap, which stops at
+ * UINT32_MAX. Reports are written by host/coverage.cpp.
+ */
+#define COV_OP     0x01     // Fetched as an opcode
+#define COV_ARG    0x02     // Immediate or branch operand
+#define COV_READ   0x04     // Data read
+#define COV_WRITE  0x08     // Data write
+
+extern uint8_t  cov_flags[MEM_SIZE];
+extern uint32_t cov_count[MEM_SIZE];
+
+static inline uint8_t cov_read(uint16_t addr, uint8_t how){
+    addr %= MEM_SIZE;
+    cov_flags[addr] |= how;
+    cov_count[addr] += cov_count[addr] != UINT32_MAX;
+    return MEM_RD(addr);
+}
+
+static inline void cov_write(uint16_t addr, uint8_t value){
+    addr %= MEM_SIZE;
+    cov_flags[addr] |= COV_WRITE;
+    cov_count[addr] += cov_count[addr] != UINT32_MAX;
+    MEM_WR(addr, value);
+}
+
+void cov_clear();
+
+// Annotated disassembly of the code seen, with the data ranges
+void cov_listing(FILE *f);
+
+// Access heatmap, one row per 256 bytes page used
+void cov_heatmap_text(FILE *f);
+void cov_heatmap_html(FILE *f);
+
+#endif
@@ -13,7 +13,7 @@
 #include "mem.h"
 #include "io.h"
 
-CDP1802 cpu;
+ELF_TLS CDP1802 cpu;
 
 /**
  * Reset
@@ -31,7 +31,7 @@ void cpu_reset(){
   cpu.X    = 0;  
   cpu.R[0] = 0;
   
-  cpu.cycles = 0;
+  SET_CYCLES(0);
   cpu_outputQ();
 }
 
@@ -42,9 +42,9 @@ void cpu_reset(){
  * 
  */
 uint8_t cpu_fetch(){
-    uint8_t opcode = RD_M(cpu.R[cpu.P]);
+    uint8_t opcode = RD_OP(cpu.R[cpu.P]);
     cpu.I = opcode>>4;
-    cpu.N = opcode;
+    cpu.N = opcode&0x0F;
   
     cpu.R[cpu.P]++;
     return opcode;
@@ -56,7 +56,42 @@ uint8_t cpu_fetch(){
  */
 void cpuStatus(char *line){
    sprintf(line, 
-           "D%02X P%XX%X:I%XN%X R0=0x%04X R1=0x%04X cy%ld\n", 
-            cpu.D, cpu.P, cpu.X, cpu.I, cpu.N, cpu.R[0], cpu.R[1], cpu.cycles); 
+           "D%02X P%XX%X:I%XN%X R0=0x%04X R1=0x%04X cy%lu\n", 
+            cpu.D, cpu.P, cpu.X, cpu.I, cpu.N, cpu.R[0], cpu.R[1], (unsigned long)cpu.cycles); 
+}
+
+/**
+ * Packs the CPU registers into the compact snapshot form
+ */
+void cpu_pack(CDP1802Packed *p){
+  memcpy(p->R, cpu.R, sizeof(cpu.R));
+  p->D  = cpu.D;
+  p->T  = cpu.T;
+  p->XP = (cpu.X<<4) | cpu.P;
+  p->IN = (cpu.I<<4) | cpu.N;
+  p->flags = cpu.DF      | cpu.IE<<1  | cpu.Q<<2 |
+             cpu.EF1<<3  | cpu.EF2<<4 | cpu.EF3<<5 | cpu.EF4<<6;
+  p->cycles = GET_CYCLES();
+}
+
+/**
+ * Restores the CPU registers from the compact snapshot form
+ */
+void cpu_unpack(const CDP1802Packed *p){
+  memcpy(cpu.R, p->R, sizeof(cpu.R));
+  cpu.D  = p->D;
+  cpu.T  = p->T;
+  cpu.X  = p->XP>>4;
+  cpu.P  = p->XP&0x0F;
+  cpu.I  = p->IN>>4;
+  cpu.N  = p->IN&0x0F;
+  cpu.DF  = (p->flags>>0)&1;
+  cpu.IE  = (p->flags>>1)&1;
+  cpu.Q   = (p->flags>>2)&1;
+  cpu.EF1 = (p->flags>>3)&1;
+  cpu.EF2 = (p->flags>>4)&1;
+  cpu.EF3 = (p->flags>>5)&1;
+  cpu.EF4 = (p->flags>>6)&1;
+  SET_CYCLES(p->cycles);
 }
 
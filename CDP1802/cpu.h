@@ -24,25 +24,35 @@
 #define GET_R_LOW(x)    ((uint8_t)(cpu.R[x]))
 #define GET_R_HIGH(x)   ((uint8_t)(cpu.R[x]>>8))
 
+// Storage class of the machine state. The host build defines it as
+// thread_local so several machines can run side by side.
+#ifndef ELF_TLS
+#define ELF_TLS
+#endif
+
 
 /**
  * CDP1802 CPU Definition
  * 
- * sizeof(cpu)=45
+ * Hot path layout, every field is a whole byte so the execute loop
+ * never pays a read-modify-write for a nybble or a single bit.
+ * Use cpu_pack()/cpu_unpack() for the compact form.
+ *
+ * sizeof(cpu)=53 on the AVR, the host pads it to 56
  */
-typedef struct CDP1802{
+struct CDP1802{
   uint16_t R[16]; // 16 Bits 1 of 16 Scratchpad Registers
     
   uint8_t  D;     // 8 Bits Data Register (Accumulator)
   uint8_t  T;     // 8 Bits Holds X and P during interrupt, X is high nybble, not directly accessable  
     
-  uint8_t  P:4;   // 4 Bits Designates which register is Program Counter
-  uint8_t  X:4;   // 4 Bits Designates which register is Data Pointer
-  uint8_t  I:4;   // 4 Bits Holds High-Order Instruction Digit, not directly accessable
-  uint8_t  N:4;   // 4 Bits Low nybble of instruction byte, not directly accessable
+  uint8_t  P;     // 4 Bits Designates which register is Program Counter
+  uint8_t  X;     // 4 Bits Designates which register is Data Pointer
+  uint8_t  I;     // 4 Bits Holds High-Order Instruction Digit, not directly accessable
+  uint8_t  N;     // 4 Bits Low nybble of instruction byte, not directly accessable
 
-  uint8_t  DF:1;  // 1-Bit Data Flag (ALU Carry/borrow)  
-  uint8_t  IE:1;  // 1-Bit Interrupt Enable
+  uint8_t  DF;    // 1-Bit Data Flag (ALU Carry/borrow)  
+  uint8_t  IE;    // 1-Bit Interrupt Enable
 
   /**
     Single bit output from the CPU which can be set or reset
@@ -50,7 +60,7 @@ typedef struct CDP1802{
     Q is set or reset between the trailing edge of TPA and
     the leading edge of TPB. 
    */
-  uint8_t  Q:1;   // 1-Bit Output Flip/Flop
+  uint8_t  Q;     // 1-Bit Output Flip/Flop
 
   /**
     EF1 to EF4 (4 Flags)
@@ -63,16 +73,40 @@ typedef struct CDP1802{
     the program must routinely test the status of these flag(s). 
     The flag(s) are sampled at the beginning of every S1 cycle.
    */
-  uint8_t  EF1:1; // External Flag 1
-  uint8_t  EF2:1; // External Flag 2
-  uint8_t  EF3:1; // External Flag 3
-  uint8_t  EF4:1; // External Flag 4
+  uint8_t  EF1;   // External Flag 1
+  uint8_t  EF2;   // External Flag 2
+  uint8_t  EF3;   // External Flag 3
+  uint8_t  EF4;   // External Flag 4
 
-  /** Cycles counter */
+  /** Cycles counter, 32 bits on the hot path extended on overflow */
+  uint32_t cycles;
+  uint32_t cyclesHigh;
+};
+
+/**
+ * Packed CPU form for snapshots
+ * 
+ * sizeof(CDP1802Packed)=45 on the AVR, the host pads it to 48
+ */
+struct CDP1802Packed{
+  uint16_t R[16];
+  uint8_t  D;
+  uint8_t  T;
+  uint8_t  XP;     // X high nybble, P low nybble
+  uint8_t  IN;     // I high nybble, N low nybble
+  uint8_t  flags;  // DF IE Q EF1 EF2 EF3 EF4, DF is bit 0
   uint64_t cycles;
 };
 
-extern CDP1802 cpu;
+#define ADD_CYCLES(n)   {cpu.cycles+=(n); if(cpu.cycles<(n)) cpu.cyclesHigh++;}
+#define GET_CYCLES()    GET_CYCLES_OF(cpu)
+#define SET_CYCLES(t)   SET_CYCLES_OF(cpu, t)
+
+// The same for a CDP1802 other than cpu
+#define GET_CYCLES_OF(c)    ((((uint64_t)(c).cyclesHigh)<<32) | (c).cycles)
+#define SET_CYCLES_OF(c, t) {uint64_t t_=(t); (c).cycles=(uint32_t)t_; (c).cyclesHigh=(uint32_t)(t_>>32);}
+
+extern ELF_TLS CDP1802 cpu;
 
 void    cpu_reset();
 uint8_t cpu_fetch();
@@ -83,5 +117,7 @@ uint8_t cpu_input (uint8_t Nlines);
 void    cpu_outputQ();
 void    dump(char*line);
 void    cpuStatus(char*line);
+void    cpu_pack  (CDP1802Packed *p);
+void    cpu_unpack(const CDP1802Packed *p);
 
 #endif
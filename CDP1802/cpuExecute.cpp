@@ -12,10 +12,15 @@
 #include "io.h"
 #include "hw.h"
 #include "mem.h"
+#include "alu.h"
+#include "scrt.h"
+#include "tape.h"
+#include "chip8.h"
+#include "fuse.h"
 
 void cpu_execute(){
-    uint8_t  bkp8, msb, lsb, bus8;
-    uint16_t sum16, sub16, bkp16;
+    uint8_t  bkp8, bus8;
+    uint16_t bkp16;
 
     // Fecth
     uint8_t opcode = cpu_fetch();
@@ -29,7 +34,7 @@ void cpu_execute(){
         // IDL  Idle  Wait for DMA or Interrupt M(R(0))->Bus
         case 0x00:
             cpu_idle();
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
 
         // I = 0, N = 1 ~ F, LDN
@@ -45,7 +50,7 @@ void cpu_execute(){
         case 0x08: case 0x09: case 0x0A: case 0x0B: 
         case 0x0C: case 0x0D: case 0x0E: case 0x0F: 
             cpu.D = RD_M(cpu.R[cpu.N]);
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 1, N = 0 ~ F, INC
@@ -59,7 +64,7 @@ void cpu_execute(){
         case 0x18: case 0x19: case 0x1A: case 0x1B: 
         case 0x1C: case 0x1D: case 0x1E: case 0x1F: 
             cpu.R[cpu.N]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 2, N = 0 ~ F, DEC
@@ -73,7 +78,10 @@ void cpu_execute(){
         case 0x28: case 0x29: case 0x2A: case 0x2B: 
         case 0x2C: case 0x2D: case 0x2E: case 0x2F: 
             cpu.R[cpu.N]--;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
+#ifdef ELF_FUSE
+            if(fuse_enabled) fuse_dec();
+#endif
         break;
         
         // I = 3, N = 0, BR
@@ -88,9 +96,9 @@ void cpu_execute(){
         // BR  Branch 
         //    M(R(P))->R(P).0
         case 0x30:
-            bkp8=RD_M(cpu.R[cpu.P]);
+            bkp8=RD_ARG(cpu.R[cpu.P]);
             SET_R_LOW(cpu.P, bkp8);
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 3, N = 1, BQ
@@ -106,12 +114,12 @@ void cpu_execute(){
         //      R(P)+1->R(P)
         case 0x31:
             if(cpu.Q){
-                bkp8=RD_M(cpu.R[cpu.P]);
+                bkp8=RD_ARG(cpu.R[cpu.P]);
                 SET_R_LOW(cpu.P, bkp8);
             }else{
                 cpu.R[cpu.P]++;
             }
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 3, N = 2, BZ
@@ -126,12 +134,12 @@ void cpu_execute(){
         //      R(P)+1->R(P)
         case 0x32:
             if(cpu.D==0x00){
-                bkp8=RD_M(cpu.R[cpu.P]);
+                bkp8=RD_ARG(cpu.R[cpu.P]);
                 SET_R_LOW(cpu.P, bkp8);
             }else{
                 cpu.R[cpu.P]++;
             }
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
 
@@ -142,12 +150,12 @@ void cpu_execute(){
         //     R(P)+1->R(P)
         case 0x33:
             if(cpu.DF){
-                bkp8=RD_M(cpu.R[cpu.P]);
+                bkp8=RD_ARG(cpu.R[cpu.P]);
                 SET_R_LOW(cpu.P, bkp8);
             }else{
                 cpu.R[cpu.P]++;
             }
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 3, N = 4, B1
@@ -161,12 +169,12 @@ void cpu_execute(){
         case 0x34:
             cpu_testFlags();
             if(cpu.EF1){
-                bkp8=RD_M(cpu.R[cpu.P]);
+                bkp8=RD_ARG(cpu.R[cpu.P]);
                 SET_R_LOW(cpu.P, bkp8);
             }else{
                 cpu.R[cpu.P]++;
             }
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 3, N = 5, 6, 7, B2, B3, B4
@@ -176,36 +184,36 @@ void cpu_execute(){
         case 0x35:
             cpu_testFlags();
             if(cpu.EF2){
-                bkp8=RD_M(cpu.R[cpu.P]);
+                bkp8=RD_ARG(cpu.R[cpu.P]);
                 SET_R_LOW(cpu.P, bkp8);
             }else{
                 cpu.R[cpu.P]++;
             }
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // B3  Branch if EF3=1  if EF3=1, M(R(P))->R(P).0 else R(P)+1->R(P)
         case 0x36:
             cpu_testFlags();
             if(cpu.EF3){
-                bkp8=RD_M(cpu.R[cpu.P]);
+                bkp8=RD_ARG(cpu.R[cpu.P]);
                 SET_R_LOW(cpu.P, bkp8);
             }else{
                 cpu.R[cpu.P]++;
             }
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // B4  Branch if EF4=1  if EF4=1, M(R(P))->R(P).0 else R(P)+1->R(P)
         case 0x37:
             cpu_testFlags();
             if(cpu.EF4){
-                bkp8=RD_M(cpu.R[cpu.P]);
+                bkp8=RD_ARG(cpu.R[cpu.P]);
                 SET_R_LOW(cpu.P, bkp8);
             }else{
                 cpu.R[cpu.P]++;
             }
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 3, N = 8, SKP (aka NBR)
@@ -218,7 +226,7 @@ void cpu_execute(){
         //   R(P)+1->R(P)
         case 0x38:
             cpu.R[cpu.P]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 3, N = 9, BNQ
@@ -231,12 +239,12 @@ void cpu_execute(){
         //      R(P)+1->R(P)
         case 0x39:
             if(!cpu.Q){
-                bkp8=RD_M(cpu.R[cpu.P]);
+                bkp8=RD_ARG(cpu.R[cpu.P]);
                 SET_R_LOW(cpu.P, bkp8);
             }else{
                 cpu.R[cpu.P]++;
             }
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 3, N = A, BNZ
@@ -250,12 +258,12 @@ void cpu_execute(){
         //      R(P)+1->R(P)
         case 0x3A:
             if(cpu.D!=0x00){
-                bkp8=RD_M(cpu.R[cpu.P]);
+                bkp8=RD_ARG(cpu.R[cpu.P]);
                 SET_R_LOW(cpu.P, bkp8);
             }else{
                 cpu.R[cpu.P]++;
             }
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 3, N = B, BNF (aka BM, BL)
@@ -269,12 +277,12 @@ void cpu_execute(){
         //     R(P)+1->R(P)
         case 0x3B:
             if(!cpu.DF){
-                bkp8=RD_M(cpu.R[cpu.P]);
+                bkp8=RD_ARG(cpu.R[cpu.P]);
                 SET_R_LOW(cpu.P, bkp8);
             }else{
                 cpu.R[cpu.P]++;
             }
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 3, N = C, D, E, F, BN1, BN2, BN3, BN4
@@ -290,48 +298,48 @@ void cpu_execute(){
         case 0x3C:
             cpu_testFlags();
             if(!cpu.EF1){
-                bkp8=RD_M(cpu.R[cpu.P]);
+                bkp8=RD_ARG(cpu.R[cpu.P]);
                 SET_R_LOW(cpu.P, bkp8);
             }else{
                 cpu.R[cpu.P]++;
             }
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // BN2  Branch if EF2=0  if EF2=0, M(R(P))->R(P).0 else R(P)+1->R(P)
         case 0x3D:
             cpu_testFlags();
             if(!cpu.EF2){
-                bkp8=RD_M(cpu.R[cpu.P]);
+                bkp8=RD_ARG(cpu.R[cpu.P]);
                 SET_R_LOW(cpu.P, bkp8);
             }else{
                 cpu.R[cpu.P]++;
             }
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // BN3  Branch if EF3=0  if EF3=0, M(R(P))->R(P).0 else R(P)+1->R(P)
         case 0x3E:
             cpu_testFlags();
             if(!cpu.EF3){
-                bkp8=RD_M(cpu.R[cpu.P]);
+                bkp8=RD_ARG(cpu.R[cpu.P]);
                 SET_R_LOW(cpu.P, bkp8);
             }else{
                 cpu.R[cpu.P]++;
             }
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // BN4  Branch if EF4=0  if EF4=0, M(R(P))->R(P).0
         case 0x3F:
             cpu_testFlags();
             if(!cpu.EF4){
-                bkp8=RD_M(cpu.R[cpu.P]);
+                bkp8=RD_ARG(cpu.R[cpu.P]);
                 SET_R_LOW(cpu.P, bkp8);
             }else{
                 cpu.R[cpu.P]++;
             }
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 4, N = 0 ~ F, LDA
@@ -347,7 +355,10 @@ void cpu_execute(){
         case 0x4C: case 0x4D: case 0x4E: case 0x4F: 
             cpu.D=RD_M(cpu.R[cpu.N]);
             cpu.R[cpu.N]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
+#ifdef ELF_FUSE
+            if(fuse_enabled) fuse_store();
+#endif
         break;
         
         // I = 5, N = 0 ~ F, STR
@@ -361,7 +372,7 @@ void cpu_execute(){
         case 0x58: case 0x59: case 0x5A: case 0x5B: 
         case 0x5C: case 0x5D: case 0x5E: case 0x5F: 
             WR_M(cpu.R[cpu.N], cpu.D);
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 6, N = 0, IRX
@@ -371,7 +382,7 @@ void cpu_execute(){
         //   R(X)+1->R(X)
         case 0x60:
             cpu.R[cpu.X]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 6, N = 1, 2, 3, 4, 5, 6, 7, OUT
@@ -401,13 +412,13 @@ void cpu_execute(){
         case 0x64: case 0x65: case 0x66: case 0x67:
             cpu_output(RD_M(cpu.R[cpu.X]), cpu.N);
             cpu.R[cpu.X]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
                 
         // ESC
         // EXTENDED   1805 extended (68) instructions
         case 0x68:
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 6, N = 9, A, B, C, D, E, F, INP
@@ -432,7 +443,7 @@ void cpu_execute(){
             bus8 = cpu_input(cpu.N&0b111);
             WR_M(cpu.R[cpu.X], bus8);
             cpu.D=bus8;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 7, N = 0, RET
@@ -450,7 +461,7 @@ void cpu_execute(){
             cpu.P =  bkp16     & 0x0F;
             cpu.R[cpu.X]++;
             cpu.IE=1;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 7, N = 1, DIS
@@ -467,7 +478,7 @@ void cpu_execute(){
             cpu.P =  bkp16     & 0x0F;
             cpu.R[cpu.X]++;
             cpu.IE=0;        
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 7, N = 2, LDXA
@@ -481,7 +492,7 @@ void cpu_execute(){
         case 0x72:
             cpu.D=RD_M(cpu.R[cpu.X]);
             cpu.R[cpu.X]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 7, N = 3, STXD
@@ -493,8 +504,8 @@ void cpu_execute(){
         //   R(X)-1->R(X)
         case 0x73:
             WR_M(cpu.R[cpu.X], cpu.D);
-            cpu.R[cpu.X]++;
-            cpu.cycles+=2;
+            cpu.R[cpu.X]--;
+            ADD_CYCLES(2);
         break;
 
         // I = 7, N = 4, ADC
@@ -506,10 +517,8 @@ void cpu_execute(){
         // ADC  Add with carry  
         //   M(R(X))+D+DF->DF,D
         case 0x74:
-            sum16 = RD_M(cpu.R[cpu.X])+cpu.D+cpu.DF;
-            cpu.D  = (uint8_t)(sum16 & 0xFF);
-            cpu.DF = (sum16&0xFF00)?1:0;
-            cpu.cycles+=2;
+            alu_add(RD_M(cpu.R[cpu.X]), cpu.D, cpu.DF);
+            ADD_CYCLES(2);
         break;
         
         // I = 7, N = 5, SDB
@@ -521,10 +530,8 @@ void cpu_execute(){
         // SDB  Sub. D with borrow  
         //   M(R(X))-D-(NOT DF)->DF; D
         case 0x75:
-            sub16 = RD_M(cpu.R[cpu.X])-cpu.D-(!cpu.DF);
-            cpu.D  = (uint8_t)(sub16 & 0xFF);
-            cpu.DF = (sub16&0xFF00)?0:1; 
-            cpu.cycles+=2;
+            alu_sub(RD_M(cpu.R[cpu.X]), cpu.D, cpu.DF);
+            ADD_CYCLES(2);
         break;
         
         // I = 7, N = 6, SHRC (aka RSHR)
@@ -539,11 +546,8 @@ void cpu_execute(){
         //   lsb(D)->DF; 
         //   DF->msb(D)
         case 0x76:
-            lsb = cpu.D&0x01;
-            cpu.D>>=1;
-            cpu.D |= (cpu.DF?0b10000000:0b00000000);
-            cpu.DF = lsb;
-            cpu.cycles+=2;
+            alu_shr(cpu.DF);
+            ADD_CYCLES(2);
         break;
         
         // I = 7, N = 7, SMB
@@ -555,10 +559,8 @@ void cpu_execute(){
         // SMB  Sub. Mem. with borrow  
         //   D - M(R(X)) - (NOT DF)->DF, D
         case 0x77:
-            sub16 = cpu.D-RD_M(cpu.R[cpu.X])-(!cpu.DF);
-            cpu.D  = (uint8_t)(sub16 & 0xFF);
-            cpu.DF = (sub16&0xFF00)?0:1;
-            cpu.cycles+=2;
+            alu_sub(cpu.D, RD_M(cpu.R[cpu.X]), cpu.DF);
+            ADD_CYCLES(2);
         break;
         
         // I = 7, N = 8, SAV
@@ -570,7 +572,7 @@ void cpu_execute(){
         //   T->M(R(X))
         case 0x78:
             WR_M(cpu.R[cpu.X], cpu.T);
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 7, N = 9, MARK
@@ -590,7 +592,7 @@ void cpu_execute(){
             WR_M(cpu.R[2], cpu.T);
             cpu.X = cpu.P;
             cpu.R[2]--;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
 
         // I = 7, N = A, REQ
@@ -600,7 +602,7 @@ void cpu_execute(){
         case 0x7A:
             cpu.Q = 0;
             cpu_outputQ();
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 7, N = B, SEQ
@@ -611,7 +613,7 @@ void cpu_execute(){
         case 0x7B:
             cpu.Q = 1;
             cpu_outputQ();        
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 7, N = C, ADCI
@@ -624,11 +626,9 @@ void cpu_execute(){
         //   M(R(P)) + D + DF->DF,D; 
         //   R(P)+1->R(P)
         case 0x7C:
-            sum16 = RD_M(cpu.R[cpu.P])+cpu.D+cpu.DF;
-            cpu.D  = (uint8_t)(sum16 & 0xFF);
-            cpu.DF = (sum16&0xFF00)?1:0;
+            alu_add(RD_ARG(cpu.R[cpu.P]), cpu.D, cpu.DF);
             cpu.R[cpu.P]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 7, N = D, SDBI
@@ -639,11 +639,9 @@ void cpu_execute(){
         //   M(R(P)) - D - (Not DF) -> DF, D; 
         //   R(P) + 1 -> R(P)
         case 0x7D:
-            sub16 = RD_M(cpu.R[cpu.P])-cpu.D-(!cpu.DF);
-            cpu.D  = (uint8_t)(sub16 & 0xFF);
-            cpu.DF = (sub16&0xFF00)?0:1;
+            alu_sub(RD_ARG(cpu.R[cpu.P]), cpu.D, cpu.DF);
             cpu.R[cpu.P]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 7, N = E, SHLC (aka RSHL)
@@ -655,11 +653,8 @@ void cpu_execute(){
         //   msb(D)->DF; 
         //   DF->lsb(D)
         case 0x7E:
-            msb = cpu.D&0b10000000?1:0;
-            cpu.D<<=1;
-            cpu.D |= (cpu.DF?0b00000001:0b00000000);
-            cpu.DF = msb;
-            cpu.cycles+=2;
+            alu_shl(cpu.DF);
+            ADD_CYCLES(2);
         break;
         
         // I = 7, N = F, SMBI
@@ -670,11 +665,9 @@ void cpu_execute(){
         //   D-M(R(P))-(NOT DF) -> DF, D; 
         //   R(P) + 1 -> R(P)
         case 0x7F:
-            sub16 = cpu.D-RD_M(cpu.R[cpu.P])-(!cpu.DF);
-            cpu.D  = (uint8_t)(sub16 & 0xFF);
-            cpu.DF = (sub16&0xFF00)?0:1;
+            alu_sub(cpu.D, RD_ARG(cpu.R[cpu.P]), cpu.DF);
             cpu.R[cpu.P]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = 8, N = 0 ~ F, GLO
@@ -687,7 +680,10 @@ void cpu_execute(){
         case 0x88: case 0x89: case 0x8A: case 0x8B: 
         case 0x8C: case 0x8D: case 0x8E: case 0x8F: 
             cpu.D=GET_R_LOW(cpu.N);
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
+#ifdef ELF_FUSE
+            if(fuse_enabled) fuse_store();
+#endif
         break;
         
         // I = 9, N = 0 ~ F, GHI
@@ -700,7 +696,10 @@ void cpu_execute(){
         case 0x98: case 0x99: case 0x9A: case 0x9B: 
         case 0x9C: case 0x9D: case 0x9E: case 0x9F: 
             cpu.D=GET_R_HIGH(cpu.N);
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
+#ifdef ELF_FUSE
+            if(fuse_enabled) fuse_store();
+#endif
         break;
         
         // I = A, N = 0 ~ F, PLO
@@ -713,7 +712,7 @@ void cpu_execute(){
         case 0xA8: case 0xA9: case 0xAA: case 0xAB: 
         case 0xAC: case 0xAD: case 0xAE: case 0xAF: 
             SET_R_LOW(cpu.N, cpu.D);
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = B, N = 0 ~ F, PHI
@@ -725,7 +724,7 @@ void cpu_execute(){
         case 0xB8: case 0xB9: case 0xBA: case 0xBB: 
         case 0xBC: case 0xBD: case 0xBE: case 0xBF: 
             SET_R_HIGH(cpu.N, cpu.D);
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
      
         // I = C, N = 0, LBR
@@ -738,11 +737,9 @@ void cpu_execute(){
         //   M(R(P))  ->R(P).1; 
         //   M(R(P)+1)->R(P).0
         case 0xC0:
-            bkp8 = RD_M(cpu.R[cpu.P]);
-            SET_R_HIGH(cpu.P, bkp8);
-            bkp8 = RD_M(cpu.R[cpu.P]+1);
-            SET_R_LOW (cpu.P, bkp8);
-            cpu.cycles+=3;
+            bkp16 = RD_ARG(cpu.R[cpu.P]) << 8;
+            cpu.R[cpu.P] = bkp16 | RD_ARG(cpu.R[cpu.P]+1);
+            ADD_CYCLES(3);
         break;
 
         //  I = C, N = 1, LBQ
@@ -756,14 +753,12 @@ void cpu_execute(){
         //     R(P)+2->R(P)
         case 0xC1:
             if(cpu.Q){
-                bkp8 = RD_M(cpu.R[cpu.P]);
-                SET_R_HIGH(cpu.P, bkp8);
-                bkp8 = RD_M(cpu.R[cpu.P]+1);
-                SET_R_LOW (cpu.P, bkp8);
+                bkp16 = RD_ARG(cpu.R[cpu.P]) << 8;
+                cpu.R[cpu.P] = bkp16 | RD_ARG(cpu.R[cpu.P]+1);
             }else{
                 cpu.R[cpu.P]+=2;
             }
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = C, N = 2, LBZ
@@ -777,14 +772,12 @@ void cpu_execute(){
         //     R(P)+2->R(P)
         case 0xC2:
             if(cpu.D==0){
-                bkp8 = RD_M(cpu.R[cpu.P]);
-                SET_R_HIGH(cpu.P, bkp8);
-                bkp8 = RD_M(cpu.R[cpu.P]+1);
-                SET_R_LOW (cpu.P, bkp8);
+                bkp16 = RD_ARG(cpu.R[cpu.P]) << 8;
+                cpu.R[cpu.P] = bkp16 | RD_ARG(cpu.R[cpu.P]+1);
             }else{
                 cpu.R[cpu.P]+=2;
             }
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = C, N = 3, LBDF
@@ -798,14 +791,12 @@ void cpu_execute(){
         //     R(P)+2->R(P)
         case 0xC3:
             if(cpu.DF){
-                bkp8=RD_M(cpu.R[cpu.P]);
-                SET_R_HIGH(cpu.P, bkp8);
-                bkp8=RD_M(cpu.R[cpu.P]+1);
-                SET_R_LOW (cpu.P, bkp8);
+                bkp16 = RD_ARG(cpu.R[cpu.P]) << 8;
+                cpu.R[cpu.P] = bkp16 | RD_ARG(cpu.R[cpu.P]+1);
             }else{
                 cpu.R[cpu.P]+=2;
             }
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = C, N = 4, NOP
@@ -813,7 +804,7 @@ void cpu_execute(){
         // executes the instruction at the next address. 
         // NOP  No operation  Continue
         case 0xC4:
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = C, N = 5, LSNQ
@@ -830,7 +821,7 @@ void cpu_execute(){
             if(!cpu.Q){
                 cpu.R[cpu.P]+=2;
             }
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = C, N = 6, LSNZ
@@ -845,7 +836,7 @@ void cpu_execute(){
             if(cpu.D!=0){
                 cpu.R[cpu.P]+=2;
             }
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = C, N = 7, LSNF
@@ -860,7 +851,7 @@ void cpu_execute(){
             if(!cpu.DF){
                 cpu.R[cpu.P]+=2;
             }
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = C, N = 8, LSKP (aka NLBR)
@@ -872,7 +863,7 @@ void cpu_execute(){
         //   R(P)+2->R(P)
         case 0xC8:
             cpu.R[cpu.P]+=2;
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = C, N = 9, LBNQ
@@ -886,14 +877,12 @@ void cpu_execute(){
         //     R(P)+2->R(P)
         case 0xC9:
             if(!cpu.Q){
-                bkp8=RD_M(cpu.R[cpu.P]);
-                SET_R_HIGH(cpu.P, bkp8);
-                bkp8=RD_M(cpu.R[cpu.P]+1);
-                SET_R_LOW (cpu.P, bkp8);
+                bkp16 = RD_ARG(cpu.R[cpu.P]) << 8;
+                cpu.R[cpu.P] = bkp16 | RD_ARG(cpu.R[cpu.P]+1);
             }else{
                 cpu.R[cpu.P]+=2;
             }
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = C, N = A, LBNZ
@@ -908,14 +897,12 @@ void cpu_execute(){
         //     R(P)+2->R(P)
         case 0xCA:
             if(cpu.D!=0){
-                bkp8=RD_M(cpu.R[cpu.P]);
-                SET_R_HIGH(cpu.P, bkp8);
-                bkp8=RD_M(cpu.R[cpu.P]+1);
-                SET_R_LOW (cpu.P, bkp8);
+                bkp16 = RD_ARG(cpu.R[cpu.P]) << 8;
+                cpu.R[cpu.P] = bkp16 | RD_ARG(cpu.R[cpu.P]+1);
             }else{
                 cpu.R[cpu.P]+=2;
             }
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = C, N = B, LBNF
@@ -929,14 +916,12 @@ void cpu_execute(){
         //     R(P)+2->R(P)
         case 0xCB:
             if(!cpu.DF){
-                bkp8=RD_M(cpu.R[cpu.P]);
-                SET_R_HIGH(cpu.P, bkp8);
-                bkp8=RD_M(cpu.R[cpu.P]+1);
-                SET_R_LOW (cpu.P, bkp8);
+                bkp16 = RD_ARG(cpu.R[cpu.P]) << 8;
+                cpu.R[cpu.P] = bkp16 | RD_ARG(cpu.R[cpu.P]+1);
             }else{
                 cpu.R[cpu.P]+=2;
             }
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = C, N = C, LSIE
@@ -951,7 +936,7 @@ void cpu_execute(){
             if(!cpu.IE){
                 cpu.R[cpu.P]+=2;
             }
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = C, N = D, LSQ
@@ -966,7 +951,7 @@ void cpu_execute(){
             if(cpu.Q){
                 cpu.R[cpu.P]+=2;
             }        
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = C, N = E, LSZ
@@ -981,7 +966,7 @@ void cpu_execute(){
             if(cpu.D==0){
                 cpu.R[cpu.P]+=2;
             }
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = C, N = F, LSDF
@@ -996,7 +981,7 @@ void cpu_execute(){
             if(cpu.DF){
                 cpu.R[cpu.P]+=2;
             }
-            cpu.cycles+=3;
+            ADD_CYCLES(3);
         break;
         
         // I = D, N = 0 ~ F, SEP
@@ -1010,8 +995,17 @@ void cpu_execute(){
         case 0xD4: case 0xD5: case 0xD6: case 0xD7: 
         case 0xD8: case 0xD9: case 0xDA: case 0xDB: 
         case 0xDC: case 0xDD: case 0xDE: case 0xDF: 
+#ifdef ELF_SCRT
+            if(scrt_enabled && (cpu.N==4 || cpu.N==5) && scrt_execute()) break;
+#endif
+#ifdef ELF_TAPE
+            if(tape_turbo && tape_execute()) break;
+#endif
+#ifdef ELF_CHIP8
+            if(chip8_enabled && cpu.N==4 && chip8_execute()) break;
+#endif
             cpu.P=cpu.N;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = E, N = 0 ~ F, SEX
@@ -1024,7 +1018,10 @@ void cpu_execute(){
         case 0xE8: case 0xE9: case 0xEA: case 0xEB: 
         case 0xEC: case 0xED: case 0xEE: case 0xEF: 
             cpu.X = cpu.N;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
+#ifdef ELF_FUSE
+            if(fuse_enabled) fuse_out();
+#endif
         break;
         
         // I = F, N = 0, LDX
@@ -1036,7 +1033,7 @@ void cpu_execute(){
         //   M(R(X))->D
         case 0xF0:
             cpu.D = RD_M(cpu.R[cpu.X]);
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = F, N = 1, OR
@@ -1049,7 +1046,7 @@ void cpu_execute(){
         //   M(R(X)) or D->D
         case 0xF1:
             cpu.D |= RD_M(cpu.R[cpu.X]);
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = F, N = 2, AND
@@ -1060,7 +1057,7 @@ void cpu_execute(){
         //   M(R(X)) and D->D
         case 0xF2:
             cpu.D &= RD_M(cpu.R[cpu.X]);
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = F, N = 3, XOR
@@ -1071,7 +1068,7 @@ void cpu_execute(){
         //   M(R(X)) xor D->D
         case 0xF3:
             cpu.D ^= RD_M(cpu.R[cpu.X]);
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
 
         // I = F, N = 4, ADD
@@ -1081,10 +1078,8 @@ void cpu_execute(){
         // ADD  Add  
         //   M(R(X))+D->DF,D
         case 0xF4:
-            sum16 = RD_M(cpu.R[cpu.X])+cpu.D;
-            cpu.D  = (uint8_t)(sum16 & 0xFF);
-            cpu.DF = (sum16&0xFF00)?1:0;
-            cpu.cycles+=2;
+            alu_add(RD_M(cpu.R[cpu.X]), cpu.D, 0);
+            ADD_CYCLES(2);
         break;
         
         // I = F, N = 5, SD
@@ -1095,10 +1090,8 @@ void cpu_execute(){
         // SD  Subtract D  
         //   M(R(X))-D->DF,D
         case 0xF5:
-            sub16 = RD_M(cpu.R[cpu.X])-cpu.D;
-            cpu.D  = (uint8_t)(sub16 & 0xFF);
-            cpu.DF = (sub16&0xFF00)?0:1; 
-            cpu.cycles+=2;
+            alu_sub(RD_M(cpu.R[cpu.X]), cpu.D, 1);
+            ADD_CYCLES(2);
         break;
         
         // I = F, N = 6, SHR
@@ -1110,10 +1103,8 @@ void cpu_execute(){
         //   lsb(D)->DF; 
         //   0->msb(D)
         case 0xF6:
-            lsb = cpu.D&0x01;
-            cpu.D>>=1;
-            cpu.DF = lsb; 
-            cpu.cycles+=2;
+            alu_shr(0);
+            ADD_CYCLES(2);
         break;
         
         // I = F, N = 7, SM
@@ -1125,10 +1116,8 @@ void cpu_execute(){
         // SM  Subtract memory  
         //   D-M(R(X))->DF,D
         case 0xF7:
-            sub16  = cpu.D-RD_M(cpu.R[cpu.X]);
-            cpu.D  = (uint8_t)(sub16 & 0xFF);
-            cpu.DF = (sub16&0xFF00)?0:1; 
-            cpu.cycles+=2;
+            alu_sub(cpu.D, RD_M(cpu.R[cpu.X]), 1);
+            ADD_CYCLES(2);
         break;
         
         // I = F, N = 8, LDI
@@ -1140,9 +1129,12 @@ void cpu_execute(){
         //   M(R(P))->D; 
         //   R(P)+1->R(P)
         case 0xF8:
-            cpu.D = RD_M(cpu.R[cpu.P]);
+            cpu.D = RD_ARG(cpu.R[cpu.P]);
             cpu.R[cpu.P]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
+#ifdef ELF_FUSE
+            if(fuse_enabled) fuse_store();
+#endif
         break;
         
         // I = F, N = 9, ORI
@@ -1153,9 +1145,9 @@ void cpu_execute(){
         //   M(R(P)) or D->D; 
         //   R(P)+1->R(P)
         case 0xF9:
-            cpu.D = RD_M(cpu.R[cpu.P]) | cpu.D;
+            cpu.D = RD_ARG(cpu.R[cpu.P]) | cpu.D;
             cpu.R[cpu.P]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = F, N = A, ANI
@@ -1166,9 +1158,9 @@ void cpu_execute(){
         //   M(R(P)) and D->D; 
         //   R(P)+1->R(P)
         case 0xFA:
-            cpu.D = RD_M(cpu.R[cpu.P]) & cpu.D;
+            cpu.D = RD_ARG(cpu.R[cpu.P]) & cpu.D;
             cpu.R[cpu.P]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = F, N = B, XRI
@@ -1179,9 +1171,9 @@ void cpu_execute(){
         //   M(R(P)) xor D->D; 
         //   R(P)+1->R(P)
         case 0xFB:
-            cpu.D = RD_M(cpu.R[cpu.P]) ^ cpu.D;
+            cpu.D = RD_ARG(cpu.R[cpu.P]) ^ cpu.D;
             cpu.R[cpu.P]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = F, N = C, ADI
@@ -1192,11 +1184,9 @@ void cpu_execute(){
         //   M(R(P))+D->DF,D; 
         //   R(P)+1->R(P)
         case 0xFC:
-            sum16  = RD_M(cpu.R[cpu.P])+cpu.D;
-            cpu.D  = (uint8_t)(sum16&0xFF);
-            cpu.DF = (sum16&0xFF00)?1:0;
+            alu_add(RD_ARG(cpu.R[cpu.P]), cpu.D, 0);
             cpu.R[cpu.P]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = F, N = D, SDI
@@ -1208,11 +1198,9 @@ void cpu_execute(){
         //   M(R(P))-D->DF,D; 
         //   R(P)+1->R(P)
         case 0xFD:
-            sub16  = RD_M(cpu.R[cpu.P])-cpu.D;
-            cpu.D  = (uint8_t)(sub16 & 0xFF);
-            cpu.DF = (sub16&0xFF00)?0:1; 
+            alu_sub(RD_ARG(cpu.R[cpu.P]), cpu.D, 1);
             cpu.R[cpu.P]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
         
         // I = F, N = E, SHL
@@ -1224,10 +1212,8 @@ void cpu_execute(){
         //   msb(D)->DF; 
         //   0->lsb(D)
         case 0xFE:
-            msb = cpu.D&0b10000000?1:0;
-            cpu.D<<=1;
-            cpu.DF = msb;
-            cpu.cycles+=2;
+            alu_shl(0);
+            ADD_CYCLES(2);
         break;
         
         // I = F, N = F, SMI
@@ -1239,11 +1225,9 @@ void cpu_execute(){
         //   D-M(R(P))->DF,D; 
         //   R(P)+1->R(P)
         case 0xFF:
-            sub16  = cpu.D-RD_M(cpu.R[cpu.P]);
-            cpu.D  = (uint8_t)(sub16 & 0xFF);
-            cpu.DF = (sub16&0xFF00)?0:1; 
+            alu_sub(cpu.D, RD_ARG(cpu.R[cpu.P]), 1);
             cpu.R[cpu.P]++;
-            cpu.cycles+=2;
+            ADD_CYCLES(2);
         break;
     }
 
@@ -0,0 +1,138 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "mem.h"
+#include "meter.h"
+
+#ifdef ELF_EEPROM_MEM
+
+#define EE_NOLINE 0xFF
+
+uint8_t  eeCache[EE_LINES][EE_LINE];
+uint16_t eeTag[EE_LINES];
+uint8_t  eeDirty;
+uint16_t eeDirtySince[EE_LINES];
+
+uint8_t  eeFlushPolicy = EE_FLUSH_IDLE | EE_FLUSH_TIME | EE_FLUSH_MODE;
+uint16_t eeFlushMs     = EE_FLUSH_MS;
+
+uint32_t eeAccesses, eeMisses, eeWrites, eeFlushes;
+
+static uint8_t flushLine = EE_NOLINE;  // Line being written in the background
+static uint8_t flushPos;
+static uint8_t flushAll;
+
+// Writes the byte when it changed, returns 1 if it did
+static uint8_t ee_put(uint8_t l, uint8_t pos){
+    uint16_t addr = EE_MEM_BASE + (eeTag[l] << EE_LINE_BITS) + pos;
+    if(EEPROM.read(addr) == eeCache[l][pos]) return 0;
+    EEPROM.write(addr, eeCache[l][pos]);
+    eeWrites++;
+    return 1;
+}
+
+uint8_t *ee_miss(uint16_t offset){
+    uint8_t l = (offset >> EE_LINE_BITS) & (EE_LINES-1);
+
+    METER_BEGIN(MT_EEPROM);
+#ifdef ELF_BG_SAVE
+    save_hold();
+#endif
+    // The old line goes out now, EEPROM.write() waits for the previous one
+    if(l == flushLine){
+        for(; flushPos < EE_LINE; flushPos++) ee_put(l, flushPos);
+        flushLine = EE_NOLINE;
+    }
+    if(eeDirty & (1<<l)){
+        for(uint8_t i=0; i<EE_LINE; i++) ee_put(l, i);
+        eeDirty &= ~(1<<l);
+        eeFlushes++;
+    }
+
+    eeTag[l] = offset >> EE_LINE_BITS;
+    for(uint8_t i=0; i<EE_LINE; i++){
+        eeCache[l][i] = EEPROM.read(EE_MEM_BASE + (eeTag[l] << EE_LINE_BITS) + i);
+    }
+    eeMisses++;
+#ifdef ELF_BG_SAVE
+    save_release();
+#endif
+    METER_END();
+    return eeCache[l];
+}
+
+void ee_init(){
+    for(uint8_t l=0; l<EE_LINES; l++){
+        eeTag[l] = EE_NOTAG;
+    }
+    eeDirty   = 0;
+    flushLine = EE_NOLINE;
+}
+
+/**
+ * Picks a dirty line the policy lets go, then writes its changed
+ * bytes one per call while the EEPROM is ready. The line stays in
+ * the cache and is marked clean when its flush starts, a write
+ * meanwhile makes it dirty again.
+ */
+void ee_flush_step(uint8_t idle){
+#ifdef ELF_BG_SAVE
+    if(saveActive) return;
+#endif
+    if(!eeprom_is_ready()) return;
+
+    if(flushLine == EE_NOLINE){
+        if(!eeDirty){
+            flushAll = 0;
+            return;
+        }
+        uint16_t now = millis();
+        for(uint8_t l=0; l<EE_LINES; l++){
+            if(!(eeDirty & (1<<l))) continue;
+            if(flushAll || ((eeFlushPolicy & EE_FLUSH_IDLE) && idle) ||
+               ((eeFlushPolicy & EE_FLUSH_TIME) && (uint16_t)(now - eeDirtySince[l]) >= eeFlushMs)){
+                flushLine = l;
+                flushPos  = 0;
+                eeDirty  &= ~(1<<l);
+                eeFlushes++;
+                break;
+            }
+        }
+        if(flushLine == EE_NOLINE) return;
+    }
+
+    // Unchanged bytes cost a read, stop after the first real write
+    while(flushPos < EE_LINE && !ee_put(flushLine, flushPos)){
+        flushPos++;
+    }
+    if(flushPos < EE_LINE) flushPos++;
+    if(flushPos == EE_LINE) flushLine = EE_NOLINE;
+}
+
+void ee_mode_changed(){
+    if(eeFlushPolicy & EE_FLUSH_MODE) flushAll = 1;
+}
+
+void ee_report(){
+    Serial.print(F("eeprom "));
+    Serial.print(eeAccesses);
+    Serial.print(F(" accesses "));
+    Serial.print(eeAccesses ? 100.0 * (eeAccesses - eeMisses) / eeAccesses : 0.0, 1);
+    Serial.print(F("% hits "));
+    Serial.print(eeMisses);
+    Serial.print(F(" misses "));
+    Serial.print(eeFlushes);
+    Serial.print(F(" flushes "));
+    Serial.print(eeWrites);
+    Serial.println(F(" bytes written"));
+}
+
+#endif
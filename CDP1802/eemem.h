@@ -0,0 +1,106 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __EEMEM_H__
+#define __EEMEM_H__
+
+#include <stdint.h>
+
+/**
+ * EEPROM as live memory, ELF_EEPROM_MEM in mem.h
+ *
+ * The EEPROM after the saved image and the CPU snapshot shows up
+ * right above MEM_SIZE. Reads and writes go through a write back
+ * cache of EE_LINES lines; dirty lines reach the EEPROM one byte
+ * per pass of the sketch loop, only the bytes that changed are
+ * written. A line is also written, waiting for the EEPROM, when a
+ * miss evicts it.
+ *
+ * When dirty lines are flushed is set by eeFlushPolicy:
+ *   EE_FLUSH_IDLE  the CPU is not running, or waits in IDL
+ *   EE_FLUSH_TIME  a line is dirty for eeFlushMs
+ *   EE_FLUSH_MODE  every line, when the panel mode changes
+ */
+#define EE_MEM_BASE   (MEM_SIZE + 64)           // EEPROM address of the region
+#define EE_LINE_BITS  4
+#define EE_LINE       (1<<EE_LINE_BITS)
+#define EE_LINES      8                         // Power of two
+#define EE_MEM_SIZE   ((1024 - EE_MEM_BASE) & ~(EE_LINE-1))
+#define EE_NOTAG      0xFFFF
+
+#if MEM_SIZE + 64 >= 1024
+#error "No EEPROM left for ELF_EEPROM_MEM"
+#endif
+
+// Addresses backed by memory
+#define MEM_SPACE     (MEM_SIZE + EE_MEM_SIZE)
+
+#define EE_FLUSH_IDLE 0x01
+#define EE_FLUSH_TIME 0x02
+#define EE_FLUSH_MODE 0x04
+
+#ifndef EE_FLUSH_MS
+#define EE_FLUSH_MS   2000
+#endif
+
+extern uint8_t  eeCache[EE_LINES][EE_LINE];
+extern uint16_t eeTag[EE_LINES];                // offset>>EE_LINE_BITS
+extern uint8_t  eeDirty;                        // Bit per line
+extern uint16_t eeDirtySince[EE_LINES];         // millis() when it got dirty
+
+extern uint8_t  eeFlushPolicy;
+extern uint16_t eeFlushMs;
+
+// Statistics
+extern uint32_t eeAccesses, eeMisses, eeWrites, eeFlushes;
+
+// Brings the line of offset in, returns it
+uint8_t *ee_miss(uint16_t offset);
+
+static inline uint8_t ee_read(uint16_t offset){
+    uint8_t l = (offset >> EE_LINE_BITS) & (EE_LINES-1);
+    eeAccesses++;
+    if(eeTag[l] != offset >> EE_LINE_BITS){
+        return ee_miss(offset)[offset & (EE_LINE-1)];
+    }
+    return eeCache[l][offset & (EE_LINE-1)];
+}
+
+static inline void ee_write(uint16_t offset, uint8_t value){
+    uint8_t l = (offset >> EE_LINE_BITS) & (EE_LINES-1);
+    eeAccesses++;
+    if(eeTag[l] != offset >> EE_LINE_BITS){
+        ee_miss(offset);
+    }
+    eeCache[l][offset & (EE_LINE-1)] = value;
+    if(!(eeDirty & (1<<l))){
+        eeDirty |= 1<<l;
+        eeDirtySince[l] = millis();
+    }
+}
+
+// RAM below MEM_SIZE, the EEPROM above it, the rest mirrors the RAM
+static inline uint8_t ee_mem_rd(uint16_t addr){
+    if(addr < MEM_SIZE) return mem[addr];
+    if(addr - MEM_SIZE < EE_MEM_SIZE) return ee_read(addr - MEM_SIZE);
+    return mem[addr % MEM_SIZE];
+}
+
+static inline void ee_mem_wr(uint16_t addr, uint8_t value){
+    if(addr < MEM_SIZE)                       mem[addr] = value;
+    else if(addr - MEM_SIZE < EE_MEM_SIZE)    ee_write(addr - MEM_SIZE, value);
+    else                                      mem[addr % MEM_SIZE] = value;
+}
+
+void ee_init();
+void ee_flush_step(uint8_t idle);   // At most one EEPROM write
+void ee_mode_changed();
+void ee_report();                   // Statistics to Serial
+
+#endif
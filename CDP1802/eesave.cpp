@@ -0,0 +1,190 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "hw.h"
+#include "mem.h"
+
+#ifdef ELF_BG_SAVE
+
+#define SAVE_PAGES (SAVE_SIZE / SAVE_PAGE)
+
+#if SAVE_SIZE % SAVE_PAGE || SAVE_PAGES > 16
+#error "SAVE_SIZE must be up to 16 pages of SAVE_PAGE bytes"
+#endif
+#if SAVE_SLOTS < 2 || SAVE_SLOTS > 8
+#error "SAVE_SLOTS goes from 2 to 8"
+#endif
+
+volatile uint8_t saveActive;
+
+static uint8_t  slots[SAVE_SLOTS][SAVE_PAGE];
+static uint8_t  slotOf[SAVE_PAGES];
+static volatile uint16_t pending;      // Pages not written yet
+static volatile uint16_t copied;       // Pending pages held in a slot
+static volatile uint8_t  freeSlots;    // Bit per slot
+static volatile uint16_t done;         // Bytes written or skipped
+static uint16_t total;
+
+// Interrupt side: the run of bytes being written
+static const uint8_t *src;
+static uint16_t dst;
+static uint8_t  left;
+static int8_t   page = -1;             // Page of the run, -1 the snapshot
+static const uint8_t *snapSrc;
+static uint8_t  snapLen;
+
+/**
+ * Runs while EERIE is set and the EEPROM is ready. Unchanged bytes
+ * only cost a read, up to a page of them per call.
+ */
+ISR(EE_READY_vect){
+    for(uint8_t n=0; n<SAVE_PAGE; n++){
+        if(!left){
+            if(page >= 0){
+                pending   &= ~(1<<page);
+                copied    &= ~(1<<page);
+                freeSlots |= 1<<slotOf[page];
+                page = -1;
+            }
+            if(copied){
+                for(page=0; !(copied & (1<<page)); page++);
+                src  = slots[slotOf[page]];
+                dst  = (uint16_t)page << SAVE_PAGE_BITS;
+                left = SAVE_PAGE;
+            }else if(pending){
+                // save_step() turns it on again with the next page
+                EECR &= ~_BV(EERIE);
+                return;
+            }else if(snapLen){
+                src  = snapSrc;
+                dst  = SNAP_ADDR;
+                left = snapLen;
+                snapLen = 0;
+            }else{
+                EECR &= ~_BV(EERIE);
+                saveActive = 0;
+                return;
+            }
+        }
+        EEAR = dst++;
+        EECR |= _BV(EERE);
+        uint8_t value = *src++;
+        left--;
+        done++;
+        if(EEDR != value){
+            EEDR = value;
+            EECR |= _BV(EEMPE);
+            EECR |= _BV(EEPE);
+            return;
+        }
+    }
+}
+
+// Pages still to copy, read in one go
+static uint16_t uncopied(){
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t todo = pending & ~copied;
+    SREG = sreg;
+    return todo;
+}
+
+// Page p as it is now into a free slot, there must be one
+static void copy_page(uint8_t p){
+    uint8_t s, sreg;
+
+    sreg = SREG;
+    cli();
+    for(s=0; !(freeSlots & (1<<s)); s++);
+    freeSlots &= ~(1<<s);
+    SREG = sreg;
+
+    uint16_t base = (uint16_t)p << SAVE_PAGE_BITS;
+    for(uint8_t i=0; i<SAVE_PAGE; i++){
+        slots[s][i] = MEM_RD(base + i);
+    }
+    slotOf[p] = s;
+
+    sreg = SREG;
+    cli();
+    copied |= 1<<p;
+    EECR   |= _BV(EERIE);
+    SREG = sreg;
+}
+
+void save_start(const uint8_t *snap, uint8_t len){
+    if(saveActive) return;
+    pending   = (uint16_t)((1UL << SAVE_PAGES) - 1);
+    copied    = 0;
+    freeSlots = (1 << SAVE_SLOTS) - 1;
+    done      = 0;
+    total     = SAVE_SIZE + len;
+    page      = -1;
+    left      = 0;
+    snapSrc   = snap;
+    snapLen   = len;
+    saveActive = 1;
+    save_step();
+}
+
+// One slot stays free for the writes
+void save_step(){
+    if(!saveActive) return;
+    uint8_t  free = 0;
+    uint16_t todo = uncopied();
+    for(uint8_t s=0; s<SAVE_SLOTS; s++){
+        if(freeSlots & (1<<s)) free++;
+    }
+    if(!todo || free < 2) return;
+
+    uint8_t p;
+    for(p=0; !(todo & (1<<p)); p++);
+    copy_page(p);
+}
+
+void save_cow(uint16_t addr){
+    if(addr >= MEM_SPACE) addr %= MEM_SIZE;
+    if(addr >= SAVE_SIZE) return;
+
+    // Only the interrupt frees slots and it never drops a page before
+    // it is copied, so this waits for a slot and nothing else
+    uint8_t p = addr >> SAVE_PAGE_BITS;
+    while(uncopied() & (1<<p)){
+        if(freeSlots){
+            copy_page(p);
+            return;
+        }
+    }
+}
+
+uint8_t save_progress(){
+    if(!saveActive) return 100;
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t n = done;
+    SREG = sreg;
+    return (uint32_t)n * 100 / total;
+}
+
+uint8_t save_room(){
+    return !saveActive || freeSlots;
+}
+
+void save_hold(){
+    EECR &= ~_BV(EERIE);
+    while(!eeprom_is_ready());
+}
+
+void save_release(){
+    if(saveActive) EECR |= _BV(EERIE);
+}
+
+#endif
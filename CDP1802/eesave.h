@@ -0,0 +1,58 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __EESAVE_H__
+#define __EESAVE_H__
+
+#include <stdint.h>
+
+/**
+ * SAVE in the background, AVR only
+ *
+ * The EE_READY interrupt writes the memory image and the CPU
+ * snapshot one byte after the other while the panel and the CPU
+ * keep going; bytes the EEPROM already holds are skipped. The
+ * image is the memory at the moment SAVE started: the interrupt
+ * takes each page from a copy in one of SAVE_SLOTS buffers, the
+ * save task copies the next page ahead of it and the first write
+ * to a page not copied yet copies it before the byte changes.
+ * With every buffer taken that write waits for the interrupt to
+ * free one.
+ *
+ * Other EEPROM users hold the writer while they touch the EEPROM.
+ */
+#define SAVE_PAGE_BITS 5
+#define SAVE_PAGE      (1<<SAVE_PAGE_BITS)
+
+#ifndef SAVE_SLOTS
+#define SAVE_SLOTS     4
+#endif
+
+extern volatile uint8_t saveActive;
+
+// Starts writing the memory image, then snap[len], which must stay put
+void    save_start(const uint8_t *snap, uint8_t len);
+
+// Copies the next page ahead of the interrupt, call it every pass
+void    save_step();
+
+uint8_t save_progress();    // Percent written
+uint8_t save_room();        // A write now would not wait
+
+void    save_hold();        // Stops the writer, the EEPROM is idle on return
+void    save_release();
+
+// Before a memory write: the page goes to a buffer first
+void    save_cow(uint16_t addr);
+
+static inline void save_touch(uint16_t addr){
+    if(saveActive) save_cow(addr);
+}
+
+#endif
@@ -0,0 +1,63 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __FASTIO_H__
+#define __FASTIO_H__
+
+#include <Arduino.h>
+#include "hw.h"
+
+/**
+ * Arduino UNO pins bound at compile time
+ *
+ * digitalRead()/digitalWrite() look the port up on every call.
+ * With the pin as a template argument the port and the bit are
+ * constants, so write() is a single sbi/cbi and read() a single
+ * in/sbic.
+ *
+ *   D0-D7   PORTD 0-7
+ *   D8-D13  PORTB 0-5
+ *   A0-A5   PORTC 0-5  (pins 14-19)
+ */
+template<uint8_t PIN> struct FastPin{
+    static_assert(PIN < 20, "UNO pins are 0 to 19");
+
+    static const uint8_t BIT = PIN<8 ? PIN : PIN<14 ? PIN-8 : PIN-14;
+
+    static inline void high(){
+        if(PIN < 8)       PORTD |= _BV(BIT);
+        else if(PIN < 14) PORTB |= _BV(BIT);
+        else              PORTC |= _BV(BIT);
+    }
+
+    static inline void low(){
+        if(PIN < 8)       PORTD &= ~_BV(BIT);
+        else if(PIN < 14) PORTB &= ~_BV(BIT);
+        else              PORTC &= ~_BV(BIT);
+    }
+
+    static inline void write(uint8_t value){
+        if(value) high();
+        else      low();
+    }
+
+    static inline uint8_t read(){
+        if(PIN < 8)       return (PIND & _BV(BIT)) ? 1 : 0;
+        else if(PIN < 14) return (PINB & _BV(BIT)) ? 1 : 0;
+        else              return (PINC & _BV(BIT)) ? 1 : 0;
+    }
+};
+
+// Elf pins from hw.h
+typedef FastPin<_Q>       PinQ;
+typedef FastPin<_IN_DOWN> PinInDown;
+typedef FastPin<_IN_UP>   PinInUp;
+typedef FastPin<_EF2>     PinEF2;
+
+#endif
@@ -0,0 +1,16 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "cpu.h"
+#include "fuse.h"
+
+ELF_TLS uint8_t  fuse_enabled;
+ELF_TLS uint8_t  (*fuse_stop)(uint16_t addr);
+ELF_TLS uint64_t fuse_count;
@@ -0,0 +1,118 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __FUSE_H__
+#define __FUSE_H__
+
+#include "cpu.h"
+#include "mem.h"
+
+// Uncomment to run the fused handlers in run mode. Off on the board
+// until an AVR measurement shows a gain, the host builds pass -DELF_FUSE
+//#define ELF_FUSE
+
+// The coverage build has to see every fetch
+#ifdef ELF_COVERAGE
+#undef ELF_FUSE
+#endif
+
+/**
+ * Fused handlers
+ *
+ * The most frequent instruction pairs of the elfrun -DELF_PAIRS
+ * histograms run as one cpu_execute(): the case of the first
+ * instruction looks at the next opcode and runs it inline.
+ *
+ *   GLO, GHI, LDA, LDI   then PLO, PHI or STR
+ *   DEC                  then GLO or GHI, then BZ or BNZ
+ *   SEX                  then OUT
+ *
+ * Every instruction adds its own cycles and leaves I and N as its
+ * fetch would. A tail is not run from an address fuse_stop returns
+ * 1 for, so breakpoints stop on the same instruction.
+ */
+#define FUSE_TAIL 2     // Most instructions run after the first one
+
+// Runtime switch, set by the free running loops only: a single step
+// must stay one instruction
+extern ELF_TLS uint8_t fuse_enabled;
+
+// Breakpoint test of the running loop, NULL for none
+extern ELF_TLS uint8_t (*fuse_stop)(uint16_t addr);
+
+// Instructions run as tails, callers counting instructions add them
+extern ELF_TLS uint64_t fuse_count;
+
+#ifdef ELF_FUSE
+
+// Opcode at R(P)
+static inline uint8_t fuse_peek(){
+    return RD_OP(cpu.R[cpu.P]);
+}
+
+// The fetch of a tail, 0 when a breakpoint is there
+static inline uint8_t fuse_take(uint8_t op){
+    if(fuse_stop && fuse_stop(cpu.R[cpu.P])) return 0;
+    cpu.I = op>>4;
+    cpu.N = op&0x0F;
+    cpu.R[cpu.P]++;
+    fuse_count++;
+    return 1;
+}
+
+// PLO, PHI or STR of the D just loaded
+static inline void fuse_store(){
+    uint8_t op = fuse_peek();
+    uint8_t i  = op>>4;
+    if(i != 0xA && i != 0xB && i != 0x5) return;
+    if(!fuse_take(op)) return;
+    if(i == 0xA){
+        SET_R_LOW(cpu.N, cpu.D);
+    }else if(i == 0xB){
+        SET_R_HIGH(cpu.N, cpu.D);
+    }else{
+        WR_M(cpu.R[cpu.N], cpu.D);
+    }
+    ADD_CYCLES(2);
+}
+
+// GLO or GHI of the counter, then the loop branch
+static inline void fuse_dec(){
+    uint8_t op = fuse_peek();
+    uint8_t i  = op>>4;
+    if(i != 0x8 && i != 0x9) return;
+    if(!fuse_take(op)) return;
+    cpu.D = i == 0x8 ? GET_R_LOW(cpu.N) : GET_R_HIGH(cpu.N);
+    ADD_CYCLES(2);
+
+    op = fuse_peek();
+    if(op != 0x32 && op != 0x3A) return;
+    if(!fuse_take(op)) return;
+    if((cpu.D == 0) == (op == 0x32)){
+        uint8_t to = RD_ARG(cpu.R[cpu.P]);
+        SET_R_LOW(cpu.P, to);
+    }else{
+        cpu.R[cpu.P]++;
+    }
+    ADD_CYCLES(2);
+}
+
+// OUT through the R(X) just set
+static inline void fuse_out(){
+    uint8_t op = fuse_peek();
+    if(op < 0x61 || op > 0x67) return;
+    if(!fuse_take(op)) return;
+    cpu_output(RD_M(cpu.R[cpu.X]), cpu.N);
+    cpu.R[cpu.X]++;
+    ADD_CYCLES(2);
+}
+
+#endif
+
+#endif
@@ -16,6 +16,22 @@
 #include "hw.h"
 #include "cpu.h"
 #include "mem.h"
+#include "io.h"
+#include "bench.h"
+#include "tasks.h"
+#include "fastio.h"
+#include "proto.h"
+#include "journal.h"
+#include "block.h"
+#include "fuse.h"
+#include "meter.h"
+#include "sample.h"
+
+// Instructions run by every pass of the cpu task in RUN mode
+#define CPU_QUANTUM 64
+
+// A button must be stable this long
+#define DEBOUNCE_MS 10
 
 LiquidCrystal_I2C  lcd(0x27, 2, 1, 0, 4, 5, 6, 7 );
 Adafruit_MCP23017 mcp;
@@ -23,16 +39,74 @@ Adafruit_MCP23017 mcp;
 uint8_t lastMode = 0b0000;
 uint8_t lastSwitchs ;
 
-void hw_init(){
-    Serial.begin(115200);
-
-    // Pin mode for control switches
-    DDRC = 0b00000000;
-
-    // THE Q pin :)
-    pinMode(_Q,  OUTPUT);
-    digitalWrite(_Q, LOW);
-
+uint8_t inLevel;
+uint8_t inReleased;
+uint8_t hwReady;
+static uint8_t  inRaw;
+static uint8_t  inPressed;
+static uint32_t inSince;
+
+static uint8_t  panelMode;
+static uint8_t  displayDirty;
+static uint8_t  resetLeds;
+static uint8_t  testLeds;
+static uint32_t lastStep;
+static int16_t  savePos = -1;
+static uint8_t  saveShown = 0xFF;   // Percent on the LCD
+static uint32_t bootMicros;
+
+// Snapshot as written to EEPROM: magic, packed CPU, checksum
+static uint8_t  snap[sizeof(CDP1802Packed) + 2];
+
+static void snapshot();
+static uint8_t saveBusy();
+static void taskBoot();
+static void taskInput();
+static void taskPanel();
+static void taskCpu();
+static void taskSave();
+static void taskDisplay();
+static void taskSerial();
+#ifdef ELF_EEPROM_MEM
+static void taskEEFlush();
+#endif
+#ifdef ELF_METER
+static void taskMeter();
+#endif
+
+// Task names stay in flash
+static const char nameInput[]   PROGMEM = "input";
+static const char namePanel[]   PROGMEM = "panel";
+static const char nameCpu[]     PROGMEM = "cpu";
+static const char nameBoot[]    PROGMEM = "boot";
+static const char nameSave[]    PROGMEM = "save";
+static const char nameDisplay[] PROGMEM = "display";
+static const char nameSerial[]  PROGMEM = "serial";
+#ifdef ELF_EEPROM_MEM
+static const char nameEEFlush[] PROGMEM = "eeflush";
+#endif
+#ifdef ELF_METER
+static const char nameMeter[]   PROGMEM = "meter";
+#endif
+
+static Task tasks[] = {
+    { nameInput,   taskInput,    2 },
+    { namePanel,   taskPanel,    0 },
+    { nameCpu,     taskCpu,      0 },
+    { nameBoot,    taskBoot,     0 },
+    { nameSave,    taskSave,     0 },
+    { nameDisplay, taskDisplay, 50 },
+    { nameSerial,  taskSerial,   0 },
+#ifdef ELF_EEPROM_MEM
+    { nameEEFlush, taskEEFlush,  0 },
+#endif
+#ifdef ELF_METER
+    { nameMeter,   taskMeter, 1000 },
+#endif
+};
+#define TASKS (sizeof(tasks)/sizeof(tasks[0]))
+
+static void hw_initMCP(){
     // MCP 23017 switchs & leds
     mcp.begin(0);
     for(int i=0; i< 8; i++){
@@ -40,61 +114,93 @@ void hw_init(){
         mcp.pullUp (i, HIGH);
         mcp.pinMode(i+8, OUTPUT);
     }
+}
 
-    // Display
+static void hw_initLCD(){
     lcd.begin (16, 2); 
     lcd.setBacklightPin(3, POSITIVE);
     lcd.setBacklight(1);
+}
+
+static void hw_splash(){
     lcd.clear();
     lcd.setCursor(4, 0);
     lcd.print("ELFuino");
     lcd.setCursor(1, 1);
     lcd.print("diegocueva.com");
+}
+
+void hw_init(){
+    Serial.begin(115200);
+#ifdef ELF_METER
+    meter_init();
+#endif
+#ifdef ELF_EEPROM_MEM
+    ee_init();
+#endif
+
+    // Pin mode for control switches
+    DDRC = 0b00000000;
+
+    // THE Q pin :)
+    pinMode(_Q,  OUTPUT);
+    digitalWrite(_Q, LOW);
+
+#ifndef ELF_FAST_BOOT
+    hw_initMCP();
+    hw_initLCD();
+    hw_splash();
+    hwReady = 1;
 
     writeHWLeds(0xFFFF);
     delay(700);
     writeHWLeds(0x0000);
     delay(300);
+#endif
 }
 
-uint8_t readPin(uint8_t pin){
-  uint8_t value = digitalRead(pin);
-  for(;;){
-    delay(1);
-    if(digitalRead(pin) != value){
-      value = digitalRead(pin);
-    }else{
-      return value;
-    }
-  }
-}
-
+/**
+ * Next IN press seen by the input task, 1 down, 2 up, 0 none
+ */
 uint8_t readIN(){
-    if( readIN_DOWN() || readIN_UP() ){
-        delay(10);
-        if(readIN_DOWN() ) return 1;
-        if(readIN_UP() ) return 2;
+    if(inPressed & IN_DOWN_BIT){
+        inPressed &= ~IN_DOWN_BIT;
+        return 1;
+    }
+    if(inPressed & IN_UP_BIT){
+        inPressed &= ~IN_UP_BIT;
+        return 2;
     }
     return 0;
 }
 
 uint8_t readSwitches(){
+  METER_BEGIN(MT_DEBOUNCE);
   uint8_t value = readHWSwitches();
   for(;;){
     if(readHWSwitches() != value){
       value = readHWSwitches();
     }else{
-      return value;
+      break;
     }
   }
+  METER_END();
+  return value;
 }
 
 uint8_t readHWSwitches(){
-    return mcp.readGPIO(0);
+    if(!hwReady) return 0;
+    METER_BEGIN(MT_I2C);
+    uint8_t value = mcp.readGPIO(0);
+    METER_END();
+    return value;
 }
 
 void writeHWLeds(uint16_t data){
+  if(!hwReady) return;
+  METER_BEGIN(MT_I2C);
   mcp.writeGPIOAB(data<<8);
+  METER_END();
 }
 
 uint8_t readControlSwitches(){
@@ -110,8 +216,10 @@ void displaySwitches(uint8_t switchs){
     sprintf(buff, "%02X",
         switchs
     );
+    METER_BEGIN(MT_LCD);
     lcd.setCursor(14,0);
     lcd.print(buff);
+    METER_END();
 }
 
 void displayCpuInfo(){
@@ -123,18 +231,31 @@ void displayCpuInfo(){
         cpu.N,
         cpu.D
     );
+    METER_BEGIN(MT_LCD);
     lcd.setCursor(0,0);
     lcd.print(buff);
+    METER_END();
 }
 
 void displayEditInfo(uint8_t mode){
     char buff[20];
     uint16_t addr = cpu.R[cpu.P];
-    sprintf(buff, "%04X:%02X%c    ",
-        cpu.R[cpu.P],
-        RD_M(cpu.R[cpu.P]),
-        mode&0b0100?'w':'r'
-    );
+    METER_BEGIN(MT_LCD);
+    if(mode == ST_EDR_BLOCK){
+        // Branches patched by the last insert or delete, ! if some could not be
+        sprintf(buff, "%04X:%02X b%02X%c",
+            cpu.R[cpu.P],
+            RD_M(cpu.R[cpu.P]),
+            blkPatched & 0xFF,
+            blkBroken ? '!' : ' '
+        );
+    }else{
+        sprintf(buff, "%04X:%02X%c    ",
+            cpu.R[cpu.P],
+            RD_M(cpu.R[cpu.P]),
+            mode&0b0100?'w':'r'
+        );
+    }
     lcd.setCursor(0,0);
     lcd.print(buff);
 
@@ -155,24 +276,280 @@ void displayEditInfo(uint8_t mode){
     );
     lcd.setCursor(12, 1);
     lcd.print(buff);
+    METER_END();
 }
 
 void loopSystem(){
-    uint8_t mode = readControlSwitches();
-    if(mode == ST_RN_RUN){
-        cpu_execute();
-    }else{
-        doOperateMode(mode);
+    sched_run(tasks, TASKS);
+}
+
+/******************************** TASKS ***************************/
+
+// Fast boot brings the panel up one device per pass
+static void taskBoot(){
+    static uint8_t step;
+
+    if(hwReady) return;
+    switch(step++){
+        case 0: hw_initMCP(); break;
+        case 1: hw_initLCD(); break;
+        case 2:
+            hw_splash();
+            hwReady = 1;
+            cpu_showOutput();
+        break;
+    }
+}
+
+// Debounce the IN buttons without waiting
+static void taskInput(){
+    METER_BEGIN(MT_DEBOUNCE);
+    uint8_t  raw = (PinInDown::read() ? IN_DOWN_BIT : 0) |
+                   (PinInUp::read()   ? IN_UP_BIT   : 0);
+    uint32_t now = millis();
+
+    if(raw != inRaw){
+        inRaw   = raw;
+        inSince = now;
+    }else if(raw != inLevel && now - inSince >= DEBOUNCE_MS){
+        inPressed  |=  raw & ~inLevel;
+        inReleased |= ~raw &  inLevel;
+        inLevel     =  raw;
+    }
+    METER_END();
+}
+
+static void taskPanel(){
+    panelMode = readControlSwitches();
+    if(!hwReady) return;
+    if(panelMode != lastMode){
+        inPressed = 0;
+#ifdef ELF_EEPROM_MEM
+        ee_mode_changed();
+#endif
+    }
+    if(panelMode != ST_RN_RUN){
+        doOperateMode(panelMode);
     }
-    lastMode = mode;
+    lastMode = panelMode;
 }
 
+// RUN, and the PAUSE, SLOW and FAST debug modes
+static void taskCpu(){
+    if(!bootMicros && panelMode == ST_RN_RUN){
+        bootMicros = micros();
+    }
+#ifdef ELF_PROTO
+    // A STEP or RUN from the serial port owns the CPU
+    if(proto_running()){
+        proto_execute();
+        displayDirty = 1;
+        return;
+    }
+#endif
+    switch(panelMode){
+        case ST_RN_RUN:{
+            uint8_t i;
+            METER_BEGIN(MT_CPU);
+            fuse_enabled = 1;
+#ifdef ELF_SAMPLE
+            sampleCpu    = 1;
+#endif
+            for(i=0; i<CPU_QUANTUM && !cpuIdle; i++){
+#ifdef ELF_BG_SAVE
+                // A write with no page buffer free would wait for SAVE
+                if(!save_room()) break;
+#endif
+                cpu_execute();
+            }
+            fuse_enabled = 0;
+#ifdef ELF_SAMPLE
+            sampleCpu    = 0;
+#endif
+            // Keep checking IN while IDL waits
+            if(cpuIdle){
+                cpu_execute();
+            }
+            METER_END();
+            METER_COUNT(i);
+        }
+        break;
+
+        // IN down steps forward, IN up steps back
+        case ST_RN_PAUSE:
+            switch(readIN()){
+                case 1:
+                    journal_step();
+                    displayDirty = 1;
+                break;
+                case 2:
+                    if(journal_back()){
+                        displayDirty = 1;
+                    }
+                break;
+            }
+        break;
+
+        // IN up holds the clock
+        case ST_RN_SLOW:
+        case ST_RN_FAST:
+            if(!readIN_UP() && millis() - lastStep >= (panelMode==ST_RN_SLOW ? 1000 : 100)){
+                lastStep = millis();
+                cpu_execute();
+                displayDirty = 1;
+            }
+        break;
+    }
+}
+
+static uint8_t saveBusy(){
+#ifdef ELF_BG_SAVE
+    return saveActive;
+#else
+    return savePos >= 0;
+#endif
+}
+
+// SAVE progress while the panel shows SAVE
+static void saveShow(){
+    static uint8_t wasBusy;
+    char buff[16];
+    uint8_t pct;
+
+    if(!saveBusy()){
+        if(wasBusy && panelMode == ST_OP_SAVE && hwReady){
+            METER_BEGIN(MT_LCD);
+            lcd.setCursor(1, 1);
+            lcd.print("* DONE *    ");
+            METER_END();
+        }
+        wasBusy = 0;
+        return;
+    }
+    wasBusy = 1;
+#ifdef ELF_BG_SAVE
+    pct = save_progress();
+#else
+    pct = (uint32_t)savePos * 100 / (SNAP_ADDR + sizeof(snap));
+#endif
+    if(pct != saveShown && panelMode == ST_OP_SAVE && hwReady){
+        saveShown = pct;
+        sprintf(buff, "Wait... %3u%%", pct);
+        METER_BEGIN(MT_LCD);
+        lcd.setCursor(1, 1);
+        lcd.print(buff);
+        METER_END();
+    }
+}
+
+#ifdef ELF_BG_SAVE
+// The EEPROM interrupt writes, this keeps the next page copied
+static void taskSave(){
+    METER_BEGIN(MT_EEPROM);
+    save_step();
+    METER_END();
+    saveShow();
+}
+#else
+// One byte per pass, only when the EEPROM is ready for it
+static void taskSave(){
+    if(savePos >= 0 && eeprom_is_ready()){
+        METER_BEGIN(MT_EEPROM);
+        if(savePos < SAVE_SIZE){
+            EEPROM.update(savePos, RD_M(savePos));
+        }else{
+            EEPROM.update(savePos, snap[savePos - SNAP_ADDR]);
+        }
+        if(++savePos >= SNAP_ADDR + (int16_t)sizeof(snap)){
+            savePos = -1;
+        }
+        METER_END();
+    }
+    saveShow();
+}
+#endif
+
+static void taskDisplay(){
+    if(displayDirty && hwReady){
+        displayDirty = 0;
+        displayCpuInfo();
+    }
+}
+
+#ifdef ELF_EEPROM_MEM
+// Dirty EEPROM lines, idle unless RUN executes
+static void taskEEFlush(){
+    METER_BEGIN(MT_EEPROM);
+    ee_flush_step(panelMode != ST_RN_RUN || cpuIdle);
+    METER_END();
+}
+#endif
+
+#ifdef ELF_METER
+// Instructions per second on the row the program leaves free in RUN
+static void taskMeter(){
+    char buff[20];
+    uint32_t ips = meter_ips();
+
+    if(panelMode != ST_RN_RUN || !hwReady) return;
+#ifdef ELF_PROTO
+    if(proto_running()) return;
+#endif
+    sprintf(buff, "%8lu ips    ", ips);
+    METER_BEGIN(MT_LCD);
+    lcd.setCursor(0, 0);
+    lcd.print(buff);
+    METER_END();
+}
+#endif
+
+// Debug protocol frames, a T outside a frame prints the time report,
+// an M the meter one
+static void taskSerial(){
+#ifdef ELF_PROTO
+    while(!proto_busy() && Serial.available()){
+        uint8_t c = Serial.read();
+        if(proto_feed(c)) continue;
+#else
+    while(Serial.available()){
+        uint8_t c = Serial.read();
+#endif
+        if(c == 'T'){
+            Serial.print(F("first instruction "));
+            Serial.print(bootMicros);
+            Serial.print(F(" us\n"));
+            sched_report(tasks, TASKS);
+#ifdef ELF_EEPROM_MEM
+            ee_report();
+#endif
+        }
+#ifdef ELF_METER
+        if(c == 'M'){
+            meter_report();
+        }
+#endif
+    }
+#ifdef ELF_PROTO
+    proto_flush();
+#endif
+}
+
+#ifdef ELF_PROTO
+uint16_t proto_room(){
+    return Serial.availableForWrite();
+}
+
+void proto_send(uint8_t c){
+    Serial.write(c);
+}
+#endif
+
 void doOperateMode(uint8_t mode){
     char buff[20], rin;
     uint8_t switchs = readHWSwitches();
 
     // OPERATIONS
-    if(mode==ST_OP_RESET || mode==ST_OP_HWTEST || mode==ST_OP_SAVE || mode==ST_OP_LOAD){ 
+    if(mode==ST_OP_RESET || mode==ST_OP_HWTEST || mode==ST_OP_SAVE || mode==ST_OP_LOAD || mode==ST_OP_BENCH){ 
         switch(mode){
             // Reset
             case ST_OP_RESET:
@@ -181,6 +558,10 @@ void doOperateMode(uint8_t mode){
                 }else if( rin=readIN() ){
                     doReset(rin==1);
                 }
+                if(resetLeds && !readIN_DOWN() && !readIN_UP()){
+                    writeHWLeds(0x0000);
+                    resetLeds = 0;
+                }
             break;
     
             // HARDWARE TEST
@@ -203,12 +584,10 @@ void doOperateMode(uint8_t mode){
                     writeHWLeds((uint16_t)switchs);
                     lastSwitchs = switchs;                    
                 }
-                digitalWrite(_Q, digitalRead(_IN_DOWN));
-                if(digitalRead(_IN_UP)){
-                    writeHWLeds(0xFFFF);
-                    delay(10);
-                    while(digitalRead(_IN_UP));
-                    writeHWLeds((uint16_t)switchs);
+                PinQ::write(PinInDown::read());
+                if(readIN_UP() != testLeds){
+                    testLeds = readIN_UP();
+                    writeHWLeds(testLeds ? 0xFFFF : (uint16_t)switchs);
                 }
             break;        
 
@@ -217,14 +596,10 @@ void doOperateMode(uint8_t mode){
                     lcd.clear();
                     lcd.setCursor(1, 0);
                     lcd.print("**** SAVE ****");
+                    saveShown = 0xFF;
                 }
-                if( readIN()==1 ){
-                    lcd.setCursor(1, 1);
-                    lcd.print("Wait...");
+                if( readIN()==1 && !saveBusy() ){
                     saveEEPROM();
-                    lcd.setCursor(1, 1);
-                    lcd.print("* DONE *");                    
-                    while( readIN_DOWN() || readIN_UP() );
                 }                
             break;
 
@@ -235,12 +610,36 @@ void doOperateMode(uint8_t mode){
                     lcd.print("Load program");
                 }
                 if( readIN()==1 ){
-                    loadEEPROM();
                     lcd.setCursor(1, 1);
-                    lcd.print("DONE");                    
-                    while( readIN_DOWN() || readIN_UP() );
+                    if(saveBusy()){
+                        lcd.print("SAVE busy");
+                    }else{
+                        loadEEPROM();
+                        lcd.print("DONE     ");
+                    }
                 }                
             break;            
+
+            case ST_OP_BENCH:
+                if(lastMode != mode){
+                    lcd.clear();
+                    lcd.setCursor(1, 0);
+#ifdef ELF_BENCH
+                    lcd.print("Opcode bench");
+#else
+                    lcd.print("No bench build");
+#endif
+                }
+#ifdef ELF_BENCH
+                if( readIN()==1 ){
+                    lcd.setCursor(1, 1);
+                    lcd.print("Wait...");
+                    bench_run();
+                    lcd.setCursor(1, 1);
+                    lcd.print("DONE   ");
+                }
+#endif
+            break;
         }
     }else if(mode & ST_EDR_READ){ // IS EDIT MODE ?
         // EDIT OPERATION WHEN PUSH
@@ -256,33 +655,7 @@ void doOperateMode(uint8_t mode){
             writeHWLeds((uint16_t)RD_M(cpu.R[cpu.P]));
         }        
     }else if(mode & ST_RN_RUN){ // IS RUN MODE ?
-        // RUN DEBUG MODE
-        switch(mode){
-            case ST_RN_PAUSE:
-              if(readIN_DOWN()){
-                  delay(10);
-                  if( readIN_DOWN()){
-                      cpu_execute();
-                      displayCpuInfo();
-                      while( readIN_DOWN());
-                  }
-              }                
-            break;
-            
-            case ST_RN_SLOW:
-              cpu_execute();
-              displayCpuInfo();
-              while(readIN_UP());
-              delay(1000); 
-            break;
-                  
-            case ST_RN_FAST:
-              cpu_execute();
-              displayCpuInfo();
-              while( readIN_UP() );
-              delay(100);              
-            break;
-        }
+        // RUN DEBUG MODE, the steps are done by the cpu task
         if(lastMode != mode){
             displayCpuInfo();
             displaySwitches(switchs);
@@ -299,6 +672,8 @@ void doOperateMode(uint8_t mode){
 /******************************** EDITING OPERATION ***************************/
 void doEditingOperation(uint8_t mode, uint8_t isDown){
     uint8_t value = readHWSwitches();
+
+    journal_clear();
         
     switch(mode){
       // READ MODE
@@ -345,53 +720,95 @@ void doEditingOperation(uint8_t mode, uint8_t isDown){
           }
       break;
 
-      /*
-      case ST_EDW_INSERT:
-          for(uint16_t i=MEM_SIZE-2; i>cpu.R[cpu.P]; i--){
-              value = RD_M(i);
-              WR_M(i+1, value);
-          }
-          WR_M(cpu.R[cpu.P], 0x00);
-      break;
-      
-      case ST_EDW_DELETE:
-          for(uint16_t i=cpu.R[cpu.P];i<MEM_SIZE-2; i++){
-            value = RD_M(i+1);
-            WR_M(i, value);
+      // Switches 0-6 count the bytes, 0 is one; switch 7 set leaves the branches alone
+      case ST_EDR_BLOCK:
+          if(isDown){
+              blk_insert(cpu.R[cpu.P], (value & 0x7F) ? (value & 0x7F) : 1, MEM_SIZE, 0, !(value & 0x80));
+          }else{
+              blk_delete(cpu.R[cpu.P], (value & 0x7F) ? (value & 0x7F) : 1, MEM_SIZE, 0, !(value & 0x80));
           }
-          WR_M(cpu.R[cpu.P], 0x00);
+          writeHWLeds((uint16_t)RD_M(cpu.R[cpu.P]));
       break;
-      */
     }
     displayEditInfo(mode);     
-    while( readIN_DOWN() || readIN_UP() );
 }
 
 /******************************** RESET ***************************/
 void doReset(uint8_t isDown){
     cpu_reset();
+    journal_clear();
+    cpuIdle = 0;
     lcd.clear();  
     writeHWLeds(0xFFFF);
     if(!isDown){
-        for(int i=0; i<MEM_SIZE; i++){
+        for(uint32_t i=0; i<MEM_SIZE; i++){
             WR_M(i, 0x00);
         }
     }
-    while( readIN_DOWN() || readIN_UP() );
-    writeHWLeds(0x0000);
+    // Turned off by the panel when IN is released
+    resetLeds = 1;
 }
 
 /******************************** LOAD EEPROM ***************************/
 void loadEEPROM(){
-    for(int i=0; i<MEM_SIZE || i <1024; i++){
+    journal_clear();
+    METER_BEGIN(MT_EEPROM);
+    for(int i=0; i<SAVE_SIZE; i++){
         WR_M(i, EEPROM.read(i));
     }  
+    METER_END();
 }
 
 /******************************** SAVE EEPROM ***************************/
+// Starts SAVE of the machine as it is now, the save task finishes it
 void saveEEPROM(){
-    for(int i=0; i<MEM_SIZE || i <1024; i++){
-        EEPROM.write(i, RD_M(i));
-    }  
+    snapshot();
+#ifdef ELF_BG_SAVE
+    save_start(snap, sizeof(snap));
+#else
+    savePos = 0;
+#endif
+}
+
+/******************************** SNAPSHOT ***************************/
+#if SAVE_SIZE > 1024 - 64
+#error "No room for the CPU snapshot after the memory image in EEPROM"
+#endif
+
+#ifdef ELF_EEPROM_MEM
+static_assert(sizeof(snap) <= EE_MEM_BASE - SNAP_ADDR, "CPU snapshot runs into the EEPROM memory");
+#endif
+
+static uint8_t snapSum(const uint8_t *p, uint8_t n){
+    uint8_t sum = 0;
+    for(uint8_t i=0; i<n; i++){
+        sum += p[i];
+    }
+    return sum;
+}
+
+// Fill snap[] from the CPU
+static void snapshot(){
+    snap[0] = SNAP_MAGIC;
+    cpu_pack((CDP1802Packed *)&snap[1]);
+    snap[sizeof(snap)-1] = snapSum(snap, sizeof(snap)-1);
+}
+
+/**
+ * Restore the CPU saved with the memory image,
+ * returns 0 if there is no valid snapshot
+ */
+uint8_t loadSnapshot(){
+    METER_BEGIN(MT_EEPROM);
+    for(uint8_t i=0; i<sizeof(snap); i++){
+        snap[i] = EEPROM.read(SNAP_ADDR + i);
+    }
+    METER_END();
+    if(snap[0] != SNAP_MAGIC || snap[sizeof(snap)-1] != snapSum(snap, sizeof(snap)-1)){
+        return 0;
+    }
+    cpu_unpack((const CDP1802Packed *)&snap[1]);
+    journal_clear();
+    return 1;
 }
 
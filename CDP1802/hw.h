@@ -10,6 +10,8 @@
 #ifndef __HW_H__
 #define __HW_H__
 
+#include "mem.h"
+
 
 // IN push button
 #define _IN_DOWN 10
@@ -18,14 +20,49 @@
 // Q pin mapped to microcontroller PIN
 #define _Q    13
 
-#define readIN_DOWN() readPin(_IN_DOWN)
-#define readIN_UP()   readPin(_IN_UP)
+// EF2 input pin
+#define _EF2  12
+
+// 23LC512 SPI SRAM (ELF_SPI_SRAM in mem.h), bit banged because
+// the hardware SPI pins 11-13 are IN up, EF2 and Q
+#define _SRAM_CS    2
+#define _SRAM_SCK   3
+#define _SRAM_MOSI  4
+#define _SRAM_MISO  5
+
+// Uncomment to resume the machine saved with SAVE at power on.
+// The splash is skipped, LCD and MCP23017 come up while it runs.
+// The serial T report prints micros() at the first RUN instruction.
+//#define ELF_FAST_BOOT
+
+// Memory kept in the EEPROM by SAVE and LOAD, the low 512 bytes
+// when the address space is on the SPI SRAM
+#if MEM_SIZE > 512
+#define SAVE_SIZE  512
+#else
+#define SAVE_SIZE  MEM_SIZE
+#endif
+
+// EEPROM snapshot of the CPU, right after the memory image
+#define SNAP_ADDR  SAVE_SIZE
+#define SNAP_MAGIC 0xE1
+
+// IN buttons debounced by the input task
+#define IN_DOWN_BIT 0b01
+#define IN_UP_BIT   0b10
+
+extern uint8_t inLevel;     // Buttons held now
+extern uint8_t inReleased;  // Buttons released since last asked
+extern uint8_t hwReady;     // LCD and MCP23017 are up
+
+#define readIN_DOWN() (inLevel & IN_DOWN_BIT)
+#define readIN_UP()   (inLevel & IN_UP_BIT)
 
 void    hw_init();
 uint8_t readSwitches();
 uint8_t readHWSwitches();
 uint8_t readControlSwitches();
-uint8_t readPin(uint8_t pin);
+uint8_t readIN();
 void    loopSystem();
 void    dump(char * line);
 void    displayCpuInfo();
@@ -35,10 +72,11 @@ void    writeHWLeds(uint16_t data);
 void    doReset(uint8_t isDown);
 void    loadEEPROM();
 void    saveEEPROM();
+uint8_t loadSnapshot();
 
 // OPTIONS
 #define  ST_OP_RESET  0b0000
-#define  ST_OP_NONE2  0b0010
+#define  ST_OP_BENCH  0b0010 // Opcode benchmark, needs ELF_BENCH
 #define  ST_OP_HWTEST 0b0110
 #define  ST_OP_NONE4  0b0100
 
@@ -56,7 +94,7 @@ void    saveEEPROM();
 #define  ST_EDR_READ  0b1000
 #define  ST_EDR_PAGE  0b1001
 #define  ST_SET_ADDR  0b1010
-#define  ST_OP_NONEB  0b1011 // Insert delete
+#define  ST_EDR_BLOCK 0b1011 // IN down inserts, IN up deletes
 
 // EDIT WRITE
 #define  ST_EDW_WRITE 0b1100
@@ -12,6 +12,8 @@
 #include "cpu.h"
 #include "hw.h"
 #include "io.h"
+#include "fastio.h"
+#include "meter.h"
 
 extern LiquidCrystal_I2C  lcd;
 
@@ -22,41 +24,79 @@ extern LiquidCrystal_I2C  lcd;
   of Q is also available as a microprocessor output.
  */
 void cpu_outputQ(){
-     digitalWrite(_Q, cpu.Q);
+     PinQ::write(cpu.Q);
 }
 
+uint8_t ioStub;
+
 uint8_t cpu_input (uint8_t Nlines){
     char buff[20];
     sprintf(buff, "IN Nl=%d\n", Nlines); 
     //Serial.print(buff);
+    if(ioStub) return 0;
     return readHWSwitches();
 }
 
+// Last OUT made before the LCD was up
+static uint8_t outData, outLines, outPending;
+
 void cpu_output(uint8_t data, uint8_t Nlines){
     char buff[20];
     sprintf(buff, "OUT %02X Nl=%d\n", data, Nlines); 
     //Serial.print(buff);
-    lcd.setCursor(Nlines*2, 1);
+    if(ioStub) return;
+    if(!hwReady){
+        outData    = data;
+        outLines   = Nlines;
+        outPending = 1;
+        return;
+    }
     sprintf(buff, "%02X", data);
+    METER_BEGIN(MT_LCD);
+    lcd.setCursor(Nlines*2, 1);
     lcd.print(buff);
+    METER_END();
 
     writeHWLeds((uint16_t)data);
 }
 
+/**
+ * Draws the OUT held back while booting, once hwReady is set
+ */
+void cpu_showOutput(){
+    if(outPending){
+        outPending = 0;
+        cpu_output(outData, outLines);
+    }
+}
+
 /**
  * Read External flags
  *  The external signals must be negated
  */
 void cpu_testFlags(){
     cpu.EF1 = 1;
-    cpu.EF2 = readPin(12);
-    cpu.EF3 = readPin(11);
+    cpu.EF2 = PinEF2::read();
+    cpu.EF3 = readIN_UP() ? 1 : 0;
     cpu.EF4 = readIN_DOWN();
 }
 
+/**
+ * IDL waits for IN to be pushed and released. It never blocks,
+ * R(P) goes back to the IDL so it runs again until then.
+ */
+uint8_t cpuIdle;
+
 void cpu_idle(){
-    while(!readIN_DOWN());
-    delay(10);
-    while(readIN_DOWN());  
+    if(!cpuIdle){
+        cpuIdle = 1;
+        inReleased &= ~IN_DOWN_BIT;
+    }
+    if(inReleased & IN_DOWN_BIT){
+        inReleased &= ~IN_DOWN_BIT;
+        cpuIdle = 0;
+    }else{
+        cpu.R[cpu.P]--;
+    }
 }
 
@@ -7,13 +7,20 @@
  *    diegocueva@gmail.com
  *    www.diegocueva.com
  ********************************************************/
-#ifndef __HW_H__
-#define __HW_H__
+#ifndef __IO_H__
+#define __IO_H__
 
 void    cpu_testFlags();
 void    cpu_output(uint8_t data, uint8_t Nlines);
 uint8_t cpu_input (uint8_t Nlines);
 void    cpu_outputQ();
 void    cpu_idle();
+void    cpu_showOutput();
+
+// Set while IDL waits for IN
+extern uint8_t cpuIdle;
+
+// Set by the opcode benchmark, OUT and INP leave the I2C devices alone
+extern uint8_t ioStub;
 
 #endif 
@@ -0,0 +1,273 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "cpu.h"
+#include "mem.h"
+#include "io.h"
+#include "scrt.h"
+#include "tape.h"
+#include "chip8.h"
+#include "fuse.h"
+#include "journal.h"
+
+#ifdef ELF_JOURNAL
+
+/**
+ * Record of a step, the length is at both ends so the ring can
+ * drop from the front and undo from the back:
+ *
+ *   len  entry entry ..  cycles lo hi  len
+ *
+ * Entries are a tag and the old value:
+ *   1kkkrrrr           R(r) moved forward by k (1-7)
+ *   0001rrrr lo hi     R(r)
+ *   J_D .. J_EF old    byte fields
+ *   J_MEM lo hi old    memory byte
+ */
+#define J_D     0x01
+#define J_DF    0x02
+#define J_X     0x03
+#define J_P     0x04
+#define J_IN    0x05    // I high nybble, N low nybble
+#define J_T     0x06
+#define J_IE    0x07
+#define J_Q     0x08
+#define J_EF    0x09    // EF1 bit 0 .. EF4 bit 3
+#define J_MEM   0x0A
+#define J_REG   0x10
+#define J_INC   0x80
+
+#define REC_MAX (16*3 + 9*2 + 4 + 4)
+
+static uint8_t  ring[JOURNAL_SIZE];
+static uint32_t head, used, steps;
+static uint64_t lastCycles;
+
+static uint8_t ring_at(uint32_t i){
+    return ring[(head + i) % JOURNAL_SIZE];
+}
+
+void journal_clear(){
+    head = used = steps = 0;
+}
+
+uint32_t journal_depth(){
+    return lastCycles == GET_CYCLES() ? steps : 0;
+}
+
+/**
+ * Address the next instruction may write, the byte is saved
+ * before it runs
+ */
+static uint8_t write_target(uint16_t *a){
+    uint8_t op = MEM_RD(cpu.R[cpu.P]);
+
+    if((op>>4) == 0x5){                         // STR
+        *a = cpu.R[op&0x0F];
+        return 1;
+    }
+    if((op>0x68 && op<=0x6F) || op==0x73 || op==0x78){  // INP, STXD, SAV
+        *a = cpu.R[cpu.X];
+        return 1;
+    }
+    if(op == 0x79){                             // MARK
+        *a = cpu.R[2];
+        return 1;
+    }
+    return 0;
+}
+
+#endif
+
+/**
+ * One instruction through the interpreter. SCRT, tape, CHIP-8 and
+ * fused pairs run many at once and write where write_target()
+ * does not look, they are off for the step.
+ */
+static void execute_one(){
+#ifdef ELF_SCRT
+    uint8_t scrt = scrt_enabled;
+    scrt_enabled = 0;
+#endif
+#ifdef ELF_TAPE
+    uint8_t turbo = tape_turbo;
+    tape_turbo = 0;
+#endif
+#ifdef ELF_CHIP8
+    uint8_t chip8 = chip8_enabled;
+    chip8_enabled = 0;
+#endif
+#ifdef ELF_FUSE
+    uint8_t fuse = fuse_enabled;
+    fuse_enabled = 0;
+#endif
+
+    cpu_execute();
+
+#ifdef ELF_SCRT
+    scrt_enabled = scrt;
+#endif
+#ifdef ELF_TAPE
+    tape_turbo = turbo;
+#endif
+#ifdef ELF_CHIP8
+    chip8_enabled = chip8;
+#endif
+#ifdef ELF_FUSE
+    fuse_enabled = fuse;
+#endif
+}
+
+#ifdef ELF_JOURNAL
+
+static uint8_t efs(const CDP1802 *c){
+    return c->EF1 | c->EF2<<1 | c->EF3<<2 | c->EF4<<3;
+}
+
+static uint8_t *put_byte(uint8_t *p, uint8_t tag, uint8_t now, uint8_t old){
+    if(now != old){
+        *p++ = tag;
+        *p++ = old;
+    }
+    return p;
+}
+
+void journal_step(){
+    static CDP1802 before;
+    uint8_t  rec[REC_MAX];
+    uint8_t *p = rec + 1;
+    uint16_t addr = 0;
+
+    if(lastCycles != GET_CYCLES()){
+        journal_clear();
+    }
+
+    before = cpu;
+    uint8_t write = write_target(&addr);
+    uint8_t old   = MEM_RD(addr);
+
+    execute_one();
+
+    for(uint8_t r=0; r<16; r++){
+        uint16_t delta = cpu.R[r] - before.R[r];
+        if(!delta) continue;
+        if(delta < 8){
+            *p++ = J_INC | delta<<4 | r;
+        }else{
+            *p++ = J_REG | r;
+            *p++ = (uint8_t)before.R[r];
+            *p++ = before.R[r]>>8;
+        }
+    }
+    p = put_byte(p, J_D,  cpu.D,  before.D);
+    p = put_byte(p, J_DF, cpu.DF, before.DF);
+    p = put_byte(p, J_X,  cpu.X,  before.X);
+    p = put_byte(p, J_P,  cpu.P,  before.P);
+    p = put_byte(p, J_IN, cpu.I<<4 | cpu.N, before.I<<4 | before.N);
+    p = put_byte(p, J_T,  cpu.T,  before.T);
+    p = put_byte(p, J_IE, cpu.IE, before.IE);
+    p = put_byte(p, J_Q,  cpu.Q,  before.Q);
+    p = put_byte(p, J_EF, efs(&cpu), efs(&before));
+    if(write && MEM_RD(addr) != old){
+        *p++ = J_MEM;
+        *p++ = (uint8_t)addr;
+        *p++ = addr>>8;
+        *p++ = old;
+    }
+    uint16_t cycles = GET_CYCLES() - GET_CYCLES_OF(before);
+    *p++ = (uint8_t)cycles;
+    *p++ = cycles>>8;
+    *p++ = 0;
+    uint8_t len = p - rec;
+    rec[0] = rec[len-1] = len;
+
+    // Room for the record, dropping the oldest steps
+    while(JOURNAL_SIZE - used < len && used){
+        uint8_t l = ring_at(0);
+        head  = (head + l) % JOURNAL_SIZE;
+        used -= l;
+        steps--;
+    }
+    for(uint8_t i=0; i<len; i++){
+        ring[(head + used + i) % JOURNAL_SIZE] = rec[i];
+    }
+    used += len;
+    steps++;
+    lastCycles = GET_CYCLES();
+}
+
+uint8_t journal_back(){
+    uint8_t rec[REC_MAX];
+
+    if(!journal_depth()) return 0;
+
+    uint8_t  len   = ring_at(used - 1);
+    uint32_t start = used - len;
+    for(uint8_t i=0; i<len; i++){
+        rec[i] = ring_at(start + i);
+    }
+
+    for(uint8_t i=1; i<len-3; ){
+        uint8_t tag = rec[i++];
+        if(tag & J_INC){
+            cpu.R[tag&0x0F] -= (tag>>4) & 0x07;
+        }else if(tag & J_REG){
+            cpu.R[tag&0x0F] = rec[i] | (uint16_t)rec[i+1]<<8;
+            i += 2;
+        }else if(tag == J_MEM){
+            MEM_WR(rec[i] | (uint16_t)rec[i+1]<<8, rec[i+2]);
+            i += 3;
+        }else{
+            uint8_t v = rec[i++];
+            switch(tag){
+                case J_D:  cpu.D  = v; break;
+                case J_DF: cpu.DF = v; break;
+                case J_X:  cpu.X  = v; break;
+                case J_P:  cpu.P  = v; break;
+                case J_IN: cpu.I  = v>>4; cpu.N = v&0x0F; break;
+                case J_T:  cpu.T  = v; break;
+                case J_IE: cpu.IE = v; break;
+                case J_Q:  cpu.Q  = v; cpu_outputQ(); break;
+                case J_EF:
+                    cpu.EF1 = v&1;      cpu.EF2 = (v>>1)&1;
+                    cpu.EF3 = (v>>2)&1; cpu.EF4 = (v>>3)&1;
+                break;
+            }
+        }
+    }
+
+    uint64_t cycles = GET_CYCLES() - (rec[len-3] | (uint16_t)rec[len-2]<<8);
+    SET_CYCLES(cycles);
+
+    used = start;
+    steps--;
+    lastCycles = cycles;
+    return 1;
+}
+
+#else
+
+// Without the journal a step is one instruction and nothing is kept
+void journal_step(){
+    execute_one();
+}
+
+uint8_t journal_back(){
+    return 0;
+}
+
+void journal_clear(){
+}
+
+uint32_t journal_depth(){
+    return 0;
+}
+
+#endif
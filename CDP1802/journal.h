@@ -0,0 +1,45 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __JOURNAL_H__
+#define __JOURNAL_H__
+
+#include <stdint.h>
+
+// Uncomment to keep the undo journal, JOURNAL_SIZE bytes of RAM and
+// a copy of the CPU. Without it steps still run one instruction and
+// nothing steps back. The host builds pass -DELF_JOURNAL
+//#define ELF_JOURNAL
+
+/**
+ * Undo journal for single steps
+ *
+ * Every journaled step keeps only what it changed: the old value
+ * of each register and flag that moved and of each memory byte it
+ * wrote, so a step costs a few bytes. The oldest steps are dropped
+ * when the ring is full. Anything run outside the journal changes
+ * the cycle count and makes the history start again, and writes to
+ * memory or registers from outside the CPU call journal_clear().
+ *
+ * Output already sent to the LEDs or LCD is not undone.
+ */
+#ifndef JOURNAL_SIZE
+#define JOURNAL_SIZE 128    // Bytes, the host can afford megabytes
+#endif
+
+// Executes one instruction and records it
+void     journal_step();
+
+// Undoes the last recorded step, 0 when there is none or no journal
+uint8_t  journal_back();
+
+void     journal_clear();
+uint32_t journal_depth();   // Steps that can be undone
+
+#endif
@@ -10,7 +10,19 @@
 #include <Arduino.h>
 #include "mem.h"
 
-uint8_t  mem[MEM_SIZE];
+#if defined(MEM_MAPPED)
+ELF_TLS uint8_t *mem;
+#elif !defined(ELF_SPI_SRAM)
+ELF_TLS uint8_t  mem[MEM_SIZE];
+#endif
+
+static const char hexDigits[] PROGMEM = "0123456789ABCDEF";
+
+static char *hex8(char *p, uint8_t v){
+    *p++ = pgm_read_byte(&hexDigits[v>>4]);
+    *p++ = pgm_read_byte(&hexDigits[v&0x0F]);
+    return p;
+}
 
 /**
  * Show memory in next format:
@@ -22,22 +34,24 @@ uint8_t  mem[MEM_SIZE];
  *   @arg line must be at least 80 bytes
  */
 void dumpMem(uint16_t daddr, char * line){
-    char hex[11];
-    sprintf(line, " %04X : ", daddr);
+    char *p = line;
+
+    *p++ = ' ';
+    p = hex8(p, daddr>>8);
+    p = hex8(p, daddr);
+    *p++ = ' ';
+    *p++ = ':';
+    *p++ = ' ';
     for(int i=0; i<16; i++){
-        uint8_t d = RD_M(daddr+i);
-        sprintf(hex,"%02X ", d);
-        strcat(line, hex);
+        p = hex8(p, MEM_RD((uint16_t)(daddr+i)));
+        *p++ = ' ';
     }
-    strcat(line, " - ");
+    *p++ = ' ';
+    *p++ = '-';
+    *p++ = ' ';
     for(int i=0; i<16; i++){
-        char c = RD_M(daddr+i);
-        if(32 <= c && c <= 126){
-            sprintf(hex,"%c", c);
-            strcat(line, hex);
-        }else{
-            strcat(line, ".");
-        }
+        char c = MEM_RD((uint16_t)(daddr+i));
+        *p++ = (32 <= c && c <= 126) ? c : '.';
     }
+    *p = 0;
 }
-
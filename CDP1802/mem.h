@@ -10,13 +10,99 @@
 #ifndef __MEM_H__
 #define __MEM_H__
 
-// Memory
+// Uncomment to keep the whole 64 KB address space on a 23LC512
+// SPI SRAM behind a small cache (sram.h)
+//#define ELF_SPI_SRAM
+
+// Uncomment to use the EEPROM left after the saved image as live
+// memory right above MEM_SIZE (eemem.h)
+//#define ELF_EEPROM_MEM
+
+#if defined(ELF_SPI_SRAM) && defined(ELF_EEPROM_MEM)
+#error "ELF_SPI_SRAM and ELF_EEPROM_MEM do not go together"
+#endif
+
+// Memory, the host build raises it to the full 64 KB address space
+#ifdef ELF_SPI_SRAM
+#undef  MEM_SIZE
+#define MEM_SIZE 65536UL
+#endif
+#ifndef MEM_SIZE
 #define MEM_SIZE 512
-extern uint8_t mem[];
+#endif
+
+#ifndef ELF_TLS
+#define ELF_TLS
+#endif
+
+/**
+ * Plain access, MEM_RD/MEM_WR never show in the coverage. The
+ * emulator uses the macros below, RD_OP for opcode fetches and
+ * RD_ARG for immediate and branch operands.
+ */
+#if defined(ELF_SPI_SRAM)
+#include "sram.h"
+#define MEM_RD(x)   sram_read(x)
+#define MEM_STORE(x,y) sram_write((x),(y))
+#else
+
+// MEM_MAPPED makes the memory a pointer, the host maps an image
+// file there (host/memmap.h)
+#ifdef MEM_MAPPED
+extern ELF_TLS uint8_t *mem;
+#else
+extern ELF_TLS uint8_t mem[];
+#endif
+
+#if defined(ELF_EEPROM_MEM)
+#include "eemem.h"
+#define MEM_RD(x)   ee_mem_rd(x)
+#define MEM_STORE(x,y) ee_mem_wr((x),(y))
+#else
+#define MEM_RD(x)   (mem[(x)%MEM_SIZE])
+
+// A build can route every write through a function of its own,
+// MEM_WRITE_HOOK names it and it must store the byte itself.
+#ifdef MEM_WRITE_HOOK
+void MEM_WRITE_HOOK(uint16_t addr, uint8_t value);
+#define MEM_STORE(x,y) MEM_WRITE_HOOK((x),(y))
+#else
+#define MEM_STORE(x,y) (mem[(x)%MEM_SIZE]=y)
+#endif
+#endif
+#endif
+
+// Addresses backed by memory, the rest of the 64 KB mirror them
+#ifndef MEM_SPACE
+#define MEM_SPACE MEM_SIZE
+#endif
+
+// On the AVR SAVE writes the EEPROM from its interrupt while the
+// machine runs, a write first copies the page SAVE still needs
+#if defined(__AVR__) && !defined(ELF_BG_SAVE)
+#define ELF_BG_SAVE
+#endif
+
+#ifdef ELF_BG_SAVE
+#include "eesave.h"
+#define MEM_WR(x,y) (save_touch(x), MEM_STORE((x),(y)))
+#else
+#define MEM_WR(x,y) MEM_STORE((x),(y))
+#endif
 
 // Memory access macros
-#define RD_M(x)   (mem[(x)%MEM_SIZE])
-#define WR_M(x,y) (mem[(x)%MEM_SIZE]=y)
+#ifdef ELF_COVERAGE
+#include "coverage.h"
+#define RD_M(x)     cov_read((x), COV_READ)
+#define RD_OP(x)    cov_read((x), COV_OP)
+#define RD_ARG(x)   cov_read((x), COV_ARG)
+#define WR_M(x,y)   cov_write((x), (y))
+#else
+#define RD_M(x)     MEM_RD(x)
+#define RD_OP(x)    MEM_RD(x)
+#define RD_ARG(x)   MEM_RD(x)
+#define WR_M(x,y)   MEM_WR((x),(y))
+#endif
 
 void dumpMem(uint16_t daddr, char * line);
 
@@ -0,0 +1,123 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "meter.h"
+#include "fuse.h"
+#include "scrt.h"
+
+#ifdef ELF_METER
+
+static const char *const meterNames[MT_COUNT] = {
+    "other", "cpu", "i2c", "lcd", "eeprom", "debounce"
+};
+
+static volatile uint16_t meterOverflows;
+static uint8_t  meterBucket;
+static uint32_t meterLast;          // Clock of the last switch
+static uint64_t meterClocks[MT_COUNT];
+
+static uint32_t meterInstr;         // Instructions run, wraps
+static uint32_t meterExtra;         // Fused and SCRT ones already counted
+static uint32_t reportInstr;
+
+ISR(TIMER1_OVF_vect){
+    meterOverflows++;
+}
+
+/**
+ * Clocks since meter_init, wraps every 268 s at 16 MHz
+ */
+static uint32_t meter_now(){
+    uint8_t  sreg = SREG;
+    cli();
+    uint16_t low  = TCNT1;
+    uint32_t high = meterOverflows;
+    if((TIFR1 & _BV(TOV1)) && low < 0x8000) high++;
+    SREG = sreg;
+    return (high<<16) | low;
+}
+
+static uint32_t meter_extra(){
+    return fuse_count + scrt_calls*SCRT_CALL_INSTR + scrt_returns*SCRT_RETURN_INSTR;
+}
+
+void meter_init(){
+    uint8_t sreg = SREG;
+    cli();
+    // Normal mode, no prescaler
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10);
+    TCNT1  = 0;
+    TIFR1  = _BV(TOV1);
+    TIMSK1 = _BV(TOIE1);
+    meterOverflows = 0;
+    SREG = sreg;
+
+    meterLast   = 0;
+    meterBucket = MT_OTHER;
+    meterExtra  = meter_extra();
+}
+
+uint8_t meter_switch(uint8_t bucket){
+    uint32_t now = meter_now();
+    uint8_t  was = meterBucket;
+    meterClocks[was] += now - meterLast;
+    meterLast   = now;
+    meterBucket = bucket;
+    return was;
+}
+
+void meter_count(uint8_t n){
+    uint32_t extra = meter_extra();
+    meterInstr += n + (extra - meterExtra);
+    meterExtra  = extra;
+}
+
+uint32_t meter_ips(){
+    static uint32_t lastClock, lastInstr;
+    uint32_t now    = meter_now();
+    uint32_t clocks = now - lastClock;
+    uint32_t n      = meterInstr - lastInstr;
+    lastClock = now;
+    lastInstr = meterInstr;
+    return clocks ? (uint64_t)n * F_CPU / clocks : 0;
+}
+
+/**
+ *   bucket         ms   %
+ */
+void meter_report(){
+    char     buff[48];
+    uint64_t total = 0;
+    uint32_t n = meterInstr - reportInstr;
+
+    meter_switch(meterBucket);
+    for(uint8_t b=0; b<MT_COUNT; b++){
+        total += meterClocks[b];
+    }
+    sprintf(buff, "meter %lu ms, %lu instructions, %lu ips\n",
+        (uint32_t)(total / (F_CPU/1000)), n,
+        (uint32_t)(total ? (uint64_t)n * F_CPU / total : 0)
+    );
+    Serial.print(buff);
+    Serial.print("bucket         ms   %\n");
+    for(uint8_t b=0; b<MT_COUNT; b++){
+        sprintf(buff, "%-8s %8lu %3u\n",
+            meterNames[b],
+            (uint32_t)(meterClocks[b] / (F_CPU/1000)),
+            (unsigned)(total ? meterClocks[b]*100/total : 0)
+        );
+        Serial.print(buff);
+        meterClocks[b] = 0;
+    }
+    reportInstr = meterInstr;
+}
+
+#endif
@@ -0,0 +1,68 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __METER_H__
+#define __METER_H__
+
+#include "bench.h"
+
+// Uncomment to time the firmware with Timer1: a serial M prints where
+// the clocks went and the LCD shows the instructions per second in RUN
+//#define ELF_METER
+
+#if defined(ELF_METER) && defined(ELF_BENCH)
+#error "ELF_METER and ELF_BENCH both need Timer1"
+#endif
+
+/**
+ * Firmware meter
+ *
+ * Timer1 counts CPU clocks and every clock goes to the bucket that
+ * was current when it elapsed. METER_BEGIN switches to a bucket up to
+ * the METER_END of the same block, a nested one takes its own clocks:
+ * the MCP23017 reads of IN during RUN are I2C, not CPU.
+ *
+ *   cpu        cpu_execute() of the RUN loop
+ *   i2c        MCP23017 switches and LEDs
+ *   lcd        LCD writes, I2C too
+ *   eeprom     SAVE, LOAD and the EEPROM memory cache
+ *   debounce   IN buttons and switch reads waiting to be stable
+ *   other      Everything else, the serial port and the scheduler
+ */
+enum { MT_OTHER, MT_CPU, MT_I2C, MT_LCD, MT_EEPROM, MT_DEBOUNCE, MT_COUNT };
+
+#ifdef ELF_METER
+
+void     meter_init();
+
+// Charges the clocks so far to the current bucket, returns it
+uint8_t  meter_switch(uint8_t bucket);
+
+// n instructions run by cpu_execute(), the fused and SCRT ones are added
+void     meter_count(uint8_t n);
+
+// Instructions per second since the last call
+uint32_t meter_ips();
+
+// Prints the buckets since the last report and starts counting again
+void     meter_report();
+
+#define METER_BEGIN(b)  uint8_t meterWas = meter_switch(b)
+#define METER_END()     meter_switch(meterWas)
+#define METER_COUNT(n)  meter_count(n)
+
+#else
+
+#define METER_BEGIN(b)
+#define METER_END()
+#define METER_COUNT(n)
+
+#endif
+
+#endif
@@ -0,0 +1,423 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "cpu.h"
+#include "mem.h"
+#include "proto.h"
+#include "journal.h"
+#include "block.h"
+#include "fuse.h"
+#include "sample.h"
+
+#ifdef ELF_PROTO
+
+// Instructions run by every proto_execute() call
+#define PROTO_QUANTUM 64
+
+// Receiver states
+#define RX_SYNC    0
+#define RX_CMD     1
+#define RX_LEN     2
+#define RX_DATA    3
+#define RX_CRC     4
+#define RX_DONE    5
+
+static uint8_t  rxState;
+static uint8_t  rxCmd, rxLen, rxPos, rxCrc, rxStatus;
+static uint8_t  rxBuf[PROTO_MAX];
+
+static uint8_t  txBuf[PROTO_MAX + 5];
+static uint8_t  txLen, txPos;
+
+static uint8_t  running;
+static uint8_t  started;        // No instruction run yet
+static uint8_t  hasUntil;
+static uint16_t until;
+static uint16_t stepsLeft;      // 0 while RUN
+static uint8_t  stopReason = 0xFF;
+
+static uint16_t breaks[PROTO_BREAKS];
+static uint8_t  nbreaks;
+
+/**************************** Reply ****************************/
+static uint8_t *reply_begin(uint8_t cmd, uint8_t status){
+    txBuf[0] = PROTO_REPLY;
+    txBuf[1] = cmd;
+    txBuf[2] = status;
+    txBuf[3] = 0;
+    return &txBuf[4];
+}
+
+static void reply_end(uint8_t len){
+    uint8_t crc = 0;
+    txBuf[3] = len;
+    for(uint8_t i=1; i<4+len; i++){
+        crc = proto_crc(crc, txBuf[i]);
+    }
+    txBuf[4+len] = crc;
+    txLen = 5 + len;
+    txPos = 0;
+}
+
+static void put_regs(uint8_t *p){
+    CDP1802Packed r;
+    cpu_pack(&r);
+    for(uint8_t i=0; i<16; i++){
+        *p++ = (uint8_t)r.R[i];
+        *p++ = r.R[i]>>8;
+    }
+    *p++ = r.D;
+    *p++ = r.T;
+    *p++ = r.XP;
+    *p++ = r.IN;
+    *p++ = r.flags;
+    for(uint8_t i=0; i<8; i++){
+        *p++ = (uint8_t)(r.cycles>>(i*8));
+    }
+}
+
+static void get_regs(const uint8_t *p){
+    CDP1802Packed r;
+    for(uint8_t i=0; i<16; i++, p+=2){
+        r.R[i] = p[0] | (uint16_t)p[1]<<8;
+    }
+    r.D     = *p++;
+    r.T     = *p++;
+    r.XP    = *p++;
+    r.IN    = *p++;
+    r.flags = *p++;
+    r.cycles = 0;
+    for(uint8_t i=0; i<8; i++){
+        r.cycles |= (uint64_t)*p++ << (i*8);
+    }
+    cpu_unpack(&r);
+}
+
+static void reply_stopped(){
+    uint8_t *p = reply_begin(P_STOPPED, PS_OK);
+    p[0] = stopReason;
+    put_regs(&p[1]);
+    reply_end(1 + PROTO_REGS_LEN);
+    stopReason = 0xFF;
+}
+
+/**************************** Commands ****************************/
+static uint16_t arg16(uint8_t at){
+    return rxBuf[at] | (uint16_t)rxBuf[at+1]<<8;
+}
+
+static uint32_t arg_end(uint8_t at){
+    return arg16(at) ? arg16(at) : 0x10000UL;
+}
+
+// P_BLOCK, returns the reply length
+static uint8_t block(uint8_t *p){
+    uint32_t found;
+
+    switch(rxBuf[0]){
+        case BK_FILL:
+            if(rxLen != 6) goto badlen;
+            journal_clear();
+            blk_fill(arg16(1), arg16(3), rxBuf[5]);
+        break;
+
+        case BK_COPY:
+            if(rxLen != 7) goto badlen;
+            journal_clear();
+            blk_copy(arg16(1), arg16(3), arg16(5));
+        break;
+
+        case BK_INSERT:
+        case BK_DELETE:
+            if(rxLen != 10) goto badlen;
+            journal_clear();
+            if(rxBuf[0] == BK_INSERT){
+                blk_insert(arg16(1), arg16(3), arg_end(5), arg16(7), rxBuf[9]);
+            }else{
+                blk_delete(arg16(1), arg16(3), arg_end(5), arg16(7), rxBuf[9]);
+            }
+            p[0] = (uint8_t)blkPatched;
+            p[1] = blkPatched>>8;
+            p[2] = (uint8_t)blkBroken;
+            p[3] = blkBroken>>8;
+            return 4;
+
+        case BK_SEARCH:
+            if(rxLen < 6) goto badlen;
+            found = blk_search(arg16(1), arg_end(3), &rxBuf[5], rxLen - 5);
+            if(found == BLK_NONE) break;
+            p[0] = (uint8_t)found;
+            p[1] = found>>8;
+            return 2;
+
+        default:
+            txBuf[2] = PS_BADCMD;
+        break;
+    }
+    return 0;
+
+badlen:
+    txBuf[2] = PS_BADLEN;
+    return 0;
+}
+
+static void start(uint16_t steps){
+    running   = 1;
+    started   = 1;
+    stepsLeft = steps;
+    stopReason = 0xFF;
+}
+
+static void handle(){
+    uint8_t *p   = reply_begin(rxCmd, PS_OK);
+    uint8_t  len = 0;
+
+    if(rxStatus != PS_OK){
+        txBuf[2] = rxStatus;
+        reply_end(0);
+        return;
+    }
+
+    switch(rxCmd){
+        case P_PING:
+            p[0] = 'E'; p[1] = 'L'; p[2] = 'F';
+            p[3] = PROTO_VERSION;
+            p[4] = (uint8_t)(MEM_SPACE-1);
+            p[5] = (uint8_t)((MEM_SPACE-1)>>8);
+            len = 6;
+        break;
+
+        case P_REGS:
+            put_regs(p);
+            len = PROTO_REGS_LEN;
+        break;
+
+        case P_SETREGS:
+            if(rxLen != PROTO_REGS_LEN) goto badlen;
+            journal_clear();
+            get_regs(rxBuf);
+        break;
+
+        case P_READ:
+            if(rxLen != 3 || rxBuf[2] > PROTO_MAX) goto badlen;
+            for(uint16_t a=arg16(0); len<rxBuf[2]; a++){
+                p[len++] = MEM_RD(a);
+            }
+        break;
+
+        case P_WRITE:
+            if(rxLen < 2) goto badlen;
+            journal_clear();
+            for(uint8_t i=2; i<rxLen; i++){
+                MEM_WR((uint16_t)(arg16(0) + i - 2), rxBuf[i]);
+            }
+        break;
+
+        case P_STEP:
+            if(rxLen != 2) goto badlen;
+            if(arg16(0)){
+                hasUntil = 0;
+                start(arg16(0));
+            }
+        break;
+
+        case P_RUN:
+            if(rxLen != 0 && rxLen != 2) goto badlen;
+            hasUntil = rxLen == 2;
+            if(hasUntil) until = arg16(0);
+            start(0);
+        break;
+
+        case P_STOP:
+            if(running){
+                running    = 0;
+                stopReason = PR_STOP;
+            }
+        break;
+
+        case P_BREAK:
+            if(rxLen != 2) goto badlen;
+            if(nbreaks == PROTO_BREAKS){
+                txBuf[2] = PS_FULL;
+                break;
+            }
+            breaks[nbreaks++] = arg16(0);
+        break;
+
+        case P_CLEAR:
+            if(rxLen == 0){
+                nbreaks = 0;
+            }else if(rxLen == 2){
+                for(uint8_t i=0; i<nbreaks; i++){
+                    if(breaks[i] == arg16(0)){
+                        breaks[i--] = breaks[--nbreaks];
+                    }
+                }
+            }else{
+                goto badlen;
+            }
+        break;
+
+        case P_BACK:
+            if(rxLen != 2) goto badlen;
+            if(!running){
+                uint16_t n = 0;
+                while(n < arg16(0) && journal_back()) n++;
+                p[0] = (uint8_t)n;
+                p[1] = n>>8;
+                len = 2;
+            }
+        break;
+
+        case P_BLOCK:
+            if(rxLen < 1) goto badlen;
+            len = block(p);
+        break;
+
+#ifdef ELF_SAMPLE
+        case P_SAMPLE:
+            if(rxLen != 0 && rxLen != 2) goto badlen;
+            if(rxLen == 2) sample_timer(arg16(0));
+            len = sample_drain(p);
+        break;
+#endif
+
+        default:
+            txBuf[2] = PS_BADCMD;
+        break;
+    }
+    reply_end(len);
+    return;
+
+badlen:
+    txBuf[2] = PS_BADLEN;
+    reply_end(0);
+}
+
+/**************************** Receiver ****************************/
+uint8_t proto_feed(uint8_t c){
+    switch(rxState){
+        case RX_SYNC:
+            if(c != PROTO_SYNC) return 0;
+            rxCrc   = 0;
+            rxState = RX_CMD;
+        break;
+
+        case RX_CMD:
+            rxCmd   = c;
+            rxCrc   = proto_crc(rxCrc, c);
+            rxState = RX_LEN;
+        break;
+
+        case RX_LEN:
+            rxLen    = c;
+            rxPos    = 0;
+            rxCrc    = proto_crc(rxCrc, c);
+            rxStatus = c > PROTO_MAX ? PS_BADLEN : PS_OK;
+            rxState  = c ? RX_DATA : RX_CRC;
+        break;
+
+        case RX_DATA:
+            if(rxPos < PROTO_MAX) rxBuf[rxPos] = c;
+            rxCrc = proto_crc(rxCrc, c);
+            if(++rxPos == rxLen) rxState = RX_CRC;
+        break;
+
+        case RX_CRC:
+            if(c != rxCrc && rxStatus == PS_OK) rxStatus = PS_BADCRC;
+            rxState = RX_DONE;
+            proto_flush();
+        break;
+    }
+    return 1;
+}
+
+uint8_t proto_busy(){
+    return rxState == RX_DONE;
+}
+
+void proto_flush(){
+    while(txPos < txLen && proto_room()){
+        proto_send(txBuf[txPos++]);
+    }
+    if(txPos < txLen) return;
+
+    // The reply buffer is free, a request goes before a stop event
+    if(rxState == RX_DONE){
+        rxState = RX_SYNC;
+        handle();
+        proto_flush();
+    }else if(stopReason != 0xFF){
+        reply_stopped();
+        proto_flush();
+    }
+}
+
+/**************************** Execution ****************************/
+uint8_t proto_running(){
+    return running;
+}
+
+static uint8_t is_break(uint16_t pc){
+    for(uint8_t i=0; i<nbreaks; i++){
+        if(breaks[i] == pc) return 1;
+    }
+    return 0;
+}
+
+// Where a fused pair has to stop short
+static uint8_t stop_at(uint16_t pc){
+    return (hasUntil && pc == until) || is_break(pc);
+}
+
+void proto_execute(){
+    // Steps go through the journal one instruction each
+    fuse_enabled = !stepsLeft;
+    fuse_stop    = stop_at;
+#ifdef ELF_SAMPLE
+    sampleCpu    = 1;
+#endif
+    for(uint8_t i=0; i<PROTO_QUANTUM && running; i++){
+        uint16_t pc = cpu.R[cpu.P];
+
+        // A run may start on a breakpoint, it stops on the next hit
+        if(!started){
+            if(hasUntil && pc == until){
+                stopReason = PR_UNTIL;
+                running = 0;
+                break;
+            }
+            if(nbreaks && is_break(pc)){
+                stopReason = PR_BREAK;
+                running = 0;
+                break;
+            }
+        }
+        started = 0;
+
+        if(stepsLeft){
+            journal_step();
+        }else{
+            cpu_execute();
+        }
+        if(stepsLeft && !--stepsLeft){
+            stopReason = PR_DONE;
+            running = 0;
+        }
+    }
+    fuse_enabled = 0;
+    fuse_stop    = NULL;
+#ifdef ELF_SAMPLE
+    sampleCpu    = 0;
+#endif
+    proto_flush();
+}
+
+#endif
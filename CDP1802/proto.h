@@ -0,0 +1,104 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __PROTO_H__
+#define __PROTO_H__
+
+#include <stdint.h>
+
+// Uncomment to take debug protocol frames on the serial port, the
+// buffers cost about 300 bytes of RAM. The host builds pass -DELF_PROTO
+//#define ELF_PROTO
+
+/**
+ * Binary debug protocol
+ *
+ * Request  SYNC  cmd        len payload crc
+ * Reply    REPLY cmd status len payload crc
+ *
+ * crc is CRC-8 (poly 07) of everything after the sync byte.
+ * Every request gets one reply. STEP and RUN reply at once and
+ * send a STOPPED reply later, when the CPU stops. Numbers are
+ * little endian.
+ */
+#define PROTO_SYNC   0xA5
+#define PROTO_REPLY  0x5A
+#define PROTO_MAX    128    // Largest payload
+
+// Commands              request            reply
+#define P_PING    0x01  //                    'E' 'L' 'F' version, last address16
+#define P_REGS    0x02  //                    registers
+#define P_SETREGS 0x03  // registers
+#define P_READ    0x04  // addr16 len8        bytes
+#define P_WRITE   0x05  // addr16 bytes
+#define P_STEP    0x06  // count16            steps are journaled
+#define P_RUN     0x07  // [until16]
+#define P_STOP    0x08
+#define P_BREAK   0x09  // addr16
+#define P_CLEAR   0x0A  // [addr16]           no address clears all
+#define P_BACK    0x0B  // count16            steps undone16
+#define P_BLOCK   0x0C  // op8 arguments      see BK_* (block.h)
+#define P_SAMPLE  0x0D  // [hz16]             lost16 other16 (pc16 op8 count8)...  hz 0 stops, see sample.h
+#define P_STOPPED 0x10  //                    reason8 registers
+
+// P_BLOCK operations, an end16 of 0 is the top of the 64 KB
+#define BK_FILL   0     // addr16 len16 value8
+#define BK_COPY   1     // dst16 src16 len16
+#define BK_INSERT 2     // at16 count16 end16 lo16 relocate8  patched16 broken16
+#define BK_DELETE 3     // at16 count16 end16 lo16 relocate8  patched16 broken16
+#define BK_SEARCH 4     // from16 end16 bytes                 addr16, none when not found
+
+// Status
+#define PS_OK      0
+#define PS_BADCMD  1
+#define PS_BADLEN  2
+#define PS_BADCRC  3
+#define PS_FULL    4
+
+// STOPPED reasons
+#define PR_DONE    0    // Step count reached
+#define PR_BREAK   1    // Breakpoint
+#define PR_UNTIL   2    // RUN address reached
+#define PR_STOP    3    // STOP command
+
+#define PROTO_VERSION   3
+#define PROTO_BREAKS    8
+
+/**
+ * Registers on the wire: R0..RF, D, T, XP, IN, flags and cycles64,
+ * the fields of CDP1802Packed without padding
+ */
+#define PROTO_REGS_LEN  45
+
+static inline uint8_t proto_crc(uint8_t crc, uint8_t c){
+    crc ^= c;
+    for(uint8_t i=0; i<8; i++){
+        crc = (crc & 0x80) ? (crc<<1) ^ 0x07 : crc<<1;
+    }
+    return crc;
+}
+
+// Byte from the host, returns 0 when it is not part of a frame
+uint8_t proto_feed(uint8_t c);
+
+// Set while a frame waits for the reply buffer, do not feed then
+uint8_t proto_busy();
+
+// Runs a quantum of a STEP or RUN
+void    proto_execute();
+uint8_t proto_running();
+
+// Sends as much of the pending reply as the port takes
+void    proto_flush();
+
+// Port provided by the platform
+uint16_t proto_room();
+void     proto_send(uint8_t c);
+
+#endif
@@ -0,0 +1,121 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "cpu.h"
+#include "sample.h"
+#include "proto.h"
+
+#ifdef ELF_SAMPLE
+
+#ifndef ELF_PROTO
+#error "ELF_SAMPLE sends the samples with P_SAMPLE, uncomment ELF_PROTO in proto.h"
+#endif
+
+static_assert(4 + 4*SAMPLE_REPLY <= PROTO_MAX, "P_SAMPLE reply too long");
+
+volatile uint8_t sampleCpu;
+
+static uint16_t samplePc[SAMPLE_SLOTS];
+static uint8_t  sampleOp[SAMPLE_SLOTS];
+static uint8_t  sampleHits[SAMPLE_SLOTS];
+static uint16_t sampleLost, sampleOther;
+
+void sample_take(){
+    if(!sampleCpu){
+        if(sampleOther < 0xFFFF) sampleOther++;
+        return;
+    }
+    uint16_t pc = cpu.R[cpu.P];
+    uint8_t  op = cpu.I<<4 | cpu.N;
+    uint8_t  h  = (pc ^ pc>>5) & (SAMPLE_SLOTS-1);
+    for(uint8_t i=0; i<SAMPLE_PROBE; i++, h=(h+1) & (SAMPLE_SLOTS-1)){
+        if(!sampleHits[h]){
+            samplePc[h]   = pc;
+            sampleOp[h]   = op;
+            sampleHits[h] = 1;
+            return;
+        }
+        if(samplePc[h] == pc && sampleOp[h] == op){
+            if(sampleHits[h] == 0xFF) break;
+            sampleHits[h]++;
+            return;
+        }
+    }
+    if(sampleLost < 0xFFFF) sampleLost++;
+}
+
+uint8_t sample_drain(uint8_t *p){
+    uint8_t len  = 4;
+    uint8_t held = sample_hold();
+
+    p[0] = (uint8_t)sampleLost;
+    p[1] = sampleLost>>8;
+    p[2] = (uint8_t)sampleOther;
+    p[3] = sampleOther>>8;
+    for(uint8_t h=0, n=0; h<SAMPLE_SLOTS && n<SAMPLE_REPLY; h++){
+        if(!sampleHits[h]) continue;
+        p[len++] = (uint8_t)samplePc[h];
+        p[len++] = samplePc[h]>>8;
+        p[len++] = sampleOp[h];
+        p[len++] = sampleHits[h];
+        n++;
+        sampleHits[h] = 0;
+    }
+    sampleLost  = 0;
+    sampleOther = 0;
+    sample_release(held);
+    return len;
+}
+
+#ifdef __AVR__
+
+ISR(TIMER2_COMPA_vect){
+    sample_take();
+}
+
+/**
+ * Timer2 in CTC mode with the smallest prescaler that reaches
+ * the rate, 61 Hz at least
+ */
+void sample_timer(uint16_t hz){
+    static const uint16_t scales[] = { 1, 8, 32, 64, 128, 256, 1024 };
+    uint32_t top;
+    uint8_t  cs = 0;
+
+    TIMSK2 = 0;
+    TCCR2B = 0;
+    if(!hz) return;
+    do{
+        top = F_CPU / scales[cs++] / hz;
+    }while(top > 256 && cs < sizeof(scales)/sizeof(scales[0]));
+    if(top > 256) top = 256;
+    if(top < 2)   top = 2;
+
+    TCCR2A = _BV(WGM21);
+    OCR2A  = top - 1;
+    TCNT2  = 0;
+    TIFR2  = _BV(OCF2A);
+    TCCR2B = cs;            // CS22:0 is the index of the scale plus 1
+    TIMSK2 = _BV(OCIE2A);
+}
+
+uint8_t sample_hold(){
+    uint8_t sreg = SREG;
+    cli();
+    return sreg;
+}
+
+void sample_release(uint8_t held){
+    SREG = held;
+}
+
+#endif
+
+#endif
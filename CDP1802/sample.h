@@ -0,0 +1,56 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __SAMPLE_H__
+#define __SAMPLE_H__
+
+#include <stdint.h>
+
+// Uncomment to build the PC sampler, the host builds pass -DELF_SAMPLE
+//#define ELF_SAMPLE
+
+/**
+ * Statistical PC sampler
+ *
+ * A timer interrupt takes R(P) and the opcode in I and N while the
+ * program runs and counts them in a small hash table, a sample taken
+ * while the firmware does something else only counts as other.
+ * P_SAMPLE (proto.h) copies the table out and clears it, elfmon polls
+ * it and merges the samples of the whole 64 KB into the hotspot
+ * report. The interrupt mostly lands inside cpu_execute(), after the
+ * fetch moved R(P) past the opcode: elfmon looks for the opcode right
+ * before R(P) to find the instruction. A sample that finds neither
+ * its PC nor a free slot in SAMPLE_PROBE tries, or a full count, is
+ * lost: poll before the table fills.
+ */
+#define SAMPLE_SLOTS  32    // Power of 2
+#define SAMPLE_REPLY  31    // Slots in a P_SAMPLE reply, the rest go with the next one
+#define SAMPLE_PROBE  8
+#define SAMPLE_HZ     500   // Rate of elfmon profile
+
+// Set by the loops that run the program
+extern volatile uint8_t sampleCpu;
+
+// The timer interrupt
+void    sample_take();
+
+/**
+ * Moves the table to p, returns the length: lost16 other16
+ * then pc16 opcode8 count8 for up to SAMPLE_REPLY slots
+ */
+uint8_t sample_drain(uint8_t *p);
+
+// Timer provided by the platform, 0 Hz stops it
+void    sample_timer(uint16_t hz);
+
+// Masks the timer while the table is copied
+uint8_t sample_hold();
+void    sample_release(uint8_t held);
+
+#endif
@@ -0,0 +1,109 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "cpu.h"
+#include "mem.h"
+#include "scrt.h"
+
+ELF_TLS uint8_t scrt_enabled = 1;
+
+ELF_TLS uint64_t scrt_calls;
+ELF_TLS uint64_t scrt_returns;
+
+#ifdef ELF_SCRT
+
+// The branch offset is not compared
+static const uint8_t scrtCall[SCRT_CALL_LEN-1] PROGMEM = {
+    0xE2, 0x96, 0x73, 0x86, 0x73, 0x93, 0xB6, 0x83, 
+    0xA6, 0x46, 0xB3, 0x46, 0xA3, 0x30
+};
+
+static const uint8_t scrtReturn[SCRT_RETURN_LEN-1] PROGMEM = {
+    0x96, 0xB3, 0x86, 0xA3, 0xE2, 0x12, 0x72, 0xA6, 
+    0xF0, 0xB6, 0x30
+};
+
+/**
+ * Check the routine body and find the exit SEP 3.
+ * Returns the exit address or 0xFFFF
+ */
+static uint16_t scrt_match(uint16_t addr, const uint8_t *body, uint8_t len){
+    for(uint8_t i=0; i<len-1; i++){
+        if(RD_OP((uint16_t)(addr+i)) != pgm_read_byte(&body[i])) return 0xFFFF;
+    }
+    // BR sets the low byte of the PC, which points to its operand
+    uint16_t branch = (uint16_t)(addr + len - 1);
+    uint16_t exit   = (branch & 0xFF00) | RD_ARG(branch);
+    if(RD_OP(exit) != 0xD3) return 0xFFFF;
+    return exit;
+}
+
+// True when addr falls in the routine bytes or on its exit
+static uint8_t scrt_inside(uint16_t addr, uint16_t entry, uint8_t len, uint16_t exit){
+    return (uint16_t)(addr - entry) < len || addr == exit;
+}
+
+uint8_t scrt_execute(){
+    uint8_t  n     = cpu.N;
+    uint16_t entry = cpu.R[n];
+    uint16_t exit;
+
+    if(n == 4){
+        exit = scrt_match(entry, scrtCall, SCRT_CALL_LEN);
+        if(exit == 0xFFFF) return 0;
+
+        // Pushing R6 over the routine itself is left to the interpreter
+        uint16_t sp = cpu.R[2];
+        if(scrt_inside(sp, entry, SCRT_CALL_LEN, exit) ||
+           scrt_inside((uint16_t)(sp-1), entry, SCRT_CALL_LEN, exit)) return 0;
+
+        // SEX 2, GHI 6, STXD, GLO 6, STXD
+        cpu.X = 2;
+        WR_M(sp, GET_R_HIGH(6));
+        WR_M((uint16_t)(sp-1), GET_R_LOW(6));
+        cpu.R[2] = sp - 2;
+        // GHI 3, PHI 6, GLO 3, PLO 6
+        cpu.R[6] = cpu.R[3];
+        // LDA 6, PHI 3, LDA 6, PLO 3
+        uint8_t high = RD_M(cpu.R[6]);
+        cpu.R[6]++;
+        cpu.D = RD_M(cpu.R[6]);
+        cpu.R[6]++;
+        cpu.R[3] = ((uint16_t)high<<8) | cpu.D;
+        scrt_calls++;
+        ADD_CYCLES((SCRT_CALL_INSTR+1)*2);
+    }else if(n == 5){
+        exit = scrt_match(entry, scrtReturn, SCRT_RETURN_LEN);
+        if(exit == 0xFFFF) return 0;
+
+        // GHI 6, PHI 3, GLO 6, PLO 3
+        cpu.R[3] = cpu.R[6];
+        // SEX 2, INC 2, LDXA, PLO 6, LDX, PHI 6
+        cpu.X = 2;
+        cpu.R[2]++;
+        uint8_t low = RD_M(cpu.R[2]);
+        cpu.R[2]++;
+        cpu.D = RD_M(cpu.R[2]);
+        cpu.R[6] = ((uint16_t)cpu.D<<8) | low;
+        scrt_returns++;
+        ADD_CYCLES((SCRT_RETURN_INSTR+1)*2);
+    }else{
+        return 0;
+    }
+
+    // BR to the exit, SEP 3 leaves R(N) on the entry again
+    cpu.R[n] = exit + 1;
+    cpu.P = 3;
+    cpu.I = 0xD;
+    cpu.N = 3;
+    return 1;
+}
+
+#endif
@@ -0,0 +1,52 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __SCRT_H__
+#define __SCRT_H__
+
+#include "cpu.h"
+
+// Comment out to always run SCRT routines instruction by instruction
+#define ELF_SCRT
+
+/**
+ * Standard Call and Return Technique
+ *
+ * When SEP 4 or SEP 5 enters the standard RCA CALL or RETURN
+ * routine, the whole routine runs natively. R2, R3, R4/R5, R6,
+ * X, D, I, N, the stack bytes and cycles end exactly as if every
+ * instruction had been interpreted.
+ *
+ *   CALL   E2 96 73 86 73 93 B6 83 A6 46 B3 46 A3 30 xx
+ *   RETURN 96 B3 86 A3 E2 12 72 A6 F0 B6 30 xx
+ *
+ * xx must branch to a SEP 3 in the same page.
+ */
+#define SCRT_CALL_LEN    15
+#define SCRT_RETURN_LEN  12
+
+// Instructions run by the routine including the exit SEP 3
+#define SCRT_CALL_INSTR   15
+#define SCRT_RETURN_INSTR 12
+
+// Runtime switch, clear it to compare against the plain interpreter
+extern ELF_TLS uint8_t scrt_enabled;
+
+// Routines run natively
+extern ELF_TLS uint64_t scrt_calls;
+extern ELF_TLS uint64_t scrt_returns;
+
+/**
+ * Called for SEP N after the fetch, runs the routine at R(N)
+ * and returns 1 when it is a standard one, else returns 0
+ * without touching anything.
+ */
+uint8_t scrt_execute();
+
+#endif
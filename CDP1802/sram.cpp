@@ -0,0 +1,53 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "mem.h"
+
+#ifdef ELF_SPI_SRAM
+
+uint8_t  sramCache[SRAM_LINES][SRAM_LINE];
+uint16_t sramTag[SRAM_LINES];
+uint16_t sramDirty;
+uint32_t sramAccesses, sramMisses, sramWritebacks;
+
+static void write_back(uint8_t l){
+    spi_sram_write(sramTag[l] << SRAM_LINE_BITS, sramCache[l], SRAM_LINE);
+    sramDirty &= ~(1<<l);
+    sramWritebacks++;
+}
+
+uint8_t *sram_miss(uint16_t addr){
+    uint8_t l = (addr >> SRAM_LINE_BITS) & (SRAM_LINES-1);
+
+    if(sramDirty & (1<<l)){
+        write_back(l);
+    }
+    sramTag[l] = addr >> SRAM_LINE_BITS;
+    spi_sram_read(sramTag[l] << SRAM_LINE_BITS, sramCache[l], SRAM_LINE);
+    sramMisses++;
+    return sramCache[l];
+}
+
+void sram_flush(){
+    for(uint8_t l=0; l<SRAM_LINES; l++){
+        if(sramDirty & (1<<l)) write_back(l);
+    }
+}
+
+void sram_init(){
+    spi_sram_begin();
+    for(uint8_t l=0; l<SRAM_LINES; l++){
+        sramTag[l] = SRAM_NOTAG;
+    }
+    sramDirty = 0;
+    sramAccesses = sramMisses = sramWritebacks = 0;
+}
+
+#endif
@@ -0,0 +1,74 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __SRAM_H__
+#define __SRAM_H__
+
+#include <stdint.h>
+
+/**
+ * 64 KB address space on a 23LC512 SPI SRAM
+ *
+ * A direct mapped cache of SRAM_LINES lines of SRAM_LINE bytes
+ * sits in the AVR RAM. A hit costs a tag compare, a miss writes
+ * the old line back when it is dirty and reads the new one in a
+ * single sequential SPI transfer.
+ */
+#define SRAM_LINE_BITS  5
+#define SRAM_LINE       (1<<SRAM_LINE_BITS)     // Bytes per line
+#define SRAM_LINES      16                      // Power of two
+#define SRAM_NOTAG      0xFFFF
+
+extern uint8_t  sramCache[SRAM_LINES][SRAM_LINE];
+extern uint16_t sramTag[SRAM_LINES];            // addr>>SRAM_LINE_BITS
+extern uint16_t sramDirty;                      // Bit per line
+
+// Statistics, accesses are counted only with SRAM_STATS
+extern uint32_t sramAccesses, sramMisses, sramWritebacks;
+
+// Brings the line of addr in, returns it
+uint8_t *sram_miss(uint16_t addr);
+
+static inline uint8_t sram_read(uint16_t addr){
+    uint8_t l = (addr >> SRAM_LINE_BITS) & (SRAM_LINES-1);
+#ifdef SRAM_STATS
+    sramAccesses++;
+#endif
+    if(sramTag[l] != addr >> SRAM_LINE_BITS){
+        return sram_miss(addr)[addr & (SRAM_LINE-1)];
+    }
+    return sramCache[l][addr & (SRAM_LINE-1)];
+}
+
+static inline void sram_write(uint16_t addr, uint8_t value){
+    uint8_t l = (addr >> SRAM_LINE_BITS) & (SRAM_LINES-1);
+#ifdef SRAM_STATS
+    sramAccesses++;
+#endif
+    if(sramTag[l] != addr >> SRAM_LINE_BITS){
+        sram_miss(addr);
+    }
+    sramCache[l][addr & (SRAM_LINE-1)] = value;
+    sramDirty |= 1<<l;
+}
+
+void sram_init();       // Chip in sequential mode, cache empty
+void sram_flush();      // Writes every dirty line back
+
+#ifdef SRAM_STATS
+#include <stdio.h>
+void sram_report(FILE *f);      // Host stand-in, hit rate and bus time
+#endif
+
+// SPI transfers, sramspi.cpp on the board, a stand-in on the host
+void spi_sram_begin();
+void spi_sram_read (uint16_t addr, uint8_t *buf, uint8_t len);
+void spi_sram_write(uint16_t addr, const uint8_t *buf, uint8_t len);
+
+#endif
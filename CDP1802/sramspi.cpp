@@ -0,0 +1,80 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "mem.h"
+#include "fastio.h"
+
+#ifdef ELF_SPI_SRAM
+
+// 23LC512 instructions
+#define SR_READ   0x03
+#define SR_WRITE  0x02
+#define SR_WRMR   0x01
+#define SR_SEQ    0x40      // Sequential mode, transfers cross pages
+
+typedef FastPin<_SRAM_CS>   PinCS;
+typedef FastPin<_SRAM_SCK>  PinSCK;
+typedef FastPin<_SRAM_MOSI> PinMOSI;
+typedef FastPin<_SRAM_MISO> PinMISO;
+
+/**
+ * SPI mode 0, MSB first. Every bit is a few sbi/cbi, a byte
+ * takes about 3 us at 16 MHz.
+ */
+static uint8_t spi_byte(uint8_t out){
+    uint8_t in = 0;
+    for(uint8_t i=0; i<8; i++){
+        PinMOSI::write(out & 0x80);
+        out <<= 1;
+        PinSCK::high();
+        in = (in << 1) | PinMISO::read();
+        PinSCK::low();
+    }
+    return in;
+}
+
+static void spi_command(uint8_t cmd, uint16_t addr){
+    PinCS::low();
+    spi_byte(cmd);
+    spi_byte(addr >> 8);
+    spi_byte(addr);
+}
+
+void spi_sram_begin(){
+    pinMode(_SRAM_CS,   OUTPUT);
+    pinMode(_SRAM_SCK,  OUTPUT);
+    pinMode(_SRAM_MOSI, OUTPUT);
+    pinMode(_SRAM_MISO, INPUT);
+    PinCS::high();
+    PinSCK::low();
+
+    PinCS::low();
+    spi_byte(SR_WRMR);
+    spi_byte(SR_SEQ);
+    PinCS::high();
+}
+
+void spi_sram_read(uint16_t addr, uint8_t *buf, uint8_t len){
+    spi_command(SR_READ, addr);
+    while(len--){
+        *buf++ = spi_byte(0);
+    }
+    PinCS::high();
+}
+
+void spi_sram_write(uint16_t addr, const uint8_t *buf, uint8_t len){
+    spi_command(SR_WRITE, addr);
+    while(len--){
+        spi_byte(*buf++);
+    }
+    PinCS::high();
+}
+
+#endif
@@ -0,0 +1,295 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "cpu.h"
+#include "mem.h"
+#include "tape.h"
+
+ELF_TLS uint8_t tape_turbo = 1;
+
+ELF_TLS uint32_t tape_bytes_read;
+ELF_TLS uint32_t tape_bytes_written;
+ELF_TLS uint64_t tape_instr;
+
+#ifdef ELF_TAPE
+
+static const uint8_t tapeWrite[TAPE_WRITE_LEN] PROGMEM = {
+    0xD3, 0xF8, 0x00, 0xBA, 0xF8, TAPE_LEADER+1, 0xAA, 0x8A,
+    0x32, 0x13, 0xFF, 0x01, 0xAA, 0x32, 0x29, 0xFC,
+    0x00, 0x30, 0x29, 0x9A, 0x3A, 0x22, 0x99, 0x3A,
+    0x1C, 0x89, 0x32, 0x3D, 0x29, 0x48, 0xAF, 0xF8,
+    0x08, 0xBA, 0x9A, 0xFF, 0x01, 0xBA, 0x8F, 0xF6,
+    0xAF, 0x7B, 0xF8, TAPE_N0, 0x3B, 0x30, 0xF8, TAPE_N1,
+    0xFF, 0x01, 0x3A, 0x30, 0x7A, 0xF8, TAPE_NL, 0xFF,
+    0x01, 0x3A, 0x37, 0x30, 0x07, 0x30, 0x00
+};
+
+static const uint8_t tapeRead[TAPE_READ_LEN] PROGMEM = {
+    0xD3, 0x3D, 0x01, 0xF8, 0x00, 0xAB, 0x1B, 0x35,
+    0x06, 0x8B, 0xFF, TAPE_T, 0x3B, 0x01, 0x99, 0x3A,
+    0x14, 0x89, 0x32, 0x31, 0xF8, 0x08, 0xBA, 0x3D,
+    0x17, 0xF8, 0x00, 0xAB, 0x1B, 0x35, 0x1C, 0x8B,
+    0xFF, TAPE_T, 0x8F, 0x76, 0xAF, 0x9A, 0xFF, 0x01,
+    0xBA, 0x3A, 0x17, 0x8F, 0x58, 0x18, 0x29, 0x30,
+    0x0E, 0x30, 0x00
+};
+
+// Bit per byte holding a branch operand, it gets the base low byte added
+#define WRITE_BRANCHES 0x5408200009244200ULL
+#define READ_BRANCHES  0x0005040041092104ULL
+
+// Where the reader waits for EF2 with BN2 and counts with INC RB
+#define READ_SYNC_WAIT  0x01
+#define READ_SYNC_COUNT 0x06
+#define READ_BIT_WAIT   0x17
+#define READ_BIT_COUNT  0x1C
+
+static uint8_t tape_match(uint16_t base, const uint8_t *body, uint8_t len, uint64_t branches){
+    if((base & 0xFF) + len > 0x100) return 0;
+    for(uint8_t i=0; i<len; i++){
+        uint8_t want = pgm_read_byte(&body[i]);
+        if((branches >> i) & 1) want += (uint8_t)base;
+        if(RD_OP((uint16_t)(base + i)) != want) return 0;
+    }
+    return 1;
+}
+
+void tape_place(uint16_t base, uint8_t routine){
+    const uint8_t *body = routine == TAPE_READ ? tapeRead : tapeWrite;
+    uint8_t  len        = routine == TAPE_READ ? TAPE_READ_LEN : TAPE_WRITE_LEN;
+    uint64_t branches   = routine == TAPE_READ ? READ_BRANCHES : WRITE_BRANCHES;
+    for(uint8_t i=0; i<len; i++){
+        uint8_t b = pgm_read_byte(&body[i]);
+        if((branches >> i) & 1) b += (uint8_t)base;
+        MEM_WR((uint16_t)(base + i), b);
+    }
+}
+
+/**
+ * One bit from the SEQ at t, returns the time of the next
+ * instruction after BR next
+ */
+static uint64_t write_pulse(uint64_t t, uint8_t bit){
+    tape_q(t, 1);
+    // SEQ, LDI, BNF, LDI for a 1, then SMI and BNZ per loop
+    t += 6 + (bit ? 2 + 4*TAPE_N1 : 4*TAPE_N0);
+    tape_q(t, 0);
+    // REQ, LDI, the loops, BR next
+    return t + 4 + 4*TAPE_NL + 2;
+}
+
+static void tape_write(uint64_t t){
+    uint16_t addr  = cpu.R[8];
+    uint16_t count = cpu.R[9];
+    uint8_t  rf    = (uint8_t)cpu.R[0xF];
+    uint8_t  bits  = 0;
+
+    // LDI, PHI RA, LDI, PLO RA
+    t += 8;
+    // Leader bits take GLO BZ SMI PLO BZ ADI BR, the sync bit GLO BZ SMI PLO BZ
+    for(uint8_t i=0; i<=TAPE_LEADER; i++){
+        t += i < TAPE_LEADER ? 14 : 10;
+        t = write_pulse(t, i == TAPE_LEADER);
+    }
+    for(;;){
+        // next: GLO RA, BZ data; data: GHI RA, BNZ bits
+        t += 8;
+        if(!bits){
+            // GHI R9, BNZ more, then GLO R9, BZ done with R9.1 at 0
+            t += 4;
+            if(!(count >> 8)){
+                t += 4;
+                if(!count) break;
+            }
+            // DEC R9, LDA R8, PLO RF, LDI 8, PHI RA
+            count--;
+            rf = RD_M(addr++);
+            bits = 8;
+            t += 10;
+            tape_bytes_written++;
+        }
+        // bits: GHI RA, SMI, PHI RA, GLO RF, SHR, PLO RF
+        uint8_t bit = rf & 1;
+        rf >>= 1;
+        bits--;
+        t += 12;
+        t = write_pulse(t, bit);
+    }
+
+    cpu.R[8]   = addr;
+    cpu.R[9]   = 0;
+    cpu.R[0xA] = 0;
+    cpu.R[0xF] = (cpu.R[0xF] & 0xFF00) | rf;
+    cpu.D  = 0;
+    cpu.DF = 1;
+    // BR exit, SEP 3
+    SET_CYCLES(t + 4);
+    cpu.Q = 0;
+    cpu_outputQ();
+}
+
+/**
+ * BN2 wait from t, then LDI, PLO RB and the INC RB, B2 count loop.
+ * When the tape ends first t is left at the BN2 or the INC RB.
+ */
+#define PULSE_OK    0
+#define PULSE_WAIT  1
+#define PULSE_COUNT 2
+
+static uint8_t read_pulse(uint64_t *t, uint16_t *rb){
+    uint64_t now = *t;
+    while(!tape_ef(now)){
+        uint64_t edge = tape_next_edge(now);
+        if(edge == UINT64_MAX){
+            *t = now;
+            return PULSE_WAIT;
+        }
+        // The first BN2 at or after the edge
+        now += (edge - now + 1) & ~1ULL;
+    }
+    now += 6;
+    *rb &= 0xFF00;
+
+    // B2 samples at now+2, now+6... until one finds EF2 low
+    uint64_t b2 = now + 2;
+    while(tape_ef(b2)){
+        uint64_t edge = tape_next_edge(b2);
+        if(edge == UINT64_MAX){
+            *rb += (uint16_t)((b2 - now - 2) / 4);
+            *t   = b2 - 2;
+            return PULSE_COUNT;
+        }
+        b2 += (edge - b2 + 3) & ~3ULL;
+    }
+    *rb += (uint16_t)((b2 - now - 2) / 4 + 1);
+    *t   = b2 + 2;
+    return PULSE_OK;
+}
+
+/**
+ * Returns the offset where the routine waits when the tape ended,
+ * 0 after the whole block
+ */
+static uint8_t tape_read(uint64_t *pt){
+    uint64_t t     = *pt;
+    uint16_t addr  = cpu.R[8];
+    uint16_t count = cpu.R[9];
+    uint16_t rb    = cpu.R[0xB];
+    uint8_t  ra    = cpu.R[0xA] >> 8;
+    uint8_t  rf    = (uint8_t)cpu.R[0xF];
+    uint8_t  d     = cpu.D;
+    uint8_t  df    = cpu.DF;
+    uint8_t  wait  = 0, st = PULSE_OK;
+
+    // Sync: short pulses until a long one, GLO RB, SMI, BNF s0
+    for(;;){
+        if((st = read_pulse(&t, &rb))){
+            wait = st == PULSE_WAIT ? READ_SYNC_WAIT : READ_SYNC_COUNT;
+            goto out;
+        }
+        t += 6;
+        d  = (uint8_t)rb - TAPE_T;
+        df = (uint8_t)rb >= TAPE_T;
+        if(df) break;
+    }
+    for(;;){
+        // byte: GHI R9, BNZ rd, then GLO R9, BZ done with R9.1 at 0
+        t += 4;
+        d = count >> 8;
+        if(!d){
+            t += 4;
+            d = (uint8_t)count;
+            if(!count) break;
+        }
+        // LDI 8, PHI RA
+        ra = 8;
+        d  = 8;
+        t += 4;
+        do{
+            if((st = read_pulse(&t, &rb))){
+                wait = st == PULSE_WAIT ? READ_BIT_WAIT : READ_BIT_COUNT;
+                goto out;
+            }
+            // GLO RB, SMI, GLO RF, SHRC, PLO RF, GHI RA, SMI, PHI RA, BNZ
+            rf = (rf >> 1) | ((uint8_t)rb >= TAPE_T ? 0x80 : 0);
+            d  = --ra;
+            df = 1;
+            t += 18;
+        }while(ra);
+        // GLO RF, STR R8, INC R8, DEC R9, BR byte
+        WR_M(addr, rf);
+        addr++;
+        count--;
+        d = rf;
+        t += 10;
+        tape_bytes_read++;
+    }
+    // BR exit
+    t += 2;
+
+out:
+    // LDI 0 ran before the count loop
+    if(st == PULSE_COUNT) d = 0;
+    cpu.R[8]   = addr;
+    cpu.R[9]   = count;
+    cpu.R[0xA] = (cpu.R[0xA] & 0x00FF) | (uint16_t)ra << 8;
+    cpu.R[0xB] = rb;
+    cpu.R[0xF] = (cpu.R[0xF] & 0xFF00) | rf;
+    cpu.D  = d;
+    cpu.DF = df;
+    *pt = t;
+    return wait;
+}
+
+uint8_t tape_execute(){
+    uint8_t  n    = cpu.N;
+    uint16_t base = (uint16_t)(cpu.R[n] - 1);
+
+    // The routines use these
+    if(n == 3 || n == 8 || n == 9 || n == 0xA || n == 0xB || n == 0xF) return 0;
+
+    // From the SEP to the first instruction
+    uint64_t from = GET_CYCLES();
+    uint64_t t    = from + 2;
+
+    if(tape_match(base, tapeWrite, TAPE_WRITE_LEN, WRITE_BRANCHES)){
+        tape_write(t);
+    }else if(tape_match(base, tapeRead, TAPE_READ_LEN, READ_BRANCHES)){
+        // A block over the routine itself or past the top is left to the interpreter
+        uint32_t end = (uint32_t)cpu.R[8] + cpu.R[9];
+        if(end > 0x10000UL || (cpu.R[8] < base + TAPE_READ_LEN && end > base)) return 0;
+
+        uint8_t wait = tape_read(&t);
+        SET_CYCLES(t);
+        if(wait){
+            // Left in the routine on the last level, as the real one would be forever
+            cpu.R[n] = base + wait;
+            cpu.P = n;
+            cpu.I = 0x3;
+            cpu.N = (wait == READ_SYNC_WAIT || wait == READ_BIT_WAIT) ? 0xD : 0x5;
+            tape_instr += (t - from) / 2 - 1;
+            return 1;
+        }
+        SET_CYCLES(t + 2);
+    }else{
+        return 0;
+    }
+
+    // SEP 3 leaves R(N) on the entry again
+    cpu.R[n] = base + 1;
+    cpu.P = 3;
+    cpu.I = 0xD;
+    cpu.N = 3;
+    // Every instruction of the routines takes two machine cycles
+    tape_instr += (GET_CYCLES() - from) / 2 - 1;
+    return 1;
+}
+
+#endif
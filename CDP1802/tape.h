@@ -0,0 +1,88 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __TAPE_H__
+#define __TAPE_H__
+
+#include "cpu.h"
+
+// Build with -DELF_TAPE and a cassette, host/cassette.cpp, to run
+// the tape routines below natively
+
+/**
+ * Cassette through Q and EF2
+ *
+ * A bit is a pulse: Q high for TAPE_N0 (0) or TAPE_N1 (1) delay
+ * loops, then low for TAPE_NL loops. A block is TAPE_LEADER 0 bits,
+ * a 1 bit for sync, then the bytes LSB first. The reader counts
+ * how long EF2 stays high, TAPE_T loops or more is a 1. At 1.79 MHz
+ * that is about 180 bytes per second.
+ *
+ * Both routines are called with SEP from P=3 and return with SEP 3,
+ * R8 the address and R9 the byte count; R8 ends after the block,
+ * R9 and D at 0, DF at 1. They use RA, RB and RF.0 and must not
+ * cross a page. xx is the routine start, the exit SEP 3:
+ *
+ *   TWRITE D3 F8 00 BA F8 21 AA 8A 32 13 FF 01 AA 32 29 FC
+ *          00 30 29 9A 3A 22 99 3A 1C 89 32 3D 29 48 AF F8
+ *          08 BA 9A FF 01 BA 8F F6 AF 7B F8 08 3B 30 F8 18
+ *          FF 01 3A 30 7A F8 0C FF 01 3A 37 30 07 30 00
+ *
+ *   TREAD  D3 3D 01 F8 00 AB 1B 35 06 8B FF 11 3B 01 99 3A
+ *          14 89 32 31 F8 08 BA 3D 17 F8 00 AB 1B 35 1C 8B
+ *          FF 11 8F 76 AF 9A FF 01 BA 3A 17 8F 58 18 29 30
+ *          0E 30 00
+ *
+ * Branch operands are shown for xx at a page start, they are
+ * relative to the start. With ELF_TAPE, SEP into a routine runs
+ * the whole transfer at once with the same Q edges, EF2 samples,
+ * registers and cycles as the instructions would have. Only these
+ * two routines are matched, as tape_place() writes them; the tape
+ * routines of other monitors run instruction by instruction.
+ */
+#define TAPE_LEADER  32
+#define TAPE_N0      8
+#define TAPE_N1      24
+#define TAPE_NL      12
+#define TAPE_T       17
+
+#define TAPE_WRITE_LEN 63
+#define TAPE_READ_LEN  51
+
+#define TAPE_WRITE 0
+#define TAPE_READ  1
+
+// Runtime switch, clear it to run the routines instruction by instruction
+extern ELF_TLS uint8_t tape_turbo;
+
+// Bytes moved natively
+extern ELF_TLS uint32_t tape_bytes_read;
+extern ELF_TLS uint32_t tape_bytes_written;
+
+// Instructions the native transfers stand for, without the SEP into
+// the routine, callers counting instructions add them
+extern ELF_TLS uint64_t tape_instr;
+
+/**
+ * Called for SEP N, runs the tape routine at R(N) and returns 1
+ * when there is one, else returns 0 without touching anything
+ */
+uint8_t tape_execute();
+
+// Writes TAPE_WRITE or TAPE_READ at base with its branches relocated
+void    tape_place(uint16_t base, uint8_t routine);
+
+/**
+ * The cassette, cycles are CPU machine cycles
+ */
+void     tape_q(uint64_t cycle, uint8_t q);     // Q changed
+uint8_t  tape_ef(uint64_t cycle);               // EF2 level
+uint64_t tape_next_edge(uint64_t cycle);        // First change after cycle, UINT64_MAX at the end
+
+#endif
@@ -0,0 +1,82 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "tasks.h"
+
+static uint32_t schedStart;
+static uint32_t schedPasses;
+
+/**
+ * One pass over the task table
+ */
+void sched_run(Task *tasks, uint8_t count){
+    uint32_t now = millis();
+
+    for(uint8_t i=0; i<count; i++){
+        Task *t = &tasks[i];
+        if(t->period){
+            if(now - t->last < t->period) continue;
+            t->last = now;
+        }
+
+        uint32_t t0 = micros();
+        t->run();
+        uint32_t us = micros() - t0;
+
+        t->runs++;
+        t->busy += us;
+        if(us > t->worst) t->worst = us>0xFFFF ? 0xFFFF : us;
+    }
+    schedPasses++;
+}
+
+// Name from flash, padded to 8 columns
+static void print_name(const char *name){
+    uint8_t n = strlen_P(name);
+
+    Serial.print((const __FlashStringHelper *)name);
+    while(n++ < 8) Serial.print(' ');
+}
+
+/**
+ * Print where the loop time went and start counting again
+ *
+ *   task       runs      ms    %  worst
+ */
+void sched_report(Task *tasks, uint8_t count){
+    char     buff[48];
+    uint32_t total = micros() - schedStart;
+    uint32_t busy  = 0;
+
+    sprintf_P(buff, PSTR("%lu ms, %lu passes\n"), total/1000, schedPasses);
+    Serial.print(buff);
+    Serial.print(F("task         runs      ms   %  worst us\n"));
+    for(uint8_t i=0; i<count; i++){
+        Task *t = &tasks[i];
+        print_name(t->name);
+        sprintf_P(buff, PSTR(" %8lu %7lu %3u %6u\n"),
+            t->runs, t->busy/1000,
+            (unsigned)(total ? (uint64_t)t->busy*100/total : 0),
+            t->worst
+        );
+        Serial.print(buff);
+        busy += t->busy;
+        t->runs  = 0;
+        t->busy  = 0;
+        t->worst = 0;
+    }
+    sprintf_P(buff, PSTR("loop              %7lu %3u\n"),
+        (total-busy)/1000,
+        (unsigned)(total ? (uint64_t)(total-busy)*100/total : 0)
+    );
+    Serial.print(buff);
+    schedStart  = micros();
+    schedPasses = 0;
+}
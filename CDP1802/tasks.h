@@ -0,0 +1,35 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __TASKS_H__
+#define __TASKS_H__
+
+/**
+ * Cooperative scheduler
+ *
+ * Tasks run to completion and never wait, a task with nothing
+ * to do returns at once. A task runs when its period in ms has
+ * elapsed, period 0 runs it on every pass.
+ */
+typedef struct Task{
+    const char *name;       // PROGMEM
+    void      (*run)();
+    uint16_t    period;     // ms, 0 = every pass
+    uint32_t    last;       // millis() of the last run
+
+    // Time accounting since the last report
+    uint32_t    runs;
+    uint32_t    busy;       // micros
+    uint16_t    worst;      // Longest run in micros
+} Task;
+
+void sched_run(Task *tasks, uint8_t count);
+void sched_report(Task *tasks, uint8_t count);
+
+#endif
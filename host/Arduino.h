@@ -0,0 +1,29 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+/**
+ * Host stand-in for the Arduino core.
+ * Only what the CPU and memory sources use is provided, so the
+ * emulator core builds unchanged with a desktop compiler.
+ */
+#ifndef __ARDUINO_HOST_H__
+#define __ARDUINO_HOST_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIGH 1
+#define LOW  0
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+
+#endif
@@ -0,0 +1,136 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+/**
+ * Exhaustive check of the shared ALU (alu.h)
+ *
+ *   alucheck
+ *
+ * Runs every D, operand and DF, 256x256x2 inputs, of ADD/ADC,
+ * SD/SDB, SM/SMB, their immediate forms and the four shifts through
+ * cpu_execute(), and compares D and DF with the per-opcode code the
+ * core had before alu.h. Prints the first mismatches and exits with
+ * 1 when there is any.
+ */
+#include <Arduino.h>
+#include "cpu.h"
+#include "mem.h"
+#include "hostio.h"
+
+#define CODE 0x0100     // Opcode and immediate operand, R0
+#define DATA 0x0200     // Memory operand, R1
+
+#define SHOW 8
+
+static const uint8_t ops[] = {
+    0x74, 0x75, 0x76, 0x77, 0x7C, 0x7D, 0x7E, 0x7F,
+    0xF4, 0xF5, 0xF6, 0xF7, 0xFC, 0xFD, 0xFE, 0xFF
+};
+
+static const char *names[] = {
+    "ADC",  "SDB",  "SHRC", "SMB",  "ADCI", "SDBI", "SHLC", "SMBI",
+    "ADD",  "SD",   "SHR",  "SM",   "ADI",  "SDI",  "SHL",  "SMI"
+};
+
+// The per-opcode code, m is the memory or immediate operand
+static void reference(uint8_t op, uint8_t m, uint8_t *d, uint8_t *df){
+    uint16_t sum16, sub16;
+    uint8_t  lsb, msb;
+
+    switch(op){
+        case 0x74: case 0x7C:
+            sum16 = m + *d + *df;
+            *d  = (uint8_t)(sum16 & 0xFF);
+            *df = (sum16&0xFF00)?1:0;
+        break;
+        case 0x75: case 0x7D:
+            sub16 = m - *d - (!*df);
+            *d  = (uint8_t)(sub16 & 0xFF);
+            *df = (sub16&0xFF00)?0:1;
+        break;
+        case 0x77: case 0x7F:
+            sub16 = *d - m - (!*df);
+            *d  = (uint8_t)(sub16 & 0xFF);
+            *df = (sub16&0xFF00)?0:1;
+        break;
+        case 0xF4: case 0xFC:
+            sum16 = m + *d;
+            *d  = (uint8_t)(sum16 & 0xFF);
+            *df = (sum16&0xFF00)?1:0;
+        break;
+        case 0xF5: case 0xFD:
+            sub16 = m - *d;
+            *d  = (uint8_t)(sub16 & 0xFF);
+            *df = (sub16&0xFF00)?0:1;
+        break;
+        case 0xF7: case 0xFF:
+            sub16 = *d - m;
+            *d  = (uint8_t)(sub16 & 0xFF);
+            *df = (sub16&0xFF00)?0:1;
+        break;
+        case 0x76:
+            lsb = *d&0x01;
+            *d >>= 1;
+            *d |= (*df?0b10000000:0b00000000);
+            *df = lsb;
+        break;
+        case 0x7E:
+            msb = *d&0b10000000?1:0;
+            *d <<= 1;
+            *d |= (*df?0b00000001:0b00000000);
+            *df = msb;
+        break;
+        case 0xF6:
+            *df = *d&0x01;
+            *d >>= 1;
+        break;
+        case 0xFE:
+            *df = *d&0b10000000?1:0;
+            *d <<= 1;
+        break;
+    }
+}
+
+int main(){
+    static Board b;
+    uint32_t checked = 0, bad = 0;
+
+    board_init(&b);
+    board = &b;
+
+    for(uint8_t i=0; i<sizeof(ops); i++){
+        for(uint16_t d=0; d<256; d++){
+            for(uint16_t m=0; m<256; m++){
+                for(uint8_t df=0; df<2; df++){
+                    memset(&cpu, 0, sizeof(cpu));
+                    cpu.X    = 1;
+                    cpu.R[0] = CODE;
+                    cpu.R[1] = DATA;
+                    cpu.D    = d;
+                    cpu.DF   = df;
+                    mem[CODE]     = ops[i];
+                    mem[CODE + 1] = m;
+                    mem[DATA]     = m;
+                    cpu_execute();
+
+                    uint8_t wantD = d, wantDF = df;
+                    reference(ops[i], m, &wantD, &wantDF);
+                    checked++;
+                    if(cpu.D == wantD && cpu.DF == wantDF) continue;
+                    if(bad++ < SHOW){
+                        printf("%-4s D=%02X M=%02X DF=%d: D=%02X DF=%d, expected D=%02X DF=%d\n",
+                               names[i], d, m, df, cpu.D, cpu.DF, wantD, wantDF);
+                    }
+                }
+            }
+        }
+    }
+    printf("%u inputs checked, %u mismatches\n", checked, bad);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,228 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include <vector>
+#include <algorithm>
+#include "cpu.h"
+#include "tape.h"
+#include "cassette.h"
+
+// Levels read from a sample with some hysteresis, samples are -128..127
+#define CAS_HIGH  16
+#define CAS_LOW  -16
+
+// Playback: sample numbers where the level toggles, it starts low
+static std::vector<uint32_t> playEdges;
+static uint32_t playRate;
+static uint8_t  playing, rolling;
+static uint64_t playStart;
+
+// Recording: cycles of the Q edges
+static std::vector<uint64_t> recEdges;
+static const char *recPath;
+static uint8_t  recQ;
+
+static int ends_with(const char *s, const char *tail){
+    size_t n = strlen(s), m = strlen(tail);
+    return n >= m && !strcasecmp(s + n - m, tail);
+}
+
+/**************************** Files ****************************/
+static uint32_t get16(const uint8_t *p){ return p[0] | p[1]<<8; }
+static uint32_t get32(const uint8_t *p){ return get16(p) | get16(p+2)<<16; }
+
+static void put16(FILE *f, uint32_t v){ fputc(v, f); fputc(v>>8, f); }
+static void put32(FILE *f, uint32_t v){ put16(f, v); put16(f, v>>16); }
+
+static void add_level(uint32_t s, uint8_t level){
+    if(level != (playEdges.size() & 1)) playEdges.push_back(s);
+}
+
+static int load_wav(const std::vector<uint8_t> &d, const char *path){
+    if(d.size() < 12 || memcmp(&d[0], "RIFF", 4) || memcmp(&d[8], "WAVE", 4)){
+        fprintf(stderr, "%s: not a WAV file\n", path);
+        return 0;
+    }
+    uint32_t channels = 0, bits = 0;
+    size_t   at = 12;
+    while(at + 8 <= d.size()){
+        uint32_t len = get32(&d[at+4]);
+        const uint8_t *body = &d[at+8];
+        size_t avail = std::min((size_t)len, d.size() - at - 8);
+
+        if(!memcmp(&d[at], "fmt ", 4) && avail >= 16){
+            channels = get16(body+2);
+            playRate = get32(body+4);
+            bits     = get16(body+14);
+            if(get16(body) != 1 || !channels || !playRate || (bits != 8 && bits != 16)){
+                fprintf(stderr, "%s: only 8 or 16 bit PCM\n", path);
+                return 0;
+            }
+        }else if(!memcmp(&d[at], "data", 4) && channels){
+            uint32_t step  = channels * bits / 8;
+            uint8_t  level = 0;
+            for(uint32_t s=0; (size_t)(s+1)*step <= avail; s++){
+                const uint8_t *p = body + s*step;
+                int v = bits == 8 ? p[0] - 128 : (int16_t)get16(p) >> 8;
+                if(v > CAS_HIGH) level = 1;
+                if(v < CAS_LOW)  level = 0;
+                add_level(s, level);
+            }
+            return 1;
+        }
+        at += 8 + len + (len & 1);
+    }
+    fprintf(stderr, "%s: no PCM data\n", path);
+    return 0;
+}
+
+int cas_play(const char *path){
+    FILE *f = fopen(path, "rb");
+    if(!f){
+        perror(path);
+        return 0;
+    }
+    std::vector<uint8_t> d;
+    int c;
+    while((c = fgetc(f)) != EOF) d.push_back(c);
+    fclose(f);
+
+    playEdges.clear();
+    rolling = 0;
+    if(ends_with(path, ".bit")){
+        playRate = CAS_RATE;
+        for(uint32_t s=0; s < d.size()*8; s++){
+            add_level(s, (d[s>>3] >> (s&7)) & 1);
+        }
+    }else if(!load_wav(d, path)){
+        return 0;
+    }
+    playing = 1;
+    return 1;
+}
+
+int cas_record(const char *path){
+    recPath = path;
+    recEdges.clear();
+    recQ = 0;
+    return 1;
+}
+
+// Cycle of sample s counted from first
+static uint64_t sample_cycle(uint64_t first, uint64_t s){
+    return first + s * CAS_CLOCK / (8ULL * CAS_RATE);
+}
+
+int cas_close(){
+    playing = 0;
+    if(!recPath) return 1;
+
+    FILE *f = fopen(recPath, "wb");
+    if(!f){
+        perror(recPath);
+        return 0;
+    }
+    int bitFile = ends_with(recPath, ".bit");
+    uint32_t pad = CAS_RATE / 2, total = 2*pad;
+    uint64_t first = recEdges.empty() ? 0 : recEdges[0];
+    if(!recEdges.empty()){
+        total += (recEdges.back() - first) * 8 * CAS_RATE / CAS_CLOCK + 1;
+    }
+    if(!bitFile){
+        fwrite("RIFF", 1, 4, f);
+        put32(f, 36 + total);
+        fwrite("WAVEfmt ", 1, 8, f);
+        put32(f, 16);
+        put16(f, 1);                // PCM
+        put16(f, 1);                // Mono
+        put32(f, CAS_RATE);
+        put32(f, CAS_RATE);         // Bytes per second
+        put16(f, 1);
+        put16(f, 8);
+        fwrite("data", 1, 4, f);
+        put32(f, total);
+    }
+
+    size_t  next = 0;
+    uint8_t acc  = 0;
+    for(uint32_t s=0; s<total; s++){
+        uint8_t level = 0;
+        if(s >= pad){
+            uint64_t c = sample_cycle(first, s - pad);
+            while(next < recEdges.size() && recEdges[next] <= c) next++;
+            level = next & 1;
+        }
+        if(bitFile){
+            acc |= level << (s&7);
+            if((s&7) == 7 || s == total-1){
+                fputc(acc, f);
+                acc = 0;
+            }
+        }else{
+            fputc(level ? 0xE0 : 0x20, f);
+        }
+    }
+    fclose(f);
+    recPath = NULL;
+    return 1;
+}
+
+/**************************** Tape ****************************/
+// Sample under cycle, -1 before the tape starts
+static int64_t sample_at(uint64_t cycle){
+    if(!rolling){
+        playStart = cycle;
+        rolling   = 1;
+    }
+    if(cycle < playStart) return -1;
+    return (int64_t)((cycle - playStart) * 8 * playRate / CAS_CLOCK);
+}
+
+void tape_q(uint64_t cycle, uint8_t q){
+    q = q ? 1 : 0;
+    if(!recPath || q == recQ) return;
+    recEdges.push_back(cycle);
+    recQ = q;
+}
+
+uint8_t tape_ef(uint64_t cycle){
+    if(!playing) return 0;
+    int64_t s = sample_at(cycle);
+    if(s < 0) return 0;
+    auto it = std::upper_bound(playEdges.begin(), playEdges.end(), (uint64_t)s,
+                               [](uint64_t v, uint32_t e){ return v < e; });
+    return (it - playEdges.begin()) & 1;
+}
+
+uint64_t tape_next_edge(uint64_t cycle){
+    if(!playing) return UINT64_MAX;
+    int64_t s = sample_at(cycle);
+    auto it = s < 0 ? playEdges.begin() :
+              std::upper_bound(playEdges.begin(), playEdges.end(), (uint64_t)s,
+                               [](uint64_t v, uint32_t e){ return v < e; });
+    if(it == playEdges.end()) return UINT64_MAX;
+    // The first cycle whose sample is the edge one
+    uint64_t num = (uint64_t)*it * CAS_CLOCK, den = 8ULL * playRate;
+    return playStart + (num + den - 1) / den;
+}
+
+/**************************** Board ****************************/
+static void cas_outputQ(Board *, uint8_t q){
+    tape_q(GET_CYCLES(), q);
+}
+
+static void cas_flags(Board *b){
+    if(playing) b->ef = (b->ef & ~2) | tape_ef(GET_CYCLES()) << 1;
+}
+
+void cas_attach(Board *b){
+    b->outputQ = cas_outputQ;
+    b->flags   = cas_flags;
+}
@@ -0,0 +1,35 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __CASSETTE_H__
+#define __CASSETTE_H__
+
+#include "hostio.h"
+
+/**
+ * Cassette recorder on Q and EF2, the tape_* side of tape.h
+ *
+ * Playback reads a WAV file, 8 or 16 bit PCM at any rate, first
+ * channel, or a .bit file: 1 bit samples at CAS_RATE, LSB first. The
+ * tape starts rolling the first time the program tests an EF line.
+ * Recording keeps the Q edges and writes them out on cas_close(),
+ * 8 bit WAV at CAS_RATE, or .bit, with half a second of silence on
+ * each side.
+ */
+#define CAS_CLOCK 1789773       // Crystal, a machine cycle is 8 clocks
+#define CAS_RATE  44100
+
+int  cas_play  (const char *path);      // 0 on error, printed
+int  cas_record(const char *path);
+int  cas_close ();                      // Writes the recording
+
+// Hooks Q and EF2 of the board
+void cas_attach(Board *b);
+
+#endif
@@ -0,0 +1,257 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+/**
+ * CHIP-8 benchmark, build it with -DELF_CHIP8
+ *
+ *   chip8bench [-c cycles] [-k keys] [-d] [program.ch8]
+ *
+ * Runs the program on the chip8.h interpreter twice from reset, once
+ * interpreting the interpreter and once natively, until IDL or the
+ * cycle limit, and prints both times. The keys, a hex mask, go down
+ * at the 8th frame so FX0A has to wait first. When both runs end on
+ * IDL the machines must be the same: cycles, 1802 instructions, the
+ * interpreter registers, Q and the whole memory. -d prints the display.
+ *
+ * Without a program a built-in one runs every instruction 64 times
+ * and ends with 0NNN on an IDL.
+ */
+#include <Arduino.h>
+#include <chrono>
+#include "cpu.h"
+#include "mem.h"
+#include "hostio.h"
+#include "pixie.h"
+#include "chip8.h"
+
+#ifndef ELF_CHIP8
+#error "chip8bench needs -DELF_CHIP8"
+#endif
+
+#define KEYS_FRAME 8
+
+static const uint8_t test[] = {
+    0x6E, 0x00,          // 200 VE = 0, the pass count
+    0x00, 0xE0,          // 202 CLS
+    0x60, 0x05,          // 204 V0 = 5
+    0x61, 0x17,          // 206 V1 = 17
+    0xA2, 0xB0,          // 208 I = sprite
+    0xD0, 0x15,          // 20A DRW V0, V1, 5
+    0xD0, 0x15,          // 20C DRW V0, V1, 5, collides
+    0x62, 0x3C,          // 20E V2 = 3C, the right edge
+    0x63, 0x1E,          // 210 V3 = 1E
+    0xD2, 0x35,          // 212 DRW V2, V3, 5, clipped
+    0xF0, 0x29,          // 214 LD F, V0
+    0xD0, 0x05,          // 216 DRW V0, V0, 5
+    0x30, 0x05,          // 218 SE V0, 05
+    0x64, 0x00,          // 21A LD V4, 00, skipped
+    0x40, 0x05,          // 21C SNE V0, 05
+    0x50, 0x10,          // 21E SE V0, V1
+    0x90, 0x10,          // 220 SNE V0, V1
+    0x64, 0x00,          // 222 LD V4, 00, skipped
+    0x74, 0x01,          // 224 ADD V4, 01
+    0x74, 0xFF,          // 226 ADD V4, FF
+    0x80, 0x10,          // 228 LD V0, V1
+    0x80, 0x11,          // 22A OR V0, V1
+    0x61, 0x99,          // 22C V1 = 99
+    0x80, 0x12,          // 22E AND V0, V1
+    0x80, 0x13,          // 230 XOR V0, V1
+    0x80, 0x14,          // 232 ADD V0, V1
+    0x80, 0x15,          // 234 SUB V0, V1
+    0x80, 0x16,          // 236 SHR V0, V1
+    0x80, 0x17,          // 238 SUBN V0, V1
+    0x80, 0x1E,          // 23A SHL V0, V1
+    0x80, 0x18,          // 23C undefined 8XY8
+    0xC0, 0xFF,          // 23E RND V0, FF
+    0xC1, 0x0F,          // 240 RND V1, 0F
+    0x60, 0x02,          // 242 V0 = 2
+    0xB2, 0x44,          // 244 JP V0, next
+    0x64, 0x00,          // 246 LD V4, 00, skipped
+    0x22, 0x90,          // 248 CALL sub
+    0xF5, 0x1E,          // 24A ADD I, V5
+    0xA2, 0xC0,          // 24C I = scratch
+    0x60, 0xFE,          // 24E V0 = FE
+    0xF0, 0x33,          // 250 LD B, V0
+    0xF3, 0x55,          // 252 LD [I], V3
+    0xA2, 0xC0,          // 254 I = scratch
+    0xF2, 0x65,          // 256 LD V2, [I]
+    0x02, 0xA0,          // 258 SYS code
+    0xF1, 0x0A,          // 25A LD V1, K, waits on the first pass
+    0x60, 0x07,          // 25C V0 = 7
+    0xE0, 0x9E,          // 25E SKP V0
+    0x64, 0x00,          // 260 LD V4, 00, skipped
+    0xE0, 0xA1,          // 262 SKNP V0
+    0x60, 0x03,          // 264 V0 = 3
+    0xE0, 0x9E,          // 266 SKP V0
+    0xE0, 0xA1,          // 268 SKNP V0
+    0x64, 0x00,          // 26A LD V4, 00, skipped
+    0xE0, 0xFF,          // 26C undefined EXFF
+    0xF0, 0xFF,          // 26E undefined FXFF
+    0x60, 0x03,          // 270 V0 = 3
+    0xF0, 0x15,          // 272 LD DT, V0
+    0xF0, 0x18,          // 274 LD ST, V0
+    0xF1, 0x07,          // 276 wait: LD V1, DT
+    0x31, 0x00,          // 278 SE V1, 00
+    0x12, 0x76,          // 27A JP wait
+    0x60, 0x01,          // 27C V0 = 1
+    0xF0, 0x18,          // 27E LD ST, V0, ends after the delay
+    0x7E, 0x01,          // 280 ADD VE, 01
+    0x3E, 0x40,          // 282 SE VE, 40
+    0x12, 0x02,          // 284 JP 202
+    0x02, 0xA4,          // 286 SYS IDL
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x65, 0x07, 0x00, 0xEE,                 // 290 sub: V5 = 7, RET
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00,
+    0xF8, 0x42, 0x52, 0xD4,                 // 2A0 code: LDI 42, STR 2, SEP 4
+    0x00,                                   // 2A4 IDL
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00,
+    0xF0, 0x81, 0xA5, 0x99, 0xFF            // 2B0 sprite
+};
+
+typedef struct Run{
+    double   ms;
+    uint64_t cycles;
+    uint64_t instructions;  // 1802 ones, a batch counts as those it stands for
+    uint8_t  idle;
+    uint16_t R[16];
+    uint8_t  Q;
+} Run;
+
+static Board    vip;
+static uint16_t keys;
+static uint8_t  image[MEM_SIZE];
+static uint8_t  after[MEM_SIZE];
+
+static void (*pixieFlags)(Board *b);
+
+static void vip_flags(Board *b){
+    pixieKeys = GET_CYCLES() >= (uint64_t)KEYS_FRAME*PIXIE_FRAME ? keys : 0;
+    pixieFlags(b);
+}
+
+static void run(Run *r, uint8_t native, uint64_t limit){
+    memcpy(mem, image, MEM_SIZE);
+    memset(&cpu, 0, sizeof(cpu));
+    board_init(&vip);
+    board = &vip;
+    pixie_attach(&vip);
+    pixieFlags = vip.flags;
+    vip.flags  = vip_flags;
+    cpu_reset();
+    chip8_enabled = native;
+    chip8_ops = 0;
+    chip8_instr = 0;
+
+    uint64_t n = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while(GET_CYCLES() < limit && !vip.idle){
+        cpu_execute();
+        n++;
+    }
+    r->ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    r->cycles = GET_CYCLES();
+    r->instructions = n + chip8_instr;
+    r->idle   = vip.idle;
+    r->Q      = cpu.Q;
+    memcpy(r->R, cpu.R, sizeof(r->R));
+}
+
+// The registers the interpreter keeps between instructions
+static int compare(const Run *a, const Run *b){
+    static const uint8_t kept[] = { 2, 5, 8, 9, 0xA, 0xB };
+    int bad = 0;
+
+    if(a->cycles != b->cycles){
+        printf("cycles %llu, native %llu\n", (unsigned long long)a->cycles, (unsigned long long)b->cycles);
+        bad = 1;
+    }
+    if(a->instructions != b->instructions){
+        printf("instructions %llu, native %llu\n", (unsigned long long)a->instructions,
+               (unsigned long long)b->instructions);
+        bad = 1;
+    }
+    for(uint8_t i=0; i<sizeof(kept); i++){
+        uint8_t n = kept[i];
+        if(a->R[n] != b->R[n]){
+            printf("R%X %04X, native %04X\n", n, a->R[n], b->R[n]);
+            bad = 1;
+        }
+    }
+    if(a->Q != b->Q){
+        printf("Q %u, native %u\n", a->Q, b->Q);
+        bad = 1;
+    }
+    for(uint32_t i=0; i<MEM_SIZE; i++){
+        if(after[i] != mem[i]){
+            printf("%04X %02X, native %02X\n", (unsigned)i, after[i], mem[i]);
+            bad = 1;
+            break;
+        }
+    }
+    return bad;
+}
+
+int main(int argc, char **argv){
+    uint64_t    limit = 100000000;
+    const char *path  = NULL;
+    int         display = 0;
+
+    keys = 1 << 7;
+    for(int i=1; i<argc; i++){
+        if(!strcmp(argv[i], "-c") && i+1<argc){
+            limit = strtoull(argv[++i], NULL, 0);
+        }else if(!strcmp(argv[i], "-k") && i+1<argc){
+            keys = strtoul(argv[++i], NULL, 16);
+        }else if(!strcmp(argv[i], "-d")){
+            display = 1;
+        }else if(argv[i][0] != '-' && !path){
+            path = argv[i];
+        }else{
+            fprintf(stderr, "usage: chip8bench [-c cycles] [-k keys] [-d] [program.ch8]\n");
+            return 1;
+        }
+    }
+
+    memset(mem, 0, MEM_SIZE);
+    chip8_load();
+    if(path){
+        FILE *f = fopen(path, "rb");
+        if(!f){
+            perror(path);
+            return 1;
+        }
+        fread(mem + CHIP8_PROG, 1, CHIP8_BASE - CHIP8_PROG, f);
+        fclose(f);
+    }else{
+        memcpy(mem + CHIP8_PROG, test, sizeof(test));
+    }
+    memcpy(image, mem, MEM_SIZE);
+
+    Run slow, fast;
+    run(&slow, 0, limit);
+    memcpy(after, mem, MEM_SIZE);
+    run(&fast, 1, limit);
+
+    printf("interpreted %10.2f ms %12llu cycles %12llu instructions%s\n", slow.ms,
+           (unsigned long long)slow.cycles, (unsigned long long)slow.instructions,
+           slow.idle ? " IDL" : "");
+    printf("native      %10.2f ms %12llu cycles %12llu instructions%s, %u CHIP-8 instructions\n",
+           fast.ms, (unsigned long long)fast.cycles, (unsigned long long)fast.instructions,
+           fast.idle ? " IDL" : "", chip8_ops);
+    printf("speedup     %10.2f\n", slow.ms / fast.ms);
+    if(display) pixie_draw(stdout, fast.R[0xB] >> 8);
+
+    if(slow.idle && fast.idle){
+        if(compare(&slow, &fast)) return 1;
+        printf("same machine at the end\n");
+    }
+    return 0;
+}
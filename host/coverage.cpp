@@ -0,0 +1,155 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include <math.h>
+#include "mem.h"
+#include "disasm.h"
+
+#ifndef ELF_COVERAGE
+#error coverage.cpp needs -DELF_COVERAGE
+#endif
+
+uint8_t  cov_flags[MEM_SIZE];
+uint32_t cov_count[MEM_SIZE];
+
+static uint8_t image[65536];    // disasm() wants a 64 KB image
+
+void cov_clear(){
+    memset(cov_flags, 0, sizeof(cov_flags));
+    memset(cov_count, 0, sizeof(cov_count));
+}
+
+static const char *flag_text(uint8_t f, char *s){
+    s[0] = f & COV_OP    ? 'x' : '-';
+    s[1] = f & COV_ARG   ? 'a' : '-';
+    s[2] = f & COV_READ  ? 'r' : '-';
+    s[3] = f & COV_WRITE ? 'w' : '-';
+    s[4] = 0;
+    return s;
+}
+
+/**
+ * Code as "aaaa  bytes  instruction  count  flags", data and
+ * untouched memory collapsed into ranges
+ */
+void cov_listing(FILE *f){
+    uint32_t used[4] = { 0, 0, 0, 0 };
+    char     fl[5];
+
+    for(uint32_t a=0; a<MEM_SIZE; a++){
+        image[a] = MEM_RD(a);
+        for(uint8_t b=0; b<4; b++){
+            if(cov_flags[a] & (1<<b)) used[b]++;
+        }
+    }
+    fprintf(f, "; %u opcode, %u operand, %u read and %u written bytes\n",
+            used[0], used[1], used[2], used[3]);
+    fprintf(f, "; flags: x opcode, a operand, r read, w write\n");
+
+    for(uint32_t a=0; a<MEM_SIZE; ){
+        uint8_t fa = cov_flags[a];
+
+        if(fa & COV_OP){
+            char    text[32], bytes[16];
+            uint8_t len = disasm(image, a, text);
+            char   *p = bytes;
+            for(uint8_t i=0; i<3; i++){
+                p += i < len ? sprintf(p, "%02X ", image[(a+i) & 0xFFFF]) : sprintf(p, "   ");
+            }
+            fprintf(f, "%04X  %s %-16s %10u  %s\n", (unsigned)a, bytes, text,
+                    cov_count[a], flag_text(fa, fl));
+            a += len;
+            continue;
+        }
+
+        // Run of addresses used the same way, or not used at all
+        uint32_t end   = a;
+        uint64_t count = 0;
+        while(end < MEM_SIZE && cov_flags[end] == fa){
+            count += cov_count[end++];
+        }
+        if(fa){
+            fprintf(f, "%04X-%04X  data %38llu  %s\n", (unsigned)a, (unsigned)end-1,
+                    (unsigned long long)count, flag_text(fa, fl));
+        }else{
+            fprintf(f, "%04X-%04X  ....\n", (unsigned)a, (unsigned)end-1);
+        }
+        a = end;
+    }
+}
+
+static uint32_t max_count(){
+    uint32_t m = 1;
+    for(uint32_t a=0; a<MEM_SIZE; a++){
+        if(cov_count[a] > m) m = cov_count[a];
+    }
+    return m;
+}
+
+static uint8_t page_used(uint32_t page){
+    for(uint32_t a=page; a<page+256 && a<MEM_SIZE; a++){
+        if(cov_flags[a]) return 1;
+    }
+    return 0;
+}
+
+// 0 for untouched, then 1..levels-1 on a log scale
+static int level(uint64_t count, uint32_t max, int levels){
+    if(!count) return 0;
+    int l = 1 + (int)((levels-2) * log((double)count) / log((double)max + 1) + 0.5);
+    return l < levels ? l : levels-1;
+}
+
+void cov_heatmap_text(FILE *f){
+    static const char shades[] = " .:-=+*#%@";
+    uint32_t max = max_count();
+
+    fprintf(f, "; one character per 4 bytes, log scale up to %u accesses\n", max);
+    for(uint32_t page=0; page<MEM_SIZE; page+=256){
+        if(!page_used(page)) continue;
+        fprintf(f, "%04X |", (unsigned)page);
+        for(uint32_t a=page; a<page+256 && a<MEM_SIZE; a+=4){
+            uint32_t m = 0;
+            for(uint32_t i=a; i<a+4; i++){
+                if(cov_count[i] > m) m = cov_count[i];
+            }
+            fputc(shades[level(m, max, sizeof(shades)-1)], f);
+        }
+        fprintf(f, "|\n");
+    }
+}
+
+void cov_heatmap_html(FILE *f){
+    uint32_t max = max_count();
+    char     fl[5];
+
+    fprintf(f, "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><title>1802 heatmap</title>\n"
+               "<style>body{font:12px monospace} table{border-collapse:collapse}"
+               " td{width:4px;height:12px;padding:0} th{padding-right:6px}</style>\n"
+               "</head><body>\n<p>Accesses per byte, log scale up to %u. "
+               "Red is code, blue is data.</p>\n<table>\n", max);
+    for(uint32_t page=0; page<MEM_SIZE; page+=256){
+        if(!page_used(page)) continue;
+        fprintf(f, "<tr><th>%04X</th>", (unsigned)page);
+        for(uint32_t a=page; a<page+256 && a<MEM_SIZE; a++){
+            if(!cov_flags[a]){
+                fprintf(f, "<td></td>");
+                continue;
+            }
+            int l = 55 + level(cov_count[a], max, 201);
+            int code = cov_flags[a] & (COV_OP|COV_ARG);
+            fprintf(f, "<td style=\"background:rgb(%d,%d,%d)\" title=\"%04X %u %s\"></td>",
+                    code ? l : 40, 40, code ? 40 : l, (unsigned)a, cov_count[a],
+                    flag_text(cov_flags[a], fl));
+        }
+        fprintf(f, "</tr>\n");
+    }
+    fprintf(f, "</table>\n</body></html>\n");
+}
@@ -0,0 +1,78 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <stdio.h>
+#include "disasm.h"
+
+// I = 0 .. F, opcodes with N as register or port
+static const char *groups[16] = {
+    "LDN", "INC", "DEC", NULL, "LDA", "STR", NULL, NULL,
+    "GLO", "GHI", "PLO", "PHI", NULL, "SEP", "SEX", NULL
+};
+
+static const char *short3[16] = {
+    "BR",  "BQ",  "BZ",  "BDF", "B1",  "B2",  "B3",  "B4",
+    "SKP", "BNQ", "BNZ", "BNF", "BN1", "BN2", "BN3", "BN4"
+};
+
+static const char *ops7[16] = {
+    "RET",  "DIS",  "LDXA", "STXD", "ADC",  "SDB",  "SHRC", "SMB",
+    "SAV",  "MARK", "REQ",  "SEQ",  "ADCI", "SDBI", "SHLC", "SMBI"
+};
+
+static const char *opsC[16] = {
+    "LBR",  "LBQ",  "LBZ",  "LBDF", "NOP",  "LSNQ", "LSNZ", "LSNF",
+    "LSKP", "LBNQ", "LBNZ", "LBNF", "LSIE", "LSQ",  "LSZ",  "LSDF"
+};
+
+static const char *opsF[16] = {
+    "LDX",  "OR",   "AND",  "XOR",  "ADD",  "SD",   "SHR",  "SM",
+    "LDI",  "ORI",  "ANI",  "XRI",  "ADI",  "SDI",  "SHL",  "SMI"
+};
+
+uint8_t op_length(uint8_t op){
+    uint8_t i = op>>4, n = op&0x0F;
+    if(i == 0x3) return 2;
+    if(i == 0xC) return (n<=3 || (n>=9 && n<=0xB)) ? 3 : 1;
+    if(op == 0x7C || op == 0x7D || op == 0x7F) return 2;
+    if(i == 0xF && n >= 8 && n != 0xE) return 2;
+    return 1;
+}
+
+uint8_t disasm(const uint8_t *m, uint16_t addr, char *line){
+    uint8_t op = m[addr];
+    uint8_t b1 = m[(uint16_t)(addr+1)];
+    uint8_t b2 = m[(uint16_t)(addr+2)];
+    uint8_t i  = op>>4, n = op&0x0F;
+    uint8_t len = op_length(op);
+
+    if(op == 0x00){
+        sprintf(line, "IDL");
+    }else if(groups[i]){
+        sprintf(line, "%s R%X", groups[i], n);
+    }else if(i == 0x3){
+        sprintf(line, n==8 ? "%s" : "%s %04X", short3[n],
+                ((addr+1)&0xFF00) | b1);
+    }else if(i == 0x6){
+        if(n == 0)      sprintf(line, "IRX");
+        else if(n < 8)  sprintf(line, "OUT %d", n);
+        else if(n == 8) sprintf(line, "DB 68");
+        else            sprintf(line, "INP %d", n&7);
+    }else if(i == 0x7){
+        if(len == 2) sprintf(line, "%s %02X", ops7[n], b1);
+        else         sprintf(line, "%s", ops7[n]);
+    }else if(i == 0xC){
+        if(len == 3) sprintf(line, "%s %02X%02X", opsC[n], b1, b2);
+        else         sprintf(line, "%s", opsC[n]);
+    }else{
+        if(len == 2) sprintf(line, "%s %02X", opsF[n], b1);
+        else         sprintf(line, "%s", opsF[n]);
+    }
+    return len;
+}
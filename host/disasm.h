@@ -0,0 +1,24 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __DISASM_H__
+#define __DISASM_H__
+
+#include <stdint.h>
+
+// Instruction length in bytes
+uint8_t op_length(uint8_t opcode);
+
+/**
+ * Disassembles the instruction at addr of the 64 KB image m.
+ * line gets "MNEMONIC operand", returns the instruction length.
+ */
+uint8_t disasm(const uint8_t *m, uint16_t addr, char *line);
+
+#endif
@@ -0,0 +1,481 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+/**
+ * 1802 to C static translator
+ *
+ *   elf2c image.bin [-e addr[:P]]... > image.c
+ *
+ * Code is discovered from 0000 with P=0 and from every -e entry.
+ * Each basic block becomes one C function specialized for its P,
+ * SEP and RET go back to the trampoline in x2crun.cpp, which looks
+ * up the next block by R(P) or runs cpu_execute() when there is none.
+ * The statements mirror cpuExecute.cpp so registers, memory and
+ * cycles match the interpreter bit for bit.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "disasm.h"
+
+#define MAX_BLOCK 48
+
+typedef struct Entry{
+    uint16_t addr;
+    uint8_t  p;
+} Entry;
+
+typedef struct Block{
+    uint16_t addr;
+    uint16_t last;
+    uint8_t  p;
+    uint16_t cycles;
+} Block;
+
+static uint8_t  image[65536];
+static uint8_t  queued[16][8192];   // (P, addr) already in the work list
+static uint8_t  code[8192];         // Translated bytes
+static std::vector<Entry> work;
+static std::vector<Block> blocks;
+
+/**************************** Block state ****************************/
+static FILE       *out;
+static std::string body;
+static uint8_t     P;
+static int         pcStored;        // Value held by R(P) in the generated code
+static int         cy;              // Cycles not added yet
+static uint8_t     lastop;
+static int         xk;              // Known X or -1
+static int         dval;            // Known D or -1
+static int         rhi[16], rlo[16];
+
+static void add_entry(uint16_t addr, uint8_t p){
+    if(queued[p][addr>>3] & (1<<(addr&7))) return;
+    queued[p][addr>>3] |= 1<<(addr&7);
+    Entry e = { addr, p };
+    work.push_back(e);
+}
+
+static void emit(const char *fmt, ...){
+    char    line[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    body += "    ";
+    body += line;
+    body += "\n";
+}
+
+static void materialize(uint16_t pc){
+    if(pcStored != pc){
+        emit("cpu.R[%d] = 0x%04X;", P, pc);
+        pcStored = pc;
+    }
+}
+
+/**
+ * Leaves the block, pc < 0 means R(P) is already right at run time
+ */
+static std::string exit_str(int pc){
+    char s[160];
+    int  n = 0;
+    n += sprintf(s+n, "{ ");
+    if(pc >= 0 && pc != pcStored) n += sprintf(s+n, "cpu.R[%d] = 0x%04X; ", P, pc);
+    sprintf(s+n, "cpu.I = 0x%X; cpu.N = 0x%X; ADD_CYCLES(%d); return; }",
+            lastop>>4, lastop&0x0F, cy);
+    return s;
+}
+
+static void emit_exit(int pc){
+    emit("%s", exit_str(pc).c_str());
+}
+
+/**
+ * Before a device hook: R(P), I, N and cycles as the interpreter
+ * has them while it executes the instruction at 'a'
+ */
+static void sync(uint16_t a, uint8_t op, int c){
+    materialize(a+1);
+    if(cy - c) emit("ADD_CYCLES(%d);", cy - c);
+    cy = c;
+    emit("cpu.I = 0x%X; cpu.N = 0x%X;", op>>4, op&0x0F);
+}
+
+static void smc_check(uint16_t next){
+    emit("if(x2c_smc) %s", exit_str(next).c_str());
+}
+
+static void unknown_x_check(){
+    if(xk < 0) emit("if(cpu.X == %d) %s", P, exit_str(-1).c_str());
+}
+
+static int d_kept(uint8_t op){
+    uint8_t i = op>>4;
+    return i==0x1 || i==0x2 || i==0x3 || i==0x5 || i==0xA || i==0xB ||
+           i==0xC || i==0xD || i==0xE ||
+           (op>=0x60 && op<=0x68) || op==0x78 || op==0x79 || op==0x7A || op==0x7B;
+}
+
+static void forget_reg(int n){
+    if(n < 0){
+        for(int i=0; i<16; i++) rhi[i] = rlo[i] = -1;
+    }else{
+        rhi[n] = rlo[n] = -1;
+    }
+}
+
+/**
+ * Translates one instruction, returns 0 when the block ends there
+ */
+static int translate(uint16_t a){
+    uint8_t  op = image[a];
+    uint8_t  b1 = image[(uint16_t)(a+1)];
+    uint8_t  n  = op&0x0F;
+    uint8_t  len = op_length(op);
+    uint16_t next = a+len;
+    int      c  = (op>>4)==0xC ? 3 : 2;
+    int      cont = 1;
+    char     dis[32];
+
+    disasm(image, a, dis);
+    emit("// %04X  %s", a, dis);
+    cy += c;
+    lastop = op;
+    for(int i=0; i<len; i++){
+        uint16_t b = a+i;
+        code[b>>3] |= 1<<(b&7);
+    }
+
+    switch(op>>4){
+        case 0x0:   // LDN
+            if(n == P) materialize(a+1);
+            emit("cpu.D = RD_M(cpu.R[%d]);", n);
+        break;
+
+        case 0x1:   // INC
+        case 0x2:   // DEC
+            if(n == P) materialize(a+1);
+            emit(op>>4==1 ? "cpu.R[%d]++;" : "cpu.R[%d]--;", n);
+            forget_reg(n);
+            if(n == P){ emit_exit(-1); add_entry(next, P); cont = 0; }
+        break;
+
+        case 0x3: { // Short branches
+            uint16_t target = ((a+1)&0xFF00) | b1;
+            static const char *cond[16] = {
+                NULL, "cpu.Q", "cpu.D==0x00", "cpu.DF",
+                "cpu.EF1", "cpu.EF2", "cpu.EF3", "cpu.EF4",
+                NULL, "!cpu.Q", "cpu.D!=0x00", "!cpu.DF",
+                "!cpu.EF1", "!cpu.EF2", "!cpu.EF3", "!cpu.EF4"
+            };
+            if((n&0x7) >= 4){
+                sync(a, op, c);
+                emit("cpu_testFlags();");
+            }
+            if(n == 0){
+                emit_exit(target);
+                add_entry(target, P);
+            }else if(n == 8){
+                emit_exit(next);
+                add_entry(next, P);
+            }else{
+                emit("if(%s) %s", cond[n], exit_str(target).c_str());
+                emit_exit(next);
+                add_entry(target, P);
+                add_entry(next, P);
+            }
+            cont = 0;
+        } break;
+
+        case 0x4:   // LDA
+            if(n == P) materialize(a+1);
+            emit("cpu.D = RD_M(cpu.R[%d]);", n);
+            emit("cpu.R[%d]++;", n);
+            forget_reg(n);
+            if(n == P){ emit_exit(-1); add_entry(a+2, P); cont = 0; }
+        break;
+
+        case 0x5:   // STR
+            if(n == P) materialize(a+1);
+            emit("WR_M(cpu.R[%d], cpu.D);", n);
+            smc_check(next);
+        break;
+
+        case 0x6:
+            if(xk < 0 || xk == P) materialize(a+1);
+            if(n == 0){                             // IRX
+                emit("cpu.R[cpu.X]++;");
+            }else if(n < 8){                        // OUT
+                sync(a, op, c);
+                emit("cpu_output(RD_M(cpu.R[cpu.X]), %d);", n);
+                emit("cpu.R[cpu.X]++;");
+            }else if(n == 8){
+                break;
+            }else{                                  // INP
+                sync(a, op, c);
+                emit("{ uint8_t bus8 = cpu_input(%d);", n&0b111);
+                emit("  WR_M(cpu.R[cpu.X], bus8);");
+                emit("  cpu.D = bus8; }");
+                smc_check(next);
+                break;
+            }
+            if(xk == P){ emit_exit(-1); add_entry(a+2, P); cont = 0; }
+            else{
+                unknown_x_check();
+                if(xk >= 0) forget_reg(xk);
+            }
+        break;
+
+        case 0x7:
+            switch(n){
+                case 0x0: case 0x1:                 // RET, DIS
+                    materialize(a+1);
+                    emit("{ uint16_t bkp16 = RD_M(cpu.R[cpu.X]);");
+                    emit("  cpu.X = (bkp16>>4) & 0x0F;");
+                    emit("  cpu.P =  bkp16     & 0x0F;");
+                    emit("  cpu.R[cpu.X]++;");
+                    emit("  cpu.IE = %d; }", n==0);
+                    emit_exit(-1);
+                    cont = 0;
+                break;
+
+                case 0x2: case 0x3:                 // LDXA, STXD
+                    if(xk < 0 || xk == P) materialize(a+1);
+                    if(n == 2){
+                        emit("cpu.D = RD_M(cpu.R[cpu.X]);");
+                    }else{
+                        emit("WR_M(cpu.R[cpu.X], cpu.D);");
+                    }
+                    emit(n == 2 ? "cpu.R[cpu.X]++;" : "cpu.R[cpu.X]--;");
+                    if(xk == P){ emit_exit(-1); add_entry(n == 2 ? a+2 : a, P); cont = 0; break; }
+                    if(n == 3) smc_check(next);
+                    unknown_x_check();
+                    if(xk >= 0) forget_reg(xk);
+                break;
+
+                case 0x4: case 0x5: case 0x7:       // ADC, SDB, SMB
+                    if(xk < 0 || xk == P) materialize(a+1);
+                    emit(n==4 ? "alu_add(RD_M(cpu.R[cpu.X]), cpu.D, cpu.DF);" :
+                         n==5 ? "alu_sub(RD_M(cpu.R[cpu.X]), cpu.D, cpu.DF);" :
+                                "alu_sub(cpu.D, RD_M(cpu.R[cpu.X]), cpu.DF);");
+                break;
+
+                case 0x6: emit("alu_shr(cpu.DF);"); break;
+                case 0xE: emit("alu_shl(cpu.DF);"); break;
+
+                case 0x8:                           // SAV
+                    if(xk < 0 || xk == P) materialize(a+1);
+                    emit("WR_M(cpu.R[cpu.X], cpu.T);");
+                    smc_check(next);
+                break;
+
+                case 0x9:                           // MARK
+                    if(P == 2) materialize(a+1);
+                    emit("cpu.T = (cpu.X<<4) | %d;", P);
+                    emit("WR_M(cpu.R[2], cpu.T);");
+                    emit("cpu.X = %d;", P);
+                    emit("cpu.R[2]--;");
+                    xk = P;
+                    forget_reg(2);
+                    if(P == 2){ emit_exit(-1); cont = 0; break; }
+                    smc_check(next);
+                break;
+
+                case 0xA: case 0xB:                 // REQ, SEQ
+                    emit("cpu.Q = %d;", n==0xB);
+                    sync(a, op, c);
+                    emit("cpu_outputQ();");
+                break;
+
+                case 0xC: emit("alu_add(0x%02X, cpu.D, cpu.DF);", b1); break;
+                case 0xD: emit("alu_sub(0x%02X, cpu.D, cpu.DF);", b1); break;
+                case 0xF: emit("alu_sub(cpu.D, 0x%02X, cpu.DF);", b1); break;
+            }
+        break;
+
+        case 0x8:   // GLO
+        case 0x9:   // GHI
+            if(n == P) materialize(a+1);
+            emit(op>>4==8 ? "cpu.D = GET_R_LOW(%d);" : "cpu.D = GET_R_HIGH(%d);", n);
+        break;
+
+        case 0xA:   // PLO
+        case 0xB:   // PHI
+            if(n == P) materialize(a+1);
+            emit(op>>4==0xA ? "SET_R_LOW(%d, cpu.D);" : "SET_R_HIGH(%d, cpu.D);", n);
+            if(op>>4 == 0xA) rlo[n] = dval; else rhi[n] = dval;
+            if(n == P){ forget_reg(n); emit_exit(-1); cont = 0; }
+        break;
+
+        case 0xC: { // Long branches and skips
+            static const char *cond[16] = {
+                "1", "cpu.Q", "cpu.D==0", "cpu.DF", NULL, "!cpu.Q", "cpu.D!=0", "!cpu.DF",
+                "1", "!cpu.Q", "cpu.D!=0", "!cpu.DF", "!cpu.IE", "cpu.Q", "cpu.D==0", "cpu.DF"
+            };
+            if(n == 4) break;                       // NOP
+            materialize(a+1);
+            if(len == 3){
+                emit("if(%s){", cond[n]);
+                emit("    uint16_t bkp16 = RD_M(cpu.R[%d]) << 8;", P);
+                emit("    cpu.R[%d] = bkp16 | RD_M(cpu.R[%d]+1);", P, P);
+                emit("}else{");
+                emit("    cpu.R[%d]+=2;", P);
+                emit("}");
+                add_entry((uint16_t)b1<<8 | image[(uint16_t)(a+2)], P);
+                if(n) add_entry(a+3, P);
+            }else{
+                emit("if(%s) cpu.R[%d]+=2;", cond[n], P);
+                add_entry(a+1, P);
+                add_entry(a+3, P);
+            }
+            emit_exit(-1);
+            cont = 0;
+        } break;
+
+        case 0xD:   // SEP
+            materialize(a+1);
+            emit("cpu.P = %d;", n);
+            emit_exit(-1);
+            add_entry(a+1, P);
+            if(rhi[n] >= 0 && rlo[n] >= 0) add_entry((rhi[n]<<8) | rlo[n], n);
+            cont = 0;
+        break;
+
+        case 0xE:   // SEX
+            emit("cpu.X = %d;", n);
+            xk = n;
+        break;
+
+        case 0xF:
+            if(n < 8 && n != 6 && (xk < 0 || xk == P)) materialize(a+1);
+            switch(n){
+                case 0x0: emit("cpu.D = RD_M(cpu.R[cpu.X]);");  break;
+                case 0x1: emit("cpu.D |= RD_M(cpu.R[cpu.X]);"); break;
+                case 0x2: emit("cpu.D &= RD_M(cpu.R[cpu.X]);"); break;
+                case 0x3: emit("cpu.D ^= RD_M(cpu.R[cpu.X]);"); break;
+                case 0x4: emit("alu_add(RD_M(cpu.R[cpu.X]), cpu.D, 0);"); break;
+                case 0x5: emit("alu_sub(RD_M(cpu.R[cpu.X]), cpu.D, 1);"); break;
+                case 0x6: emit("alu_shr(0);"); break;
+                case 0x7: emit("alu_sub(cpu.D, RD_M(cpu.R[cpu.X]), 1);"); break;
+                case 0x8: emit("cpu.D = 0x%02X;", b1);  break;
+                case 0x9: emit("cpu.D |= 0x%02X;", b1); break;
+                case 0xA: emit("cpu.D &= 0x%02X;", b1); break;
+                case 0xB: emit("cpu.D ^= 0x%02X;", b1); break;
+                case 0xC: emit("alu_add(0x%02X, cpu.D, 0);", b1); break;
+                case 0xD: emit("alu_sub(0x%02X, cpu.D, 1);", b1); break;
+                case 0xE: emit("alu_shl(0);"); break;
+                case 0xF: emit("alu_sub(cpu.D, 0x%02X, 1);", b1); break;
+            }
+        break;
+    }
+
+    if(op == 0xF8)        dval = b1;
+    else if(!d_kept(op))  dval = -1;
+    return cont;
+}
+
+static void translate_block(uint16_t start, uint8_t p){
+    uint16_t a = start;
+    int      count = 0, total = 0, cont = 1;
+
+    if(image[start] == 0x00) return;        // IDL stays in the interpreter
+
+    body.clear();
+    P        = p;
+    pcStored = start;
+    cy       = 0;
+    xk       = -1;
+    dval     = -1;
+    forget_reg(-1);
+
+    while(cont){
+        uint8_t len = op_length(image[a]);
+        if(count == MAX_BLOCK || image[a] == 0x00 || (uint32_t)a+len > 0xFFFF){
+            emit_exit(a);
+            add_entry(a, P);
+            break;
+        }
+        cont = translate(a);
+        total += (image[a]>>4)==0xC ? 3 : 2;
+        a += len;
+        count++;
+    }
+
+    Block b = { start, (uint16_t)(a-1), p, (uint16_t)total };
+    blocks.push_back(b);
+    fprintf(out, "static void x2c_%X_%04X(void){\n%s}\n\n", p, start, body.c_str());
+}
+
+static int load_image(const char *path){
+    FILE *f = fopen(path, "rb");
+    if(!f){
+        perror(path);
+        return 0;
+    }
+    fread(image, 1, sizeof(image), f);
+    fclose(f);
+    return 1;
+}
+
+int main(int argc, char **argv){
+    const char *path = NULL;
+
+    out = stdout;
+    for(int i=1; i<argc; i++){
+        unsigned addr, p = 0;
+        if(!strcmp(argv[i], "-e") && i+1<argc){
+            if(sscanf(argv[++i], "%x:%x", &addr, &p) < 1 || addr > 0xFFFF || p > 15){
+                fprintf(stderr, "bad entry %s\n", argv[i]);
+                return 1;
+            }
+            add_entry(addr, p);
+        }else if(!path){
+            path = argv[i];
+        }else{
+            path = NULL;
+            break;
+        }
+    }
+    if(!path){
+        fprintf(stderr, "usage: elf2c image.bin [-e addr[:P]]... > image.c\n");
+        return 1;
+    }
+    if(!load_image(path)) return 1;
+    add_entry(0x0000, 0);
+
+    fprintf(out, "/* Generated by elf2c from %s */\n", path);
+    fprintf(out, "#include <Arduino.h>\n#include \"cpu.h\"\n#include \"mem.h\"\n"
+                 "#include \"io.h\"\n#include \"alu.h\"\n#include \"x2c.h\"\n\n");
+
+    for(size_t i=0; i<work.size(); i++){
+        translate_block(work[i].addr, work[i].p);
+    }
+
+    fprintf(out, "const X2cBlock x2c_blocks[] = {\n");
+    for(size_t i=0; i<blocks.size(); i++){
+        Block &b = blocks[i];
+        fprintf(out, "    { 0x%04X, 0x%04X, %d, %d, x2c_%X_%04X },\n",
+                b.addr, b.last, b.p, b.cycles, b.p, b.addr);
+    }
+    fprintf(out, "    { 0, 0, 0, 0, 0 }\n};\n");
+    fprintf(out, "const uint16_t x2c_nblocks = %u;\n\n", (unsigned)blocks.size());
+
+    fprintf(out, "const uint8_t x2c_code[8192] = {");
+    for(int i=0; i<8192; i++){
+        fprintf(out, "%s0x%02X,", i%16 ? "" : "\n    ", code[i]);
+    }
+    fprintf(out, "\n};\n");
+
+    fprintf(stderr, "%u blocks\n", (unsigned)blocks.size());
+    return 0;
+}
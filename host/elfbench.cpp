@@ -0,0 +1,217 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+/**
+ * Emulator microbenchmarks
+ *
+ *   elfbench [-n iterations] [-o results.csv] [-s]
+ *
+ * Every one of the 256 opcodes runs through cpu_execute() from the
+ * same machine state, then a few representative sequences run until
+ * their cycle budget is spent. Results go to a CSV file:
+ *
+ *   kind,name,opcode,instructions,ns_per_instr
+ *
+ * so runs before and after a change can be diffed. -s turns the
+ * SCRT acceleration off, instructions run natively are counted
+ * one by one either way.
+ */
+#include <Arduino.h>
+#include <chrono>
+#include "cpu.h"
+#include "mem.h"
+#include "hostio.h"
+#include "disasm.h"
+#include "scrt.h"
+
+#define CODE_ADDR 0x1000
+#define DATA_ADDR 0x2000
+
+typedef struct Sequence{
+    const char    *name;
+    const uint8_t *code;
+    uint16_t       size;
+} Sequence;
+
+// SCRT call and return of an empty subroutine, CALL at 0041, RETURN at 0051
+static const uint8_t scrt[] = {
+    0xF8, 0x01, 0xB2, 0xF8, 0xFF, 0xA2,     // 0000 R2 = 01FF stack
+    0xF8, 0x00, 0xB4, 0xF8, 0x41, 0xA4,     // 0006 R4 = CALL
+    0xF8, 0x00, 0xB5, 0xF8, 0x51, 0xA5,     // 000C R5 = RETURN
+    0xF8, 0x00, 0xB3, 0xF8, 0x19, 0xA3,     // 0012 R3 = main
+    0xD3,                                   // 0018 SEP 3
+    0xD4, 0x00, 0x1E,                       // 0019 main: CALL sub
+    0x30, 0x19,                             // 001C BR main
+    0xD5,                                   // 001E sub: RETURN
+    0x00,                                   // 001F
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xD3,                                   // 0040 SEP 3
+    0xE2, 0x96, 0x73, 0x86, 0x73,           // 0041 CALL: SEX 2, GHI 6, STXD, GLO 6, STXD
+    0x93, 0xB6, 0x83, 0xA6,                 // 0046 GHI 3, PHI 6, GLO 3, PLO 6
+    0x46, 0xB3, 0x46, 0xA3,                 // 004A LDA 6, PHI 3, LDA 6, PLO 3
+    0x30, 0x40,                             // 004E BR 40
+    0xD3,                                   // 0050 SEP 3
+    0x96, 0xB3, 0x86, 0xA3,                 // 0051 RETURN: GHI 6, PHI 3, GLO 6, PLO 3
+    0xE2, 0x12, 0x72, 0xA6, 0xF0, 0xB6,     // 0055 SEX 2, INC 2, LDXA, PLO 6, LDX, PHI 6
+    0x30, 0x50                              // 005B BR 50
+};
+
+// 16 bits add loop, R8 += 3412 until R7 gets back to zero
+static const uint8_t add16[] = {
+    0xF8, 0x00, 0xB2, 0xF8, 0x1C, 0xA2,     // 0000 R2 = addend
+    0xE2,                                   // 0006 SEX 2
+    0xF8, 0x00, 0xB7, 0xA7,                 // 0007 R7 = 0000
+    0x88, 0xF4, 0xA8,                       // 000B GLO 8, ADD, PLO 8
+    0x12, 0x98, 0x74, 0xB8, 0x22,           // 000E INC 2, GHI 8, ADC, PHI 8, DEC 2
+    0x27, 0x97, 0x3A, 0x0B,                 // 0013 DEC 7, GHI 7, BNZ 0B
+    0x87, 0x3A, 0x0B,                       // 0017 GLO 7, BNZ 0B
+    0x30, 0x07,                             // 001A BR 07
+    0x12, 0x34                              // 001C addend
+};
+
+// Table lookup, M(RB) = table[R7.0 & 0F] through a computed pointer
+static const uint8_t table[] = {
+    0xF8, 0x00, 0xBA,                       // 0000 RA.1 = table
+    0xF8, 0x02, 0xBB,                       // 0003 RB.1 = 02
+    0x17, 0x87, 0xFA, 0x0F,                 // 0006 INC 7, GLO 7, ANI 0F
+    0xFC, 0x11, 0xAA,                       // 000A ADI 11, PLO A
+    0x0A, 0x5B,                             // 000D LDN A, STR B
+    0x30, 0x06,                             // 000F BR 06
+    0x10, 0x20, 0x30, 0x40, 0x50, 0x60, 0x70, 0x80,  // 0011 table
+    0x90, 0xA0, 0xB0, 0xC0, 0xD0, 0xE0, 0xF0, 0xFF
+};
+
+static const Sequence sequences[] = {
+    { "scrt_call_return", scrt,  sizeof(scrt)  },
+    { "add16_loop",       add16, sizeof(add16) },
+    { "table_lookup",     table, sizeof(table) },
+};
+
+static Board    elf;
+static uint16_t regs[16];
+
+/**
+ * Machine state every opcode starts from: P=0 pointing to the
+ * opcode, X=2 and the other registers in the data area
+ */
+static void opcode_state(){
+    cpu.P = 0;
+    cpu.X = 2;
+    memcpy(cpu.R, regs, sizeof(regs));
+    elf.idle = 0;
+}
+
+static double ns_since(std::chrono::steady_clock::time_point t0){
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static double bench_opcode(int op, long iterations){
+    memset(mem, 0, MEM_SIZE);
+    mem[CODE_ADDR]   = op;
+    mem[CODE_ADDR+1] = 0x10;
+    mem[CODE_ADDR+2] = 0x04;
+    for(int i=0; i<16; i++){
+        mem[DATA_ADDR + i] = 0x21 + i;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    if(op < 0){
+        for(long i=0; i<iterations; i++){
+            opcode_state();
+            asm volatile("" ::: "memory");
+        }
+    }else{
+        for(long i=0; i<iterations; i++){
+            opcode_state();
+            cpu_execute();
+        }
+    }
+    return ns_since(t0) / iterations;
+}
+
+static double bench_sequence(const Sequence *s, uint64_t cycles, uint64_t *count){
+    uint64_t n = 0;
+
+    memset(mem, 0, MEM_SIZE);
+    memcpy(mem, s->code, s->size);
+    memset(&cpu, 0, sizeof(cpu));
+    cpu_reset();
+    elf.idle = 0;
+    scrt_calls = scrt_returns = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    while(GET_CYCLES() < cycles && !elf.idle){
+        cpu_execute();
+        n++;
+    }
+    // Each native routine was one cpu_execute() for its SEP
+    n += scrt_calls   * SCRT_CALL_INSTR;
+    n += scrt_returns * SCRT_RETURN_INSTR;
+    *count = n;
+    return ns_since(t0) / n;
+}
+
+int main(int argc, char **argv){
+    long        iterations = 2000000;
+    const char *path = "elfbench.csv";
+
+    for(int i=1; i<argc; i++){
+        if(!strcmp(argv[i], "-n") && i+1<argc){
+            iterations = atol(argv[++i]);
+        }else if(!strcmp(argv[i], "-o") && i+1<argc){
+            path = argv[++i];
+        }else if(!strcmp(argv[i], "-s")){
+            scrt_enabled = 0;
+        }else{
+            fprintf(stderr, "usage: elfbench [-n iterations] [-o results.csv] [-s]\n");
+            return 1;
+        }
+    }
+
+    FILE *f = fopen(path, "w");
+    if(!f){
+        perror(path);
+        return 1;
+    }
+    fprintf(f, "kind,name,opcode,instructions,ns_per_instr,clocks_per_instr\n");
+
+    board_init(&elf);
+    board = &elf;
+    memset(&cpu, 0, sizeof(cpu));
+    regs[0] = CODE_ADDR;
+    for(int i=1; i<16; i++){
+        regs[i] = DATA_ADDR + i;
+    }
+
+    double overhead = bench_opcode(-1, iterations);
+    double total = 0;
+    printf("state reset overhead %.2f ns\n", overhead);
+    for(int op=0; op<256; op++){
+        char   name[32];
+        double ns = bench_opcode(op, iterations) - overhead;
+        disasm(mem, CODE_ADDR, name);
+        fprintf(f, "opcode,%s,%02X,%ld,%.3f,\n", name, op, iterations, ns);
+        total += ns;
+    }
+    printf("256 opcodes, mean %.2f ns per instruction\n", total/256);
+
+    for(size_t i=0; i<sizeof(sequences)/sizeof(sequences[0]); i++){
+        uint64_t count;
+        double   ns = bench_sequence(&sequences[i], (uint64_t)iterations*20, &count);
+        fprintf(f, "sequence,%s,,%llu,%.3f,\n", sequences[i].name, (unsigned long long)count, ns);
+        printf("%-18s %10llu instructions %6.2f ns per instruction\n",
+               sequences[i].name, (unsigned long long)count, ns);
+    }
+    fclose(f);
+    printf("results in %s\n", path);
+    return 0;
+}
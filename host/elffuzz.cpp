@@ -0,0 +1,677 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+/**
+ * Differential fuzzer of the execution engines
+ *
+ *   elffuzz [-j threads] [-t seconds] [-n cases] [-s seed] [-o repro.txt]
+ *   elffuzz -r repro.txt
+ *
+ * Every thread makes random machines: memory, registers, cycle count
+ * and EF/INP inputs that are a function of the cycle, some with SCRT,
+ * tape or CHIP-8 routines planted. Each engine runs the case and is
+ * checked against the plain cpu_execute() switch at every instruction
+ * boundary both reach: registers, flags, cycles, the memory written
+ * so far and the board latches. A boundary the reference steps over
+ * is a cycles divergence.
+ *
+ * The first divergence stops every thread. The case is shrunk,
+ * budget, memory bytes and registers, while it still diverges, and
+ * written out; -r runs such a file again. Throughput is printed every
+ * second in engine runs per second, the reference runs included.
+ *
+ * Build it with -DMEM_WRITE_HOOK=fuzz_write, with -DELF_TAPE and
+ * tape.cpp, -DELF_CHIP8 and chip8.cpp or -DELF_JIT and jit.cpp for
+ * those engines. The JIT one translates a PC on its second fetch
+ * and is checked every JIT_STEP cycles.
+ */
+#include <Arduino.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "cpu.h"
+#include "mem.h"
+#include "hostio.h"
+#include "disasm.h"
+#include "scrt.h"
+#include "fuse.h"
+#ifdef ELF_TAPE
+#include "tape.h"
+#endif
+#ifdef ELF_CHIP8
+#include "chip8.h"
+#endif
+#ifdef ELF_JIT
+#include "jit.h"
+#endif
+
+#ifndef MEM_WRITE_HOOK
+#error "elffuzz needs -DMEM_WRITE_HOOK=fuzz_write"
+#endif
+
+// Cycles a case runs, CHIP-8 ones run longer
+#define BUDGET_MIN   500
+#define BUDGET_MAX   20000
+#define BUDGET_CHIP8 400000
+
+// Tape levels hold for this many cycles
+#define TAPE_CELL    37
+
+// Cycles the JIT runs between checks
+#define JIT_STEP     256
+
+typedef struct Case{
+    CDP1802  cpu;
+    uint64_t seed;          // Inputs
+    uint64_t budget;        // Cycle the engine runs to
+    std::vector<uint8_t> image;
+} Case;
+
+// State compared, bit per register and D with DF
+#define KEEP_DF    0x10000UL
+#define KEEP_ALL   0x1FFFFUL
+// The CHIP-8 path leaves the interpreter scratch registers as they fall
+#define KEEP_CHIP8 0x0F34UL
+
+typedef struct Engine{
+    const char *name;
+    uint8_t     scrt, tape, chip8, jit, fuse;   // Native paths on
+    uint32_t    keep;
+} Engine;
+
+static const Engine reference = { "switch", 0, 0, 0, 0, 0, KEEP_ALL };
+
+static const Engine engines[] = {
+    { "scrt",  1, 0, 0, 0, 0, KEEP_ALL },
+#ifdef ELF_FUSE
+    { "fuse",  0, 0, 0, 0, 1, KEEP_ALL },
+#endif
+#ifdef ELF_TAPE
+    { "tape",  0, 1, 0, 0, 0, KEEP_ALL },
+#endif
+#ifdef ELF_JIT
+    { "jit",   0, 0, 0, 1, 0, KEEP_ALL },
+#endif
+#ifdef ELF_CHIP8
+    { "chip8", 0, 0, 1, 0, 0, KEEP_CHIP8 },
+    { "all",   1, 1, 1, 1, 1, KEEP_CHIP8 },
+#else
+    { "all",   1, 1, 1, 1, 1, KEEP_ALL },
+#endif
+};
+#define ENGINES (sizeof(engines)/sizeof(engines[0]))
+
+// An instruction boundary of the engine run
+typedef struct Point{
+    CDP1802  cpu;
+    uint16_t pc;            // Where the step started
+    uint8_t  leds, idle;
+    size_t   writes;
+} Point;
+
+typedef struct Report{
+    uint64_t cycle;
+    uint64_t instructions;  // Reference ones
+    uint16_t pc;
+    char     what[96];
+} Report;
+
+static thread_local Board    fuzzBoard;
+static thread_local uint64_t inputSeed;
+static thread_local std::vector<uint32_t> writes;       // addr | value<<16
+
+static std::atomic<uint64_t> runs, cases;
+static std::atomic<uint64_t> scrtHits, fuseHits, tapeHits, chip8Hits, jitHits;    // Native work done
+static std::atomic<int>      stop;
+static std::mutex            reportLock;
+
+/**************************** Machine ****************************/
+void fuzz_write(uint16_t addr, uint8_t value){
+    mem[addr] = value;
+    writes.push_back(addr | (uint32_t)value << 16);
+#ifdef ELF_JIT
+    jit_touch(addr);
+#endif
+}
+
+static uint64_t mix(uint64_t x){
+    x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27; x *= 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static uint64_t next(uint64_t *s){
+    *s += 0x9E3779B97F4A7C15ULL;
+    return mix(*s);
+}
+
+#ifdef ELF_TAPE
+void tape_q(uint64_t, uint8_t){
+}
+
+uint8_t tape_ef(uint64_t cycle){
+    return mix(inputSeed ^ (cycle / TAPE_CELL)) & 1;
+}
+
+uint64_t tape_next_edge(uint64_t cycle){
+    uint64_t c = cycle / TAPE_CELL, level = tape_ef(cycle);
+    do{
+        c++;
+    }while((mix(inputSeed ^ c) & 1) == level);
+    return c * TAPE_CELL;
+}
+#endif
+
+// Inputs only depend on the cycle they are sampled at
+static void fuzz_flags(Board *b){
+    uint8_t ef = mix(inputSeed + GET_CYCLES()) & 0x0F;
+#ifdef ELF_TAPE
+    ef = (ef & ~2) | tape_ef(GET_CYCLES()) << 1;
+#endif
+    b->ef = ef;
+}
+
+static uint8_t fuzz_input(Board *, uint8_t Nlines){
+    return mix(inputSeed ^ GET_CYCLES() << 3 ^ Nlines) >> 8;
+}
+
+static void load(const Case *c, const Engine *e){
+    memcpy(mem, c->image.data(), MEM_SIZE);
+    cpu = c->cpu;
+    board_init(&fuzzBoard);
+    board = &fuzzBoard;
+    fuzzBoard.flags = fuzz_flags;
+    fuzzBoard.input = fuzz_input;
+    inputSeed = c->seed;
+    scrt_enabled = e->scrt;
+#ifdef ELF_TAPE
+    tape_turbo = e->tape;
+#endif
+#ifdef ELF_CHIP8
+    chip8_enabled = e->chip8;
+#endif
+#ifdef ELF_JIT
+    jit_init();
+    jit_hot = 2;
+#endif
+    fuse_enabled = e->fuse;
+    writes.clear();
+}
+
+static void trace(const Case *c, const Engine *e, std::vector<Point> &points){
+    load(c, e);
+    points.clear();
+    while(GET_CYCLES() < c->budget && !fuzzBoard.idle){
+        Point p;
+        p.pc = cpu.R[cpu.P];
+#ifdef ELF_JIT
+        if(e->jit){
+            jit_run(std::min(c->budget, GET_CYCLES() + JIT_STEP), UINT64_MAX);
+        }else
+#endif
+        cpu_execute();
+        p.cpu    = cpu;
+        p.leds   = fuzzBoard.leds;
+        p.idle   = fuzzBoard.idle;
+        p.writes = writes.size();
+        points.push_back(p);
+    }
+}
+
+/**
+ * Names the first kept field that differs, 0 when none. EF1-EF4
+ * are the last levels sampled, not state.
+ */
+static int differ(const CDP1802 *a, const CDP1802 *b, uint32_t keep, char *what){
+    for(int i=0; i<16; i++){
+        if((keep >> i & 1) && a->R[i] != b->R[i]) return sprintf(what, "R%X %04X, engine %04X", i, a->R[i], b->R[i]);
+    }
+    static const char *names[] = { "D", "T", "P", "X", "I", "N", "DF", "IE", "Q" };
+    const uint8_t *fa = &a->D, *fb = &b->D;
+    for(int i=0; i<9; i++){
+        if(!(keep & KEEP_DF) && (i == 0 || i == 6)) continue;
+        if(fa[i] != fb[i]) return sprintf(what, "%s %02X, engine %02X", names[i], fa[i], fb[i]);
+    }
+    return 0;
+}
+
+/**
+ * Runs the reference over the engine boundaries, returns 1 and
+ * fills r at the first one that does not match
+ */
+static int check(const Case *c, const Engine *e, const std::vector<Point> &points, const std::vector<uint32_t> &ew, Report *r){
+    static thread_local std::vector<uint8_t> shadow;
+    shadow = c->image;
+    load(c, &reference);
+
+    size_t   applied = 0, seen = 0;
+    uint64_t n = 0;
+    for(size_t j=0; j<points.size(); ){
+        const Point *p = &points[j];
+        r->pc = cpu.R[cpu.P];
+        if(fuzzBoard.idle){
+            r->cycle = GET_CYCLES();
+            sprintf(r->what, "reference idle, engine runs to %llu", (unsigned long long)GET_CYCLES_OF(p->cpu));
+            return 1;
+        }
+        cpu_execute();
+        n++;
+
+        uint64_t t = GET_CYCLES(), want = GET_CYCLES_OF(p->cpu);
+        if(t < want) continue;
+        r->cycle        = want;
+        r->instructions = n;
+        r->pc           = p->pc;
+        if(t > want){
+            sprintf(r->what, "cycles %llu, engine %llu", (unsigned long long)t, (unsigned long long)want);
+            return 1;
+        }
+        if(differ(&cpu, &p->cpu, e->keep, r->what)) return 1;
+        if(fuzzBoard.leds != p->leds || fuzzBoard.idle != p->idle){
+            sprintf(r->what, "OUT %02X idle %d, engine OUT %02X idle %d",
+                    fuzzBoard.leds, fuzzBoard.idle, p->leds, p->idle);
+            return 1;
+        }
+        // Bytes either one wrote since the last boundary
+        for(size_t k=applied; k<p->writes; k++){
+            shadow[ew[k] & 0xFFFF] = ew[k] >> 16;
+        }
+        for(size_t k=applied; k<p->writes + writes.size() - seen; k++){
+            uint16_t a = k < p->writes ? ew[k] & 0xFFFF : writes[seen + k - p->writes] & 0xFFFF;
+            if(mem[a] != shadow[a]){
+                sprintf(r->what, "M(%04X) %02X, engine %02X", a, mem[a], shadow[a]);
+                return 1;
+            }
+        }
+        applied = p->writes;
+        seen    = writes.size();
+        j++;
+    }
+    if(memcmp(mem, shadow.data(), MEM_SIZE)){
+        r->cycle = GET_CYCLES();
+        sprintf(r->what, "memory differs at the end");
+        return 1;
+    }
+    return 0;
+}
+
+static int diverges(const Case *c, const Engine *e, Report *r){
+    static thread_local std::vector<Point> points;
+    trace(c, e, points);
+    std::vector<uint32_t> ew(writes);
+    runs += 2;
+    return check(c, e, points, ew, r);
+}
+
+/**************************** Cases ****************************/
+static const uint8_t scrtCall[] = {
+    0xD3, 0xE2, 0x96, 0x73, 0x86, 0x73, 0x93, 0xB6,
+    0x83, 0xA6, 0x46, 0xB3, 0x46, 0xA3, 0x30, 0x00
+};
+static const uint8_t scrtReturn[] = {
+    0xD3, 0x96, 0xB3, 0x86, 0xA3, 0xE2, 0x12, 0x72,
+    0xA6, 0xF0, 0xB6, 0x30, 0x00
+};
+
+// Places a routine whose last byte branches back to its first, returns the entry
+static uint16_t place(Case *c, uint16_t at, const uint8_t *body, uint8_t len){
+    at = (at & 0xFF00) | ((at & 0xFF) % (0x100 - len));
+    for(uint8_t i=0; i<len; i++){
+        c->image[(uint16_t)(at + i)] = body[i];
+    }
+    c->image[(uint16_t)(at + len - 1)] = (uint8_t)at;
+    return at + 1;
+}
+
+static void make_case(Case *c, uint64_t seed){
+    uint64_t s = seed;
+    c->seed = next(&s);
+    c->image.assign(MEM_SIZE, 0);
+    memset(&c->cpu, 0, sizeof(c->cpu));
+
+    uint8_t kind = next(&s) % 8;
+    if(kind < 2){
+        // Random bytes everywhere
+        for(uint32_t a=0; a<MEM_SIZE; a+=8){
+            uint64_t v = next(&s);
+            memcpy(&c->image[a], &v, 8);
+        }
+    }else{
+        // A few random pages in zeros, mostly IDL
+        for(int i=0; i<8; i++){
+            uint16_t page = (next(&s) & 0xFF) << 8;
+            for(int a=0; a<256; a+=8){
+                uint64_t v = next(&s);
+                memcpy(&c->image[page + a], &v, 8);
+            }
+        }
+    }
+    for(int i=0; i<16; i++){
+        c->cpu.R[i] = next(&s);
+    }
+    uint64_t v = next(&s);
+    c->cpu.D  = v;
+    c->cpu.T  = v >> 8;
+    c->cpu.P  = (v >> 16) & 0x0F;
+    c->cpu.X  = (v >> 20) & 0x0F;
+    c->cpu.DF = (v >> 24) & 1;
+    c->cpu.IE = (v >> 25) & 1;
+    c->cpu.Q  = (v >> 26) & 1;
+    // Sometimes right before the 32 bit counter wraps
+    uint64_t t = (v >> 27) & 1 ? 0x100000000ULL - (next(&s) & 0xFFFF) : next(&s) & 0xFFFFFF;
+    SET_CYCLES_OF(c->cpu, t);
+    c->budget = t + BUDGET_MIN + next(&s) % (BUDGET_MAX - BUDGET_MIN);
+
+    uint16_t code = c->cpu.R[c->cpu.P];
+    if(kind == 2 || kind == 3){
+        // SCRT with calls and returns in the code
+        c->cpu.P = 3;
+        c->cpu.R[4] = place(c, next(&s), scrtCall, sizeof(scrtCall));
+        c->cpu.R[5] = place(c, next(&s), scrtReturn, sizeof(scrtReturn));
+        code = c->cpu.R[3];
+        for(int i=0; i<64; i++){
+            uint16_t a = code + next(&s) % 256;
+            if(next(&s) & 1){
+                c->image[a] = 0xD4;
+                c->image[(uint16_t)(a+1)] = code >> 8;
+                c->image[(uint16_t)(a+2)] = code + next(&s) % 256;
+            }else{
+                c->image[a] = 0xD5;
+            }
+        }
+    }
+#ifdef ELF_TAPE
+    if(kind == 4 || kind == 5){
+        // A tape routine called with SEP N from P=3
+        static const uint8_t regs[] = { 4, 5, 6, 7, 0xC, 0xD, 0xE };
+        uint8_t n = regs[next(&s) % sizeof(regs)];
+        uint8_t routine = kind == 4 ? TAPE_WRITE : TAPE_READ;
+        uint8_t len = routine == TAPE_READ ? TAPE_READ_LEN : TAPE_WRITE_LEN;
+        uint16_t base = (next(&s) & 0xFF00) | (next(&s) % (0x100 - len));
+        memcpy(mem, c->image.data(), MEM_SIZE);
+        tape_place(base, routine);
+        memcpy(c->image.data(), mem, MEM_SIZE);
+        c->cpu.P = 3;
+        c->cpu.R[n] = base + 1;
+        c->cpu.R[9] = next(&s) % 6;
+        code = c->cpu.R[3];
+        for(int i=0; i<8; i++){
+            c->image[(uint16_t)(code + next(&s) % 64)] = 0xD0 | n;
+        }
+    }
+#endif
+#ifdef ELF_CHIP8
+    if(kind == 6 || kind == 7){
+        // Reset into the interpreter with a random CHIP-8 program. It
+        // keeps to 0200-03FF without subroutines or machine code, which
+        // would run on the scratch registers; the rest jumps back.
+        memset(c->image.data(), 0x12, CHIP8_BASE);
+        memcpy(mem, c->image.data(), MEM_SIZE);
+        chip8_load();
+        memcpy(c->image.data(), mem, MEM_SIZE);
+        memset(&c->image[0x0E00], 0, 0x200);
+        for(int a=0; a<0x200; a+=2){
+            uint16_t op = next(&s);
+            switch(op >> 12){
+                case 0x0: op = 0x00E0; break;
+                case 0x1:
+                case 0x2:
+                case 0xB: op = 0x1000 | CHIP8_PROG | (op & 0x1FE); break;
+                case 0xA: op = 0xA600 | (op & 0x7FF); break;
+            }
+            c->image[CHIP8_PROG + a]     = op >> 8;
+            c->image[CHIP8_PROG + a + 1] = op;
+        }
+        uint64_t t = GET_CYCLES_OF(c->cpu);
+        memset(c->cpu.R, 0, sizeof(c->cpu.R));
+        c->cpu.P = c->cpu.X = 0;
+        c->cpu.IE = 1;
+        c->budget = t + BUDGET_CHIP8;
+    }
+#endif
+    (void)code;
+}
+
+/**************************** Reproducer ****************************/
+static int write_case(const char *path, const Case *c, const Engine *e, const Report *r){
+    FILE *f = fopen(path, "w");
+    if(!f){
+        perror(path);
+        return 0;
+    }
+    char line[32];
+    disasm(c->image.data(), r->pc, line);
+    fprintf(f, "# engine %s diverges at cycle %llu, %llu reference instructions\n",
+            e->name, (unsigned long long)r->cycle, (unsigned long long)r->instructions);
+    fprintf(f, "# step at %04X %s: %s\n", r->pc, line, r->what);
+    fprintf(f, "engine %s\n", e->name);
+    fprintf(f, "seed %llx\n", (unsigned long long)c->seed);
+    fprintf(f, "budget %llx\n", (unsigned long long)c->budget);
+    fprintf(f, "cycles %llx\n", (unsigned long long)GET_CYCLES_OF(c->cpu));
+    fprintf(f, "R");
+    for(int i=0; i<16; i++){
+        fprintf(f, " %04X", c->cpu.R[i]);
+    }
+    fprintf(f, "\nD %02X T %02X P %X X %X DF %d IE %d Q %d\n",
+            c->cpu.D, c->cpu.T, c->cpu.P, c->cpu.X, c->cpu.DF, c->cpu.IE, c->cpu.Q);
+    for(uint32_t a=0; a<MEM_SIZE; a+=16){
+        uint32_t k;
+        for(k=0; k<16 && !c->image[a+k]; k++);
+        if(k == 16) continue;
+        fprintf(f, "M %04X", (unsigned)a);
+        for(k=0; k<16; k++){
+            fprintf(f, " %02X", c->image[a+k]);
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    return 1;
+}
+
+static const Engine *read_case(const char *path, Case *c){
+    FILE *f = fopen(path, "r");
+    if(!f){
+        perror(path);
+        return NULL;
+    }
+    const Engine *e = NULL;
+    char line[256], name[16];
+    unsigned long long v;
+    unsigned r[16], d, t, p, x, df, ie, q, a;
+
+    c->image.assign(MEM_SIZE, 0);
+    memset(&c->cpu, 0, sizeof(c->cpu));
+    while(fgets(line, sizeof(line), f)){
+        if(sscanf(line, "engine %15s", name) == 1){
+            for(size_t i=0; i<ENGINES; i++){
+                if(!strcmp(engines[i].name, name)) e = &engines[i];
+            }
+        }else if(sscanf(line, "seed %llx", &v) == 1){
+            c->seed = v;
+        }else if(sscanf(line, "budget %llx", &v) == 1){
+            c->budget = v;
+        }else if(sscanf(line, "cycles %llx", &v) == 1){
+            SET_CYCLES_OF(c->cpu, v);
+        }else if(sscanf(line, "R %x %x %x %x %x %x %x %x %x %x %x %x %x %x %x %x",
+                        &r[0], &r[1], &r[2], &r[3], &r[4], &r[5], &r[6], &r[7], &r[8],
+                        &r[9], &r[10], &r[11], &r[12], &r[13], &r[14], &r[15]) == 16){
+            for(int i=0; i<16; i++){
+                c->cpu.R[i] = r[i];
+            }
+        }else if(sscanf(line, "D %x T %x P %x X %x DF %u IE %u Q %u", &d, &t, &p, &x, &df, &ie, &q) == 7){
+            c->cpu.D = d; c->cpu.T = t; c->cpu.P = p; c->cpu.X = x;
+            c->cpu.DF = df; c->cpu.IE = ie; c->cpu.Q = q;
+        }else if(sscanf(line, "M %x", &a) == 1 && a < MEM_SIZE){
+            char *s = line + 6;
+            for(int k=0; k<16; k++){
+                c->image[(a + k) % MEM_SIZE] = strtoul(s, &s, 16);
+            }
+        }
+    }
+    fclose(f);
+    if(!e) fprintf(stderr, "%s: no engine of this build\n", path);
+    return e;
+}
+
+/**
+ * Smaller case that still diverges: the budget up to the divergence,
+ * then memory zeroed in halving chunks and registers cleared
+ */
+static void shrink(Case *c, const Engine *e, Report *r){
+    Report t;
+    Case   best = *c;
+
+    best.budget = r->cycle;
+    if(!diverges(&best, e, &t)) best.budget = c->budget;
+
+    for(uint32_t size=MEM_SIZE/4; size>=1; size/=2){
+        for(uint32_t a=0; a<MEM_SIZE; a+=size){
+            uint32_t k;
+            for(k=0; k<size && !best.image[a+k]; k++);
+            if(k == size) continue;
+            std::vector<uint8_t> keep(best.image.begin() + a, best.image.begin() + a + size);
+            memset(&best.image[a], 0, size);
+            if(!diverges(&best, e, &t)) memcpy(&best.image[a], keep.data(), size);
+        }
+    }
+    for(int i=0; i<16; i++){
+        uint16_t keep = best.cpu.R[i];
+        best.cpu.R[i] = 0;
+        if(!diverges(&best, e, &t)) best.cpu.R[i] = keep;
+    }
+    uint8_t *fields[] = { &best.cpu.D, &best.cpu.T, &best.cpu.DF, &best.cpu.IE, &best.cpu.Q };
+    for(uint8_t *p : fields){
+        uint8_t keep = *p;
+        *p = 0;
+        if(!diverges(&best, e, &t)) *p = keep;
+    }
+    diverges(&best, e, r);
+    *c = best;
+}
+
+/**************************** Run ****************************/
+static void worker(int id, int threads, uint64_t seed, uint64_t maxCases, const char *out){
+    Case   c;
+    Report r;
+
+    for(uint64_t k=id; !stop && k<maxCases; k+=threads){
+        make_case(&c, mix(seed + k));
+        for(size_t i=0; i<ENGINES && !stop; i++){
+            if(!diverges(&c, &engines[i], &r)) continue;
+
+            std::lock_guard<std::mutex> hold(reportLock);
+            if(stop.exchange(1)) return;
+            printf("case %llu: engine %s diverges at cycle %llu: %s\n",
+                   (unsigned long long)k, engines[i].name, (unsigned long long)r.cycle, r.what);
+            shrink(&c, &engines[i], &r);
+            printf("shrunk: cycle %llu, step at %04X: %s\n", (unsigned long long)r.cycle, r.pc, r.what);
+            if(write_case(out, &c, &engines[i], &r)) printf("reproducer in %s\n", out);
+            return;
+        }
+        cases++;
+    }
+    scrtHits += scrt_calls + scrt_returns;
+    fuseHits += fuse_count;
+#ifdef ELF_TAPE
+    tapeHits += tape_bytes_read + tape_bytes_written;
+#endif
+#ifdef ELF_CHIP8
+    chip8Hits += chip8_ops;
+#endif
+#ifdef ELF_JIT
+    jitHits += jit_native;
+#endif
+}
+
+int main(int argc, char **argv){
+    int         threads = std::thread::hardware_concurrency();
+    double      seconds = 10;
+    uint64_t    maxCases = UINT64_MAX, seed = 1;
+    const char *out = "elffuzz-repro.txt", *replay = NULL;
+
+    for(int i=1; i<argc; i++){
+        if(!strcmp(argv[i], "-j") && i+1<argc){
+            threads = atoi(argv[++i]);
+        }else if(!strcmp(argv[i], "-t") && i+1<argc){
+            seconds = atof(argv[++i]);
+        }else if(!strcmp(argv[i], "-n") && i+1<argc){
+            maxCases = strtoull(argv[++i], NULL, 0);
+        }else if(!strcmp(argv[i], "-s") && i+1<argc){
+            seed = strtoull(argv[++i], NULL, 0);
+        }else if(!strcmp(argv[i], "-o") && i+1<argc){
+            out = argv[++i];
+        }else if(!strcmp(argv[i], "-r") && i+1<argc){
+            replay = argv[++i];
+        }else{
+            fprintf(stderr, "usage: elffuzz [-j threads] [-t seconds] [-n cases] [-s seed] [-o repro.txt]\n"
+                            "       elffuzz -r repro.txt\n");
+            return 1;
+        }
+    }
+
+    if(replay){
+        Case   c;
+        Report r;
+        const Engine *e = read_case(replay, &c);
+        if(!e) return 1;
+        if(!diverges(&c, e, &r)){
+            printf("engine %s matches the reference\n", e->name);
+            return 0;
+        }
+        char line[32];
+        disasm(c.image.data(), r.pc, line);
+        printf("engine %s diverges at cycle %llu after %llu reference instructions\n",
+               e->name, (unsigned long long)r.cycle, (unsigned long long)r.instructions);
+        printf("step at %04X %s: %s\n", r.pc, line, r.what);
+        return 2;
+    }
+
+    if(threads < 1) threads = 1;
+    printf("%d threads, engines:", threads);
+    for(size_t i=0; i<ENGINES; i++){
+        printf(" %s", engines[i].name);
+    }
+    printf("\n");
+
+    std::vector<std::thread> pool;
+    for(int i=0; i<threads; i++){
+        pool.emplace_back(worker, i, threads, seed, maxCases, out);
+    }
+
+    // Workers finish on their own with -n, else on time
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t last = 0;
+    double   secs = 0;
+    while(!stop){
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if(cases >= maxCases || secs >= seconds) break;
+        if((uint64_t)secs != last){
+            last = secs;
+            printf("%6.0f s %10llu cases %10.0f runs/s\n", secs,
+                   (unsigned long long)cases, runs / secs);
+            fflush(stdout);
+        }
+    }
+    int found = stop.exchange(1);
+    for(auto &t : pool){
+        t.join();
+    }
+    secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    printf("%llu cases, %llu runs in %.1f s, %.0f runs/s\n", (unsigned long long)cases,
+           (unsigned long long)runs, secs, runs / secs);
+    printf("native: %llu SCRT calls and returns, %llu fused tails, %llu tape bytes,\n"
+           "        %llu CHIP-8 instructions, %llu instructions in JIT blocks\n",
+           (unsigned long long)scrtHits, (unsigned long long)fuseHits, (unsigned long long)tapeHits,
+           (unsigned long long)chip8Hits, (unsigned long long)jitHits);
+    return found ? 2 : 0;
+}
@@ -0,0 +1,368 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+/**
+ * Linked multi Elf simulation
+ *
+ * Several 1802 machines run each one on its own thread. OUT of a
+ * machine can feed INP of another one and Q can drive the EF line
+ * of a neighbour. Port writes travel through lock-free single
+ * producer / single consumer queues stamped with the cycle time of
+ * the writer, machines only wait for each other at the end of every
+ * quantum.
+ *
+ *   elflink [-n machines] [-c cycles] [-q q1,q2,..] [-i image.bin]
+ *           [-L out:from:N:to] [-L q:from:to:EFn]
+ *
+ * Without -L the machines are wired as a ring, OUT 4 feeds INP 4
+ * and Q feeds EF2 of the next machine.
+ */
+#include <Arduino.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include "cpu.h"
+#include "mem.h"
+#include "hostio.h"
+#include "spsc.h"
+
+#define MAX_MACHINES 16
+#define MAX_LINKS    64
+#define LINK_QSIZE   1024
+
+// Link kinds
+#define LK_DATA 0   // OUT N of 'from' is latched as INP N of 'to'
+#define LK_EF   1   // Q of 'from' drives EF 'port' of 'to'
+
+typedef struct LinkEvent{
+    uint64_t cycle;     // Writer cycle time
+    uint8_t  value;
+} LinkEvent;
+
+typedef struct Link{
+    uint8_t kind;
+    uint8_t from;
+    uint8_t to;
+    uint8_t port;
+    Spsc<LinkEvent, LINK_QSIZE> queue;
+    std::deque<LinkEvent>       backlog;  // Owned by the consumer
+} Link;
+
+typedef struct Machine{
+    int      id;
+    Board    board;
+    uint8_t  latch[8];          // INP value for every N lines
+    Link    *in [MAX_LINKS];
+    Link    *out[MAX_LINKS];
+    uint8_t  nin, nout;
+
+    // Statistics
+    uint64_t instructions;
+    uint64_t events;
+    uint64_t late;              // Events seen after their stamp
+    uint64_t skew;              // Sum of late cycles
+} Machine;
+
+typedef struct LinkSpec{
+    uint8_t kind, from, port, to;
+} LinkSpec;
+
+// Default program: INP 4, add one, OUT 4 and toggle Q forever
+static const uint8_t demo[] = {
+    0xE1,             // 0000 SEX 1
+    0xF8, 0x10,       // 0001 LDI 10
+    0xA1,             // 0003 PLO 1
+    0x6C,             // 0004 INP 4
+    0xFC, 0x01,       // 0005 ADI 01
+    0x51,             // 0007 STR 1
+    0x64,             // 0008 OUT 4
+    0x21,             // 0009 DEC 1
+    0x31, 0x0E,       // 000A BQ  0E
+    0x7B,             // 000C SEQ
+    0x38,             // 000D SKP
+    0x7A,             // 000E REQ
+    0x30, 0x04        // 000F BR  04
+};
+
+static Machine   machines[MAX_MACHINES];
+static Link     *links[MAX_LINKS];
+static LinkSpec  specs[MAX_LINKS];
+static int       nmachines = 4;
+static int       nspecs;
+static uint64_t  runCycles = 2000000;
+static uint64_t  quantum;
+static uint8_t   image[MEM_SIZE];
+static size_t    imageSize;
+
+// Quantum barrier, the waiting threads keep draining their queues
+static std::atomic<int>      arrived;
+static std::atomic<uint32_t> generation;
+static std::atomic<uint64_t> barriers;
+
+/**
+ * Move everything published by the producers to the local backlogs,
+ * so a producer blocked on a full queue can always progress
+ */
+static void machine_drain(Machine *m){
+    LinkEvent ev;
+    for(int i=0; i<m->nin; i++){
+        while(m->in[i]->queue.pop(ev)){
+            m->in[i]->backlog.push_back(ev);
+        }
+    }
+}
+
+static void machine_apply(Machine *m, Link *l, LinkEvent &ev){
+    if(l->kind == LK_DATA){
+        m->latch[l->port] = ev.value;
+    }else{
+        if(ev.value) m->board.ef |=  (1<<(l->port-1));
+        else         m->board.ef &= ~(1<<(l->port-1));
+    }
+    m->events++;
+}
+
+/**
+ * Apply every incoming event whose stamp is already reached
+ */
+static void machine_poll(Machine *m){
+    LinkEvent ev;
+    for(int i=0; i<m->nin; i++){
+        Link *l = m->in[i];
+        for(;;){
+            if(l->backlog.empty()){
+                if(!l->queue.pop(ev)) break;
+                l->backlog.push_back(ev);
+            }
+            LinkEvent &front = l->backlog.front();
+            uint64_t now = GET_CYCLES();
+            if(front.cycle > now) break;
+            if(front.cycle + 2 < now){
+                m->late++;
+                m->skew += now - front.cycle;
+            }
+            machine_apply(m, l, front);
+            l->backlog.pop_front();
+        }
+    }
+}
+
+static void machine_send(Machine *m, Link *l, uint8_t value){
+    LinkEvent ev = { GET_CYCLES(), value };
+    while(!l->queue.push(ev)){
+        machine_drain(m);
+        std::this_thread::yield();
+    }
+}
+
+static void barrier_wait(Machine *m){
+    uint32_t gen = generation.load(std::memory_order_acquire);
+    if(arrived.fetch_add(1, std::memory_order_acq_rel) == nmachines-1){
+        arrived.store(0, std::memory_order_relaxed);
+        barriers++;
+        generation.fetch_add(1, std::memory_order_release);
+        return;
+    }
+    while(generation.load(std::memory_order_acquire) == gen){
+        machine_drain(m);
+        std::this_thread::yield();
+    }
+}
+
+/**************************** Board hooks ****************************/
+static void link_output(Board *b, uint8_t data, uint8_t Nlines){
+    Machine *m = (Machine *)b->user;
+    for(int i=0; i<m->nout; i++){
+        Link *l = m->out[i];
+        if(l->kind == LK_DATA && l->port == (Nlines&0b111)){
+            machine_send(m, l, data);
+        }
+    }
+}
+
+static uint8_t link_input(Board *b, uint8_t Nlines){
+    Machine *m = (Machine *)b->user;
+    return m->latch[Nlines&0b111];
+}
+
+static void link_outputQ(Board *b, uint8_t q){
+    Machine *m = (Machine *)b->user;
+    for(int i=0; i<m->nout; i++){
+        if(m->out[i]->kind == LK_EF){
+            machine_send(m, m->out[i], q);
+        }
+    }
+}
+
+/**************************** Machine thread ****************************/
+static void machine_run(Machine *m){
+    board = &m->board;
+    memset(&cpu, 0, sizeof(cpu));
+    memset(mem, 0, MEM_SIZE);
+    memcpy(mem, image, imageSize);
+    cpu_reset();
+
+    for(uint64_t end=quantum; ; end+=quantum){
+        if(end > runCycles) end = runCycles;
+        while(GET_CYCLES() < end){
+            machine_poll(m);
+            cpu_execute();
+            m->instructions++;
+        }
+        barrier_wait(m);
+        if(end == runCycles) break;
+    }
+}
+
+static void setup_links(){
+    for(int i=0; i<nmachines; i++){
+        Machine *m = &machines[i];
+        memset(m, 0, sizeof(Machine));
+        m->id = i;
+        board_init(&m->board);
+        m->board.output  = link_output;
+        m->board.input   = link_input;
+        m->board.outputQ = link_outputQ;
+        m->board.user    = m;
+    }
+    for(int i=0; i<nspecs; i++){
+        Link *l = new Link();
+        l->kind = specs[i].kind;
+        l->from = specs[i].from;
+        l->to   = specs[i].to;
+        l->port = specs[i].port;
+        links[i] = l;
+        machines[l->from].out[machines[l->from].nout++] = l;
+        machines[l->to].in[machines[l->to].nin++]       = l;
+    }
+}
+
+static void free_links(){
+    for(int i=0; i<nspecs; i++){
+        delete links[i];
+        links[i] = NULL;
+    }
+}
+
+static int parse_link(const char *arg){
+    unsigned a, b, c;
+    LinkSpec *s = &specs[nspecs];
+    if(nspecs >= MAX_LINKS) return 0;
+    if(sscanf(arg, "out:%u:%u:%u", &a, &b, &c) == 3 && b>0 && b<8){
+        s->kind = LK_DATA; s->from = a; s->port = b; s->to = c;
+    }else if(sscanf(arg, "q:%u:%u:%u", &a, &c, &b) == 3 && b>0 && b<5){
+        s->kind = LK_EF;   s->from = a; s->port = b; s->to = c;
+    }else{
+        return 0;
+    }
+    if(s->from >= MAX_MACHINES || s->to >= MAX_MACHINES) return 0;
+    nspecs++;
+    return 1;
+}
+
+static int load_image(const char *path){
+    FILE *f = fopen(path, "rb");
+    if(!f){
+        perror(path);
+        return 0;
+    }
+    imageSize = fread(image, 1, sizeof(image), f);
+    fclose(f);
+    return 1;
+}
+
+static void usage(){
+    fprintf(stderr,
+        "usage: elflink [-n machines] [-c cycles] [-q q1,q2,..] [-i image.bin]\n"
+        "               [-L out:from:N:to] [-L q:from:to:EFn]\n");
+    exit(1);
+}
+
+int main(int argc, char **argv){
+    uint64_t quanta[32];
+    int      nquanta = 0;
+
+    for(int i=1; i<argc; i++){
+        if(!strcmp(argv[i], "-n") && i+1<argc){
+            nmachines = atoi(argv[++i]);
+        }else if(!strcmp(argv[i], "-c") && i+1<argc){
+            runCycles = strtoull(argv[++i], NULL, 0);
+        }else if(!strcmp(argv[i], "-q") && i+1<argc){
+            for(char *t=strtok(argv[++i], ","); t && nquanta<32; t=strtok(NULL, ",")){
+                quanta[nquanta++] = strtoull(t, NULL, 0);
+            }
+        }else if(!strcmp(argv[i], "-i") && i+1<argc){
+            if(!load_image(argv[++i])) return 1;
+        }else if(!strcmp(argv[i], "-L") && i+1<argc){
+            if(!parse_link(argv[++i])) usage();
+        }else{
+            usage();
+        }
+    }
+    if(nmachines < 1 || nmachines > MAX_MACHINES) usage();
+    for(int i=0; i<nspecs; i++){
+        if(specs[i].from >= nmachines || specs[i].to >= nmachines) usage();
+    }
+    if(!imageSize){
+        memcpy(image, demo, sizeof(demo));
+        imageSize = sizeof(demo);
+    }
+    if(!nspecs && nmachines > 1){
+        char spec[32];
+        for(int i=0; i<nmachines; i++){
+            sprintf(spec, "out:%d:4:%d", i, (i+1)%nmachines);
+            parse_link(spec);
+            sprintf(spec, "q:%d:%d:2", i, (i+1)%nmachines);
+            parse_link(spec);
+        }
+    }
+    if(!nquanta){
+        const uint64_t def[] = {16, 64, 256, 1024, 4096, 16384, 65536};
+        for(uint64_t q : def) quanta[nquanta++] = q;
+    }
+
+    printf("%d machines, %d links, %llu cycles each, %u hw threads\n",
+           nmachines, nspecs, (unsigned long long)runCycles,
+           std::thread::hardware_concurrency());
+    printf("%9s %9s %9s %12s %8s %9s %9s\n",
+           "quantum", "barriers", "wall ms", "instr", "MIPS", "late", "avg skew");
+
+    for(int q=0; q<nquanta; q++){
+        std::thread threads[MAX_MACHINES];
+        quantum = quanta[q] ? quanta[q] : 1;
+        arrived = 0;
+        generation = 0;
+        barriers = 0;
+        setup_links();
+
+        auto t0 = std::chrono::steady_clock::now();
+        for(int i=0; i<nmachines; i++){
+            threads[i] = std::thread(machine_run, &machines[i]);
+        }
+        for(int i=0; i<nmachines; i++){
+            threads[i].join();
+        }
+        double ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - t0).count();
+
+        uint64_t instr = 0, late = 0, skew = 0;
+        for(int i=0; i<nmachines; i++){
+            instr += machines[i].instructions;
+            late  += machines[i].late;
+            skew  += machines[i].skew;
+        }
+        printf("%9llu %9llu %9.1f %12llu %8.2f %9llu %9.1f\n",
+               (unsigned long long)quantum, (unsigned long long)barriers.load(),
+               ms, (unsigned long long)instr, instr/(ms*1000.0),
+               (unsigned long long)late, late ? (double)skew/late : 0.0);
+        free_links();
+    }
+    return 0;
+}
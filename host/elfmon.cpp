@@ -0,0 +1,620 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+/**
+ * Debug monitor for the serial protocol
+ *
+ *   elfmon device [command ...]
+ *
+ * device is the board serial port or the pty of elfserve. The
+ * commands on the command line are run in order, without them
+ * commands are read from stdin. Numbers are hex.
+ *
+ *   ping                     protocol version and memory size
+ *   regs                     show the registers
+ *   set R3|D|X|P|DF|Q|IE v   change one register
+ *   mem addr [len]           hex dump
+ *   fill addr len v          write len bytes of v
+ *   copy dst src len         copy a block, it may overlap
+ *   insert addr n [end [lo [r]]]
+ *   delete addr n [end [lo [r]]]
+ *                            shift [addr, end) by n bytes, branches
+ *                            in [lo, end) follow unless r is 0
+ *   find addr end bytes      first match of the hex bytes
+ *   load file [addr]         write a binary image
+ *   save file addr len       read memory to a file
+ *   step [n]                 run n instructions
+ *   back [n]                 undo n steps
+ *   run [addr]               run, until addr when given
+ *   stop                     stop a run
+ *   wait                     wait until the CPU stops
+ *   break addr               add a breakpoint
+ *   clear [addr]             remove one or all breakpoints
+ *   profile s [hz [n]]       sample the PC for s seconds at hz, show
+ *                            the n hottest addresses, in decimal
+ *   quit
+ */
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "proto.h"
+#include "disasm.h"
+#include "sample.h"
+
+#define TIMEOUT_MS 2000
+#define WINDOW     2        // Requests in flight for bulk transfers
+#define POLL_MS    50       // Sampler polls, well before SAMPLE_SLOTS fill
+
+typedef struct Reply{
+    uint8_t cmd;
+    uint8_t status;
+    uint8_t len;
+    uint8_t data[PROTO_MAX];
+} Reply;
+
+static int fd = -1;
+
+/**************************** Link ****************************/
+static int open_port(const char *path){
+    struct termios tio;
+
+    fd = open(path, O_RDWR | O_NOCTTY);
+    if(fd < 0){
+        perror(path);
+        return 0;
+    }
+    if(tcgetattr(fd, &tio) == 0){
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, B115200);
+        cfsetospeed(&tio, B115200);
+        tcsetattr(fd, TCSANOW, &tio);
+        tcflush(fd, TCIOFLUSH);
+    }
+    return 1;
+}
+
+static int read_byte(uint8_t *c, int timeout){
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    if(poll(&pfd, 1, timeout) <= 0) return 0;
+    return read(fd, c, 1) == 1;
+}
+
+static void send_frame(uint8_t cmd, const uint8_t *data, uint8_t len){
+    uint8_t frame[PROTO_MAX + 4];
+    uint8_t crc = 0;
+
+    frame[0] = PROTO_SYNC;
+    frame[1] = cmd;
+    frame[2] = len;
+    memcpy(&frame[3], data, len);
+    for(int i=1; i<3+len; i++){
+        crc = proto_crc(crc, frame[i]);
+    }
+    frame[3+len] = crc;
+
+    for(size_t done=0; done<(size_t)len+4; ){
+        ssize_t n = write(fd, frame + done, len + 4 - done);
+        if(n < 0 && errno != EINTR){
+            perror("write");
+            exit(1);
+        }
+        if(n > 0) done += n;
+    }
+}
+
+/**
+ * Next reply from the machine, 0 on timeout or bad frame
+ */
+static int recv_frame(Reply *r, int timeout){
+    uint8_t c, crc = 0;
+
+    do{
+        if(!read_byte(&c, timeout)) return 0;
+    }while(c != PROTO_REPLY);
+
+    if(!read_byte(&r->cmd, timeout) || !read_byte(&r->status, timeout) ||
+       !read_byte(&r->len, timeout) || r->len > PROTO_MAX) return 0;
+    crc = proto_crc(crc, r->cmd);
+    crc = proto_crc(crc, r->status);
+    crc = proto_crc(crc, r->len);
+    for(int i=0; i<r->len; i++){
+        if(!read_byte(&r->data[i], timeout)) return 0;
+        crc = proto_crc(crc, r->data[i]);
+    }
+    if(!read_byte(&c, timeout)) return 0;
+    if(c != crc){
+        fprintf(stderr, "bad crc\n");
+        return 0;
+    }
+    return 1;
+}
+
+/**************************** Registers ****************************/
+typedef struct Regs{
+    uint16_t R[16];
+    uint8_t  D, T, XP, IN, flags;
+    uint64_t cycles;
+} Regs;
+
+static void regs_decode(const uint8_t *p, Regs *r){
+    for(int i=0; i<16; i++, p+=2){
+        r->R[i] = p[0] | p[1]<<8;
+    }
+    r->D  = *p++;
+    r->T  = *p++;
+    r->XP = *p++;
+    r->IN = *p++;
+    r->flags  = *p++;
+    r->cycles = 0;
+    for(int i=0; i<8; i++){
+        r->cycles |= (uint64_t)*p++ << (i*8);
+    }
+}
+
+static void regs_encode(const Regs *r, uint8_t *p){
+    for(int i=0; i<16; i++){
+        *p++ = (uint8_t)r->R[i];
+        *p++ = r->R[i]>>8;
+    }
+    *p++ = r->D;
+    *p++ = r->T;
+    *p++ = r->XP;
+    *p++ = r->IN;
+    *p++ = r->flags;
+    for(int i=0; i<8; i++){
+        *p++ = (uint8_t)(r->cycles>>(i*8));
+    }
+}
+
+static void regs_show(const Regs *r){
+    for(int i=0; i<16; i++){
+        printf("R%X=%04X%s", i, r->R[i], (i&7)==7 ? "\n" : " ");
+    }
+    printf("D=%02X DF=%d X=%X P=%X I=%X N=%X T=%02X Q=%d IE=%d cycles=%llu\n",
+           r->D, r->flags&1, r->XP>>4, r->XP&0x0F, r->IN>>4, r->IN&0x0F,
+           r->T, (r->flags>>2)&1, (r->flags>>1)&1, (unsigned long long)r->cycles);
+}
+
+static void show_stopped(const Reply *r){
+    static const char *reasons[] = { "done", "breakpoint", "address reached", "stopped" };
+    Regs regs;
+    regs_decode(&r->data[1], &regs);
+    printf("-- %s at %04X\n", r->data[0] < 4 ? reasons[r->data[0]] : "?", regs.R[regs.XP&0x0F]);
+    regs_show(&regs);
+}
+
+/**
+ * Reply to cmd, STOPPED events seen meanwhile are shown
+ */
+static int wait_reply(uint8_t cmd, Reply *r){
+    for(;;){
+        if(!recv_frame(r, TIMEOUT_MS)){
+            fprintf(stderr, "no reply\n");
+            return 0;
+        }
+        if(r->cmd == P_STOPPED && cmd != P_STOPPED){
+            show_stopped(r);
+            continue;
+        }
+        if(r->cmd != cmd){
+            fprintf(stderr, "unexpected reply %02X\n", r->cmd);
+            continue;
+        }
+        if(r->status != PS_OK){
+            fprintf(stderr, "error %d\n", r->status);
+            return 0;
+        }
+        return 1;
+    }
+}
+
+static int request(uint8_t cmd, const uint8_t *data, uint8_t len, Reply *r){
+    Reply tmp;
+    send_frame(cmd, data, len);
+    return wait_reply(cmd, r ? r : &tmp);
+}
+
+static int get_regs(Regs *regs){
+    Reply r;
+    if(!request(P_REGS, NULL, 0, &r)) return 0;
+    regs_decode(r.data, regs);
+    return 1;
+}
+
+/**************************** Bulk memory ****************************/
+static double seconds(std::chrono::steady_clock::time_point t0){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+/**
+ * Memory reads and writes keep WINDOW requests in flight, so the
+ * line never waits for the round trip
+ */
+static int mem_read(uint16_t addr, uint32_t len, uint8_t *buf){
+    uint32_t sent = 0, got = 0;
+    Reply r;
+
+    while(got < len){
+        while(sent < len && sent - got < WINDOW*PROTO_MAX){
+            uint8_t n = len - sent > PROTO_MAX ? PROTO_MAX : len - sent;
+            uint8_t req[3] = { (uint8_t)(addr+sent), (uint8_t)((addr+sent)>>8), n };
+            send_frame(P_READ, req, 3);
+            sent += n;
+        }
+        if(!wait_reply(P_READ, &r)) return 0;
+        memcpy(buf + got, r.data, r.len);
+        got += r.len;
+    }
+    return 1;
+}
+
+static int mem_write(uint16_t addr, uint32_t len, const uint8_t *buf){
+    uint32_t sent = 0, acked = 0;
+    uint8_t  req[PROTO_MAX];
+    Reply    r;
+
+    while(acked < len){
+        while(sent < len && sent - acked < WINDOW*(PROTO_MAX-2)){
+            uint8_t n = len - sent > PROTO_MAX-2 ? PROTO_MAX-2 : len - sent;
+            req[0] = (uint8_t)(addr+sent);
+            req[1] = (uint8_t)((addr+sent)>>8);
+            memcpy(&req[2], buf + sent, n);
+            send_frame(P_WRITE, req, n + 2);
+            sent += n;
+        }
+        if(!wait_reply(P_WRITE, &r)) return 0;
+        acked += len - acked > PROTO_MAX-2 ? PROTO_MAX-2 : len - acked;
+    }
+    return 1;
+}
+
+static void hexdump(uint16_t addr, const uint8_t *p, uint32_t len){
+    static const char digits[] = "0123456789ABCDEF";
+    char line[80];
+
+    for(uint32_t off=0; off<len; off+=16){
+        char *s = line;
+        uint32_t n = len - off < 16 ? len - off : 16;
+        uint16_t a = addr + off;
+        *s++ = digits[a>>12]; *s++ = digits[(a>>8)&15];
+        *s++ = digits[(a>>4)&15]; *s++ = digits[a&15];
+        *s++ = ' '; *s++ = ':'; *s++ = ' ';
+        for(uint32_t i=0; i<16; i++){
+            if(i < n){
+                *s++ = digits[p[off+i]>>4];
+                *s++ = digits[p[off+i]&15];
+            }else{
+                *s++ = ' '; *s++ = ' ';
+            }
+            *s++ = ' ';
+        }
+        *s++ = ' ';
+        for(uint32_t i=0; i<n; i++){
+            uint8_t c = p[off+i];
+            *s++ = (32 <= c && c <= 126) ? c : '.';
+        }
+        *s = 0;
+        puts(line);
+    }
+}
+
+/**************************** Commands ****************************/
+static uint32_t memLast = 0xFFFF;   // Last address, from ping
+
+static int cmd_set(const char *name, uint32_t v){
+    Regs    regs;
+    uint8_t buf[PROTO_REGS_LEN];
+
+    if(!get_regs(&regs)) return 0;
+    if((name[0]=='R' || name[0]=='r') && name[1] && !name[2]){
+        regs.R[strtoul(&name[1], NULL, 16) & 0x0F] = v;
+    }else if(!strcasecmp(name, "D")){
+        regs.D = v;
+    }else if(!strcasecmp(name, "X")){
+        regs.XP = (regs.XP & 0x0F) | (v&0x0F)<<4;
+    }else if(!strcasecmp(name, "P")){
+        regs.XP = (regs.XP & 0xF0) | (v&0x0F);
+    }else if(!strcasecmp(name, "DF")){
+        regs.flags = (regs.flags & ~1) | (v&1);
+    }else if(!strcasecmp(name, "IE")){
+        regs.flags = (regs.flags & ~2) | (v&1)<<1;
+    }else if(!strcasecmp(name, "Q")){
+        regs.flags = (regs.flags & ~4) | (v&1)<<2;
+    }else{
+        fprintf(stderr, "unknown register %s\n", name);
+        return 0;
+    }
+    regs_encode(&regs, buf);
+    return request(P_SETREGS, buf, sizeof(buf), NULL);
+}
+
+static int cmd_load(const char *path, uint16_t addr){
+    static uint8_t buf[65536];
+    FILE *f = fopen(path, "rb");
+    if(!f){
+        perror(path);
+        return 0;
+    }
+    size_t n = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    if(n > memLast + 1 - addr) n = memLast + 1 - addr;
+
+    auto t0 = std::chrono::steady_clock::now();
+    if(!mem_write(addr, n, buf)) return 0;
+    double s = seconds(t0);
+    printf("%zu bytes in %.3f s, %.0f bytes/s\n", n, s, n/s);
+    return 1;
+}
+
+static int cmd_save(const char *path, uint16_t addr, uint32_t len){
+    static uint8_t buf[65536];
+    auto t0 = std::chrono::steady_clock::now();
+    if(!mem_read(addr, len, buf)) return 0;
+    double s = seconds(t0);
+
+    FILE *f = fopen(path, "wb");
+    if(!f){
+        perror(path);
+        return 0;
+    }
+    fwrite(buf, 1, len, f);
+    fclose(f);
+    printf("%u bytes in %.3f s, %.0f bytes/s\n", len, s, len/s);
+    return 1;
+}
+
+/**************************** Profile ****************************/
+static std::unordered_map<uint32_t, uint64_t> samples;     // pc<<8 | opcode
+static uint64_t lost, other;
+static int      polled;             // Slots in the last reply
+
+static int sample_poll(const uint8_t *req, uint8_t len){
+    Reply r;
+    if(!request(P_SAMPLE, req, len, &r) || r.len < 4) return 0;
+    lost  += r.data[0] | r.data[1]<<8;
+    other += r.data[2] | r.data[3]<<8;
+    polled = (r.len - 4) / 4;
+    for(int i=4; i+4<=r.len; i+=4){
+        samples[(uint32_t)(r.data[i] | r.data[i+1]<<8) << 8 | r.data[i+2]] += r.data[i+3];
+    }
+    return 1;
+}
+
+/**
+ * Start of the instruction a sample falls in: the opcode right before
+ * R(P) while it runs, R(P) itself between instructions or after a jump
+ */
+static uint16_t sample_at(const uint8_t *image, uint16_t pc, uint8_t op){
+    for(int back=1; back<=op_length(op); back++){
+        if(image[(uint16_t)(pc-back)] == op) return pc-back;
+    }
+    return pc;
+}
+
+/**
+ *   addr  samples      %  cumul  instruction
+ */
+static int profile_show(int top){
+    static uint8_t  image[65536];
+    static uint64_t hits[65536];
+    static uint32_t order[65536];
+    uint8_t  loaded[256] = { 0 };
+    uint64_t total = 0;
+    uint32_t n = 0;
+
+    // Only the pages the samples are in
+    for(auto &s : samples){
+        uint16_t pc = s.first >> 8;
+        for(uint8_t page : { (uint16_t)(pc-3)>>8, pc>>8 }){
+            if(loaded[page]) continue;
+            if(!mem_read(page<<8, 256, &image[page<<8])) return 0;
+            loaded[page] = 1;
+        }
+    }
+    memset(hits, 0, sizeof(hits));
+    for(auto &s : samples){
+        hits[sample_at(image, s.first>>8, (uint8_t)s.first)] += s.second;
+        total += s.second;
+    }
+    for(uint32_t a=0; a<65536; a++){
+        if(hits[a]) order[n++] = a;
+    }
+    std::sort(order, order + n, [](uint32_t a, uint32_t b){
+        return hits[a] != hits[b] ? hits[a] > hits[b] : a < b;
+    });
+
+    printf("%llu samples in the program, %llu elsewhere, %llu lost\n",
+           (unsigned long long)total, (unsigned long long)other, (unsigned long long)lost);
+    if(!total) return 1;
+    printf("addr  samples      %%  cumul  instruction\n");
+    uint64_t cumul = 0;
+    for(uint32_t i=0; i<n && i<(uint32_t)top; i++){
+        char line[32];
+        cumul += hits[order[i]];
+        disasm(image, order[i], line);
+        printf("%04X %8llu %6.2f %6.2f  %s\n", order[i], (unsigned long long)hits[order[i]],
+               100.0*hits[order[i]]/total, 100.0*cumul/total, line);
+    }
+    return 1;
+}
+
+/**
+ * Starts the sampler, merges a poll every POLL_MS and stops it
+ */
+static int cmd_profile(double secs, uint16_t hz, int top){
+    uint8_t req[2] = { (uint8_t)hz, (uint8_t)(hz>>8) };
+    uint8_t off[2] = { 0, 0 };
+
+    samples.clear();
+    lost = other = 0;
+    if(!sample_poll(req, 2)) return 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while(seconds(t0) < secs){
+        usleep(POLL_MS * 1000);
+        if(!sample_poll(NULL, 0)) break;
+    }
+    if(!sample_poll(off, 2)) return 0;
+
+    // The slots a full reply left behind
+    while(polled == SAMPLE_REPLY){
+        if(!sample_poll(NULL, 0)) return 0;
+    }
+    return profile_show(top);
+}
+
+static int run_command(char *line){
+    char    *argv[8];
+    int      argc = 0;
+    uint8_t  req[4];
+    Reply    r;
+
+    for(char *t=strtok(line, " \t\r\n"); t && argc<8; t=strtok(NULL, " \t\r\n")){
+        argv[argc++] = t;
+    }
+    if(!argc) return 1;
+
+    const char *c = argv[0];
+    uint32_t a1 = argc>1 ? strtoul(argv[1], NULL, 16) : 0;
+    uint32_t a2 = argc>2 ? strtoul(argv[2], NULL, 16) : 0;
+    uint32_t a3 = argc>3 ? strtoul(argv[3], NULL, 16) : 0;
+
+    if(!strcmp(c, "ping")){
+        if(!request(P_PING, NULL, 0, &r)) return 0;
+        memLast = r.data[4] | r.data[5]<<8;
+        printf("%.3s v%d, memory 0000-%04X\n", (char *)r.data, r.data[3], memLast);
+    }else if(!strcmp(c, "regs")){
+        Regs regs;
+        if(!get_regs(&regs)) return 0;
+        regs_show(&regs);
+    }else if(!strcmp(c, "set") && argc == 3){
+        return cmd_set(argv[1], strtoul(argv[2], NULL, 16));
+    }else if(!strcmp(c, "mem") && argc >= 2){
+        static uint8_t buf[65536];
+        uint32_t len = argc > 2 ? a2 : 0x40;
+        if(!mem_read(a1, len, buf)) return 0;
+        hexdump(a1, buf, len);
+    }else if(!strcmp(c, "fill") && argc == 4){
+        // A 64 KB fill takes two requests
+        for(uint32_t done=0, n; done < a2; done += n){
+            n = a2 - done > 0x8000 ? 0x8000 : a2 - done;
+            uint8_t b[6] = { BK_FILL, (uint8_t)(a1+done), (uint8_t)((a1+done)>>8),
+                             (uint8_t)n, (uint8_t)(n>>8), (uint8_t)a3 };
+            if(!request(P_BLOCK, b, sizeof(b), NULL)) return 0;
+        }
+    }else if(!strcmp(c, "copy") && argc == 4){
+        uint8_t b[7] = { BK_COPY, (uint8_t)a1, (uint8_t)(a1>>8), (uint8_t)a2,
+                         (uint8_t)(a2>>8), (uint8_t)a3, (uint8_t)(a3>>8) };
+        return request(P_BLOCK, b, sizeof(b), NULL);
+    }else if((!strcmp(c, "insert") || !strcmp(c, "delete")) && argc >= 3){
+        uint32_t end = argc > 3 ? a3 : memLast + 1;
+        uint32_t lo  = argc > 4 ? strtoul(argv[4], NULL, 16) : 0;
+        uint8_t  rel = argc > 5 ? strtoul(argv[5], NULL, 16) != 0 : 1;
+        uint8_t  b[10] = { (uint8_t)(c[0] == 'i' ? BK_INSERT : BK_DELETE),
+                           (uint8_t)a1, (uint8_t)(a1>>8), (uint8_t)a2, (uint8_t)(a2>>8),
+                           (uint8_t)end, (uint8_t)(end>>8), (uint8_t)lo, (uint8_t)(lo>>8), rel };
+        if(!request(P_BLOCK, b, sizeof(b), &r) || r.len != 4) return 0;
+        printf("%d branches patched, %d short ones out of reach\n",
+               r.data[0] | r.data[1]<<8, r.data[2] | r.data[3]<<8);
+    }else if(!strcmp(c, "find") && argc == 4){
+        uint8_t b[PROTO_MAX] = { BK_SEARCH, (uint8_t)a1, (uint8_t)(a1>>8), (uint8_t)a2, (uint8_t)(a2>>8) };
+        uint8_t n = 5;
+        for(const char *h=argv[3]; h[0] && h[1] && n<PROTO_MAX; h+=2){
+            char hex[3] = { h[0], h[1], 0 };
+            b[n++] = strtoul(hex, NULL, 16);
+        }
+        if(!request(P_BLOCK, b, n, &r)) return 0;
+        if(r.len == 2){
+            printf("%04X\n", r.data[0] | r.data[1]<<8);
+        }else{
+            printf("not found\n");
+        }
+    }else if(!strcmp(c, "load") && argc >= 2){
+        return cmd_load(argv[1], a2);
+    }else if(!strcmp(c, "save") && argc == 4){
+        return cmd_save(argv[1], a2, a3);
+    }else if(!strcmp(c, "step")){
+        uint16_t n = argc > 1 ? a1 : 1;
+        req[0] = n; req[1] = n>>8;
+        if(!request(P_STEP, req, 2, NULL)) return 0;
+        if(!recv_frame(&r, TIMEOUT_MS) || r.cmd != P_STOPPED) return 0;
+        show_stopped(&r);
+    }else if(!strcmp(c, "back")){
+        uint16_t n = argc > 1 ? a1 : 1;
+        req[0] = n; req[1] = n>>8;
+        if(!request(P_BACK, req, 2, &r)) return 0;
+        if(r.len == 2){
+            printf("%d steps back\n", r.data[0] | r.data[1]<<8);
+        }
+        Regs regs;
+        if(!get_regs(&regs)) return 0;
+        regs_show(&regs);
+    }else if(!strcmp(c, "run")){
+        req[0] = a1; req[1] = a1>>8;
+        return request(P_RUN, req, argc > 1 ? 2 : 0, NULL);
+    }else if(!strcmp(c, "stop")){
+        return request(P_STOP, NULL, 0, NULL);
+    }else if(!strcmp(c, "wait")){
+        while(!recv_frame(&r, 1000) || r.cmd != P_STOPPED);
+        show_stopped(&r);
+    }else if(!strcmp(c, "break") && argc == 2){
+        req[0] = a1; req[1] = a1>>8;
+        return request(P_BREAK, req, 2, NULL);
+    }else if(!strcmp(c, "clear")){
+        req[0] = a1; req[1] = a1>>8;
+        return request(P_CLEAR, req, argc > 1 ? 2 : 0, NULL);
+    }else if(!strcmp(c, "profile") && argc >= 2){
+        return cmd_profile(atof(argv[1]), argc > 2 ? atoi(argv[2]) : SAMPLE_HZ,
+                           argc > 3 ? atoi(argv[3]) : 20);
+    }else if(!strcmp(c, "quit")){
+        exit(0);
+    }else{
+        fprintf(stderr, "unknown command %s\n", c);
+        return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv){
+    char line[256];
+
+    if(argc < 2){
+        fprintf(stderr, "usage: elfmon device [command ...]\n");
+        return 1;
+    }
+    if(!open_port(argv[1])) return 1;
+
+    if(argc > 2){
+        for(int i=2; i<argc; i++){
+            strncpy(line, argv[i], sizeof(line)-1);
+            line[sizeof(line)-1] = 0;
+            if(!run_command(line)) return 1;
+        }
+        return 0;
+    }
+
+    int tty = isatty(0);
+    for(;;){
+        if(tty){
+            printf("elf> ");
+            fflush(stdout);
+        }
+        if(!fgets(line, sizeof(line), stdin)) break;
+        run_command(line);
+    }
+    return 0;
+}
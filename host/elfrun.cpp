@@ -0,0 +1,594 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+/**
+ * Headless runner for batch and performance runs
+ *
+ *   elfuino-run [-c cycles] [-n instructions] [-b addr] [-e script]
+ *               [-m addr:len] [-o final.bin] [-s] [-f] [-q] [-w]
+ *               [-C listing.txt] [-H heatmap.html]
+ *               [-t play.wav] [-r record.wav] [-a] [-R cycle] image
+ *
+ * The image is a binary loaded at 0 or an Intel HEX file. The CPU
+ * runs until IDL, a breakpoint (-b, repeatable) or the cycle or
+ * instruction limit, then the statistics, the registers and the
+ * -m ranges are printed. -o writes the whole memory, -s runs SCRT
+ * routines instruction by instruction, -f runs the pairs of fuse.h
+ * one by one, -q prints the statistics only.
+ *
+ * Built with -DMEM_MAPPED and memmap.cpp a binary image is mapped
+ * instead of read, copy on write, or with -w shared so the run
+ * leaves its memory in the image file.
+ *
+ * Built with -DELF_COVERAGE and coverage.cpp, -C writes an annotated
+ * disassembly of the code run and -H a heatmap of the accesses, HTML
+ * when the name ends in .html. Built with -DELF_SPI_SRAM -DSRAM_STATS,
+ * sram.cpp and sramspi.cpp, memory goes through the SPI SRAM cache
+ * and its hit rate is printed.
+ *
+ * Built with -DELF_TAPE, tape.cpp and cassette.cpp, -t plays a WAV or
+ * .bit tape into EF2 and -r records Q into one. The tape routines in
+ * tape.h move whole blocks at once unless -a is given.
+ *
+ * Built with -DELF_REWIND and rewind.cpp the run keeps a rewind
+ * history, -R goes back to the given cycle once it stops; the
+ * registers, the ranges and -o are then the machine at that cycle.
+ *
+ * Built with -DELF_JIT -DMEM_WRITE_HOOK=jit_write and jit.cpp, on
+ * x86-64 hosts, hot code is translated to host code as it runs.
+ *
+ * Built with -DELF_PAIRS the most frequent pairs of consecutive
+ * instructions are printed, the register of register ops as r. They
+ * pick the fused handlers of fuse.h.
+ *
+ * The script drives the inputs at given cycle times, one event per
+ * line, numbers in hex:
+ *
+ *   # cycle  event
+ *   0        sw 3F      switches read by INP
+ *   1F40     ef 4 1     EF4 level
+ *
+ * Exit status is 0 on IDL, 2 on a breakpoint and 3 on a limit.
+ */
+#include <Arduino.h>
+#include <chrono>
+#include <vector>
+#include "cpu.h"
+#include "mem.h"
+#include "scrt.h"
+#include "fuse.h"
+#include "hostio.h"
+#ifdef ELF_TAPE
+#include "tape.h"
+#include "cassette.h"
+#endif
+#ifdef ELF_CHIP8
+#include "chip8.h"
+#endif
+#ifdef MEM_MAPPED
+#include "memmap.h"
+#endif
+#ifdef ELF_REWIND
+#include "rewind.h"
+#endif
+#ifdef ELF_JIT
+#include "jit.h"
+#endif
+
+#define MAX_RANGES 16
+
+// Stop reasons, also the exit status
+#define STOP_IDLE   0
+#define STOP_BREAK  2
+#define STOP_LIMIT  3
+
+typedef struct Event{
+    uint64_t cycle;
+    uint8_t  kind;          // 's' switches, 'e' EF line
+    uint8_t  line;
+    uint8_t  value;
+} Event;
+
+static Board              elf;
+static uint8_t            breaks[65536];
+#if defined(ELF_JIT) || defined(ELF_PAIRS)
+static int                fuse = 0;     // Both need every instruction apart
+#else
+static int                fuse = 1;
+#endif
+static std::vector<Event> events;
+#ifdef ELF_PAIRS
+static uint64_t           pairs[256][256];
+#endif
+#ifdef MEM_MAPPED
+static int                shared;       // -w, writes go to the image file
+#endif
+
+/**************************** Loading ****************************/
+static int hex_byte(const char *s){
+    int v;
+    if(sscanf(s, "%2x", &v) != 1) return -1;
+    return v;
+}
+
+/**
+ * Intel HEX, data and end of file records. The extended address
+ * records are accepted and ignored, everything is below 64 KB.
+ */
+static int load_hex(FILE *f, const char *path){
+    char line[600];
+    int  n = 0;
+
+    while(fgets(line, sizeof(line), f)){
+        n++;
+        if(line[0] != ':') continue;
+        int len  = hex_byte(line+1);
+        int hi   = hex_byte(line+3);
+        int lo   = hex_byte(line+5);
+        int type = hex_byte(line+7);
+        if(len < 0 || hi < 0 || lo < 0 || type < 0 || strlen(line) < (size_t)11 + len*2){
+            fprintf(stderr, "%s:%d: bad record\n", path, n);
+            return 0;
+        }
+        uint8_t sum = len + hi + lo + type;
+        for(int i=0; i<=len; i++){
+            sum += hex_byte(line + 9 + i*2);
+        }
+        if(sum){
+            fprintf(stderr, "%s:%d: bad checksum\n", path, n);
+            return 0;
+        }
+        if(type == 1) break;
+        if(type != 0) continue;
+        for(int i=0; i<len; i++){
+            MEM_WR((uint16_t)((hi<<8 | lo) + i), hex_byte(line + 9 + i*2));
+        }
+    }
+    return 1;
+}
+
+static int load_image(const char *path){
+    FILE *f = fopen(path, "rb");
+    if(!f){
+        perror(path);
+        return 0;
+    }
+    int c = fgetc(f);
+    ungetc(c, f);
+
+    int ok = 1;
+#ifdef MEM_MAPPED
+    if(c == ':'){
+        ok = mem_map(NULL, MM_PRIVATE) && load_hex(f, path);
+    }else{
+        ok = mem_map(path, shared ? MM_SHARED : MM_PRIVATE) != NULL;
+    }
+#elif defined(ELF_SPI_SRAM)
+    if(c == ':'){
+        ok = load_hex(f, path);
+    }else{
+        static uint8_t buf[MEM_SIZE];
+        size_t n = fread(buf, 1, MEM_SIZE, f);
+        for(size_t i=0; i<n; i++){
+            MEM_WR(i, buf[i]);
+        }
+    }
+#else
+    if(c == ':'){
+        ok = load_hex(f, path);
+    }else{
+        fread(mem, 1, MEM_SIZE, f);
+    }
+#endif
+    fclose(f);
+    return ok;
+}
+
+static int load_script(const char *path){
+    FILE *f = fopen(path, "r");
+    char  line[256];
+    int   n = 0;
+
+    if(!f){
+        perror(path);
+        return 0;
+    }
+    while(fgets(line, sizeof(line), f)){
+        unsigned long long cycle;
+        char     what[8];
+        unsigned a, b = 0;
+        Event    e;
+
+        n++;
+        char *hash = strchr(line, '#');
+        if(hash) *hash = 0;
+        int got = sscanf(line, "%llx %7s %x %x", &cycle, what, &a, &b);
+        if(got <= 0) continue;
+
+        e.cycle = cycle;
+        if(got == 3 && !strcmp(what, "sw")){
+            e.kind  = 's';
+            e.line  = 0;
+            e.value = a;
+        }else if(got == 4 && !strcmp(what, "ef") && a >= 1 && a <= 4){
+            e.kind  = 'e';
+            e.line  = a - 1;
+            e.value = b != 0;
+        }else{
+            fprintf(stderr, "%s:%d: bad event\n", path, n);
+            fclose(f);
+            return 0;
+        }
+        if(!events.empty() && e.cycle < events.back().cycle){
+            fprintf(stderr, "%s:%d: events out of order\n", path, n);
+            fclose(f);
+            return 0;
+        }
+        events.push_back(e);
+    }
+    fclose(f);
+    return 1;
+}
+
+/**************************** Output ****************************/
+static void show_regs(){
+    for(int i=0; i<16; i++){
+        printf("R%X=%04X%s", i, cpu.R[i], (i&7)==7 ? "\n" : " ");
+    }
+    printf("D=%02X DF=%d X=%X P=%X I=%X N=%X T=%02X Q=%d IE=%d\n",
+           cpu.D, cpu.DF, cpu.X, cpu.P, cpu.I, cpu.N, cpu.T, cpu.Q, cpu.IE);
+    printf("OUT=%02X SW=%02X EF=%X\n", elf.leds, elf.switches, elf.ef);
+}
+
+#ifdef ELF_COVERAGE
+static int write_report(const char *path, void (*report)(FILE *f)){
+    FILE *f = fopen(path, "w");
+    if(!f){
+        perror(path);
+        return 0;
+    }
+    report(f);
+    fclose(f);
+    return 1;
+}
+#endif
+
+// dumpMem() lines, the last one cut to the bytes of the range:
+// hex from column 8, three per byte, characters from column 59
+static void show_mem(uint16_t addr, uint32_t len){
+    char line[80];
+    for(uint32_t i=0; i<len; i+=16){
+        dumpMem((uint16_t)(addr + i), line);
+        if(len - i < 16){
+            uint32_t n = len - i;
+            memset(line + 8 + 3*n, ' ', 3*(16 - n));
+            line[59 + n] = 0;
+        }
+        printf("%s\n", line);
+    }
+}
+
+#ifdef ELF_PAIRS
+/**
+ * Opcode with the register dropped, where N is a register: LDN,
+ * INC, DEC, LDA, STR, GLO, GHI, PLO, PHI, SEP and SEX
+ */
+static uint8_t pair_class(uint8_t op){
+    uint8_t i = op >> 4;
+    if((i == 0 && op) || i == 1 || i == 2 || i == 4 || i == 5 || (i >= 8 && i <= 0xB) || i == 0xD || i == 0xE){
+        return op & 0xF0;
+    }
+    return op;
+}
+
+static void pair_name(uint8_t c, char *s){
+    uint8_t i = c >> 4;
+    int reg = ((i == 0 && c == 0) || i == 3 || i == 6 || i == 7 || i == 0xC || i == 0xF) ? 0 : 1;
+    sprintf(s, reg ? "%Xr" : "%02X", reg ? i : c);
+}
+
+static void show_pairs(){
+    uint64_t total = 0;
+    for(int a=0; a<256; a++){
+        for(int b=0; b<256; b++) total += pairs[a][b];
+    }
+    for(int k=0; k<16 && total; k++){
+        int ba = 0, bb = 0;
+        for(int a=0; a<256; a++){
+            for(int b=0; b<256; b++){
+                if(pairs[a][b] > pairs[ba][bb]){
+                    ba = a;
+                    bb = b;
+                }
+            }
+        }
+        if(!pairs[ba][bb]) break;
+        char sa[4], sb[4];
+        pair_name(ba, sa);
+        pair_name(bb, sb);
+        printf("pair         %s %s %6.2f%%\n", sa, sb, 100.0 * pairs[ba][bb] / total);
+        pairs[ba][bb] = 0;
+    }
+}
+#endif
+
+/**************************** Run ****************************/
+static uint8_t is_break(uint16_t addr){
+    return breaks[addr];
+}
+
+static void apply(const Event *e){
+    if(e->kind == 's'){
+        elf.switches = e->value;
+    }else{
+        elf.ef = (elf.ef & ~(1<<e->line)) | e->value<<e->line;
+    }
+}
+
+/**
+ * Runs until a stop condition, events are applied between
+ * instructions once their cycle is reached
+ */
+static int run(uint64_t maxCycles, uint64_t maxInstr, uint64_t *executed){
+    size_t   next = 0;
+    uint64_t n    = 0;              // Fused tails are on top, from fuse_count
+    uint64_t base = fuse_count;
+    int      reason;
+#ifdef ELF_PAIRS
+    uint8_t  last = 0;
+#endif
+
+    for(;;){
+        uint64_t now = GET_CYCLES();
+        while(next < events.size() && events[next].cycle <= now){
+            apply(&events[next++]);
+        }
+        uint64_t limit = next < events.size() && events[next].cycle < maxCycles ?
+                         events[next].cycle : maxCycles;
+
+        // Pairs only while neither limit is a pair away, then one by one
+        uint64_t end   = limit;
+        uint64_t calls = maxInstr - (n + (fuse_count - base));
+        fuse_enabled = fuse && limit > now + 2*FUSE_TAIL && calls > FUSE_TAIL;
+        if(fuse_enabled){
+            end    = limit - 2*FUSE_TAIL;
+            calls /= 1 + FUSE_TAIL;
+        }
+
+        // Hot loop up to the next event or the limit
+        while(GET_CYCLES() < end && calls){
+#ifdef ELF_JIT
+            // Stops on the instruction the interpreter would stop on
+            uint64_t until = limit;
+#ifdef ELF_REWIND
+            if(rewindNext < until) until = rewindNext;
+#endif
+            uint64_t ran = jit_run(until, calls);
+            n     += ran;
+            calls -= ran;
+#else
+#ifdef ELF_PAIRS
+            uint8_t op = pair_class(MEM_RD(cpu.R[cpu.P]));
+            if(n) pairs[last][op]++;
+            last = op;
+#endif
+            cpu_execute();
+            n++;
+            calls--;
+#endif
+#ifdef ELF_REWIND
+            rewind_poll();
+#endif
+            if(elf.idle){
+                reason = STOP_IDLE;
+                goto done;
+            }
+            if(breaks[cpu.R[cpu.P]]){
+                reason = STOP_BREAK;
+                goto done;
+            }
+        }
+        if(GET_CYCLES() >= maxCycles || n + (fuse_count - base) >= maxInstr){
+            reason = STOP_LIMIT;
+            break;
+        }
+    }
+done:
+    fuse_enabled = 0;
+    *executed = n + (fuse_count - base);
+    return reason;
+}
+
+int main(int argc, char **argv){
+    uint64_t    maxCycles = UINT64_MAX, maxInstr = UINT64_MAX;
+    const char *image = NULL, *script = NULL, *outPath = NULL;
+    uint16_t    rangeAddr[MAX_RANGES];
+    uint32_t    rangeLen[MAX_RANGES];
+    int         nranges = 0, quiet = 0;
+#ifdef ELF_COVERAGE
+    const char *listPath = NULL, *heatPath = NULL;
+#endif
+#ifdef ELF_REWIND
+    uint64_t    seekTo = UINT64_MAX;
+#endif
+
+    board_init(&elf);
+    board = &elf;
+    memset(&cpu, 0, sizeof(cpu));
+    cpu_reset();
+#ifdef ELF_SPI_SRAM
+    sram_init();
+#endif
+
+    for(int i=1; i<argc; i++){
+        unsigned a, l;
+        if(!strcmp(argv[i], "-c") && i+1<argc){
+            maxCycles = strtoull(argv[++i], NULL, 0);
+        }else if(!strcmp(argv[i], "-n") && i+1<argc){
+            maxInstr = strtoull(argv[++i], NULL, 0);
+        }else if(!strcmp(argv[i], "-b") && i+1<argc){
+            uint16_t addr = strtoul(argv[++i], NULL, 16) & 0xFFFF;
+            breaks[addr] = 1;
+            fuse_stop = is_break;
+#ifdef ELF_JIT
+            jit_stop(addr);
+#endif
+        }else if(!strcmp(argv[i], "-e") && i+1<argc){
+            script = argv[++i];
+        }else if(!strcmp(argv[i], "-m") && i+1<argc && nranges < MAX_RANGES &&
+                 sscanf(argv[i+1], "%x:%x", &a, &l) == 2){
+            rangeAddr[nranges] = a;
+            rangeLen[nranges++] = l;
+            i++;
+        }else if(!strcmp(argv[i], "-o") && i+1<argc){
+            outPath = argv[++i];
+        }else if(!strcmp(argv[i], "-s")){
+            scrt_enabled = 0;
+        }else if(!strcmp(argv[i], "-f")){
+            fuse = 0;
+        }else if(!strcmp(argv[i], "-q")){
+            quiet = 1;
+        }else if(!strcmp(argv[i], "-w")){
+#ifdef MEM_MAPPED
+            shared = 1;
+#else
+            fprintf(stderr, "-w needs a build with -DMEM_MAPPED\n");
+            return 1;
+#endif
+#ifdef ELF_COVERAGE
+        }else if(!strcmp(argv[i], "-C") && i+1<argc){
+            listPath = argv[++i];
+        }else if(!strcmp(argv[i], "-H") && i+1<argc){
+            heatPath = argv[++i];
+#endif
+#ifdef ELF_TAPE
+        }else if(!strcmp(argv[i], "-t") && i+1<argc){
+            if(!cas_play(argv[++i])) return 1;
+        }else if(!strcmp(argv[i], "-r") && i+1<argc){
+            cas_record(argv[++i]);
+        }else if(!strcmp(argv[i], "-a")){
+            tape_turbo = 0;
+#endif
+#ifdef ELF_REWIND
+        }else if(!strcmp(argv[i], "-R") && i+1<argc){
+            seekTo = strtoull(argv[++i], NULL, 0);
+#endif
+        }else if(argv[i][0] != '-' && !image){
+            image = argv[i];
+        }else{
+            image = NULL;
+            break;
+        }
+    }
+    if(!image){
+        fprintf(stderr, "usage: elfuino-run [-c cycles] [-n instructions] [-b addr] [-e script]\n"
+                        "                   [-m addr:len] [-o final.bin] [-s] [-f] [-q] [-w]\n"
+                        "                   [-C listing.txt] [-H heatmap.html]\n"
+                        "                   [-t play.wav] [-r record.wav] [-a] [-R cycle] image\n");
+        return 1;
+    }
+    if(!load_image(image)) return 1;
+    if(script && !load_script(script)) return 1;
+#ifdef ELF_JIT
+    jit_init();
+#endif
+#ifdef ELF_TAPE
+    cas_attach(&elf);
+#endif
+#ifdef ELF_REWIND
+    rewind_attach(&elf);
+#endif
+#ifdef ELF_SPI_SRAM
+    // Statistics of the run only, the stand-in restarts its bus counters
+    sram_flush();
+    sramAccesses = sramMisses = sramWritebacks = 0;
+    spi_sram_begin();
+#endif
+
+    uint64_t executed;
+    auto t0 = std::chrono::steady_clock::now();
+    int reason = run(maxCycles, maxInstr, &executed);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // Natively run SCRT routines, tape transfers and CHIP-8 batches
+    // count as the instructions they replace
+    uint64_t instructions = executed + scrt_calls*SCRT_CALL_INSTR +
+                            scrt_returns*SCRT_RETURN_INSTR;
+#ifdef ELF_TAPE
+    instructions += tape_instr;
+#endif
+#ifdef ELF_CHIP8
+    instructions += chip8_instr;
+#endif
+
+    static const char *reasons[] = { "idle", "", "breakpoint", "limit" };
+    printf("stop         %s at %04X\n", reasons[reason], cpu.R[cpu.P]);
+    printf("instructions %llu\n", (unsigned long long)instructions);
+    printf("cycles       %llu\n", (unsigned long long)GET_CYCLES());
+    printf("wall         %.6f s\n", secs);
+    printf("MIPS         %.2f\n", secs > 0 ? instructions / secs / 1e6 : 0.0);
+#ifdef ELF_FUSE
+    printf("fused        %llu instructions\n", (unsigned long long)fuse_count);
+#endif
+#ifdef ELF_PAIRS
+    show_pairs();
+#endif
+#ifdef SRAM_STATS
+    sram_report(stdout);
+#endif
+#ifdef ELF_TAPE
+    printf("tape         %u bytes read, %u written\n", tape_bytes_read, tape_bytes_written);
+    if(!cas_close()) return 1;
+#endif
+#ifdef ELF_JIT
+    printf("jit          %llu instructions native, %u blocks, %u dropped, %u flushes\n",
+           (unsigned long long)jit_native, jit_blocks, jit_dropped, jit_flushes);
+#endif
+#ifdef ELF_REWIND
+    printf("rewind       %u snapshots, %zu bytes, from cycle %llu\n", rewind_snapshots(),
+           rewind_bytes(), (unsigned long long)rewind_oldest());
+    if(seekTo != UINT64_MAX){
+        if(!rewind_seek(seekTo)){
+            fprintf(stderr, "cycle %llu is not in the history\n", (unsigned long long)seekTo);
+            return 1;
+        }
+        printf("rewound to   %llu\n", (unsigned long long)GET_CYCLES());
+    }
+#endif
+#ifdef ELF_COVERAGE
+    if(listPath && !write_report(listPath, cov_listing)) return 1;
+    if(heatPath){
+        size_t n = strlen(heatPath);
+        int html = n > 5 && !strcmp(heatPath + n - 5, ".html");
+        if(!write_report(heatPath, html ? cov_heatmap_html : cov_heatmap_text)) return 1;
+    }
+#endif
+    if(!quiet){
+        show_regs();
+        for(int i=0; i<nranges; i++){
+            show_mem(rangeAddr[i], rangeLen[i]);
+        }
+    }
+
+    if(outPath){
+        FILE *f = fopen(outPath, "wb");
+        if(!f){
+            perror(outPath);
+            return 1;
+        }
+        for(uint32_t a=0; a<MEM_SIZE; a++){
+            fputc(MEM_RD(a), f);
+        }
+        fclose(f);
+    }
+#ifdef MEM_MAPPED
+    mem_unmap();
+#endif
+    return reason;
+}
@@ -0,0 +1,210 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+/**
+ * Host Elf behind the serial debug protocol
+ *
+ *   elfserve [-i image.bin] [-l link] [-w]
+ *
+ * Opens a pseudo terminal and prints its name, elfmon drives the
+ * machine through it exactly like the board on a serial port.
+ * -l also makes a symlink with a fixed name to the pty.
+ *
+ * Built with -DMEM_MAPPED and memmap.cpp the image is mapped copy on
+ * write, with -w shared: memory persists in the file and elfview can
+ * watch it while the machine runs.
+ *
+ * Built with -DELF_SAMPLE and sample.cpp, SIGALRM is the timer of the
+ * PC sampler.
+ */
+#include <Arduino.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <unistd.h>
+#include "cpu.h"
+#include "mem.h"
+#include "hostio.h"
+#include "proto.h"
+#include "sample.h"
+#ifdef MEM_MAPPED
+#include "memmap.h"
+#endif
+
+static Board   elf;
+static int     master = -1;
+static uint8_t out[4096];
+static size_t  outLen;
+#ifdef MEM_MAPPED
+static int     shared;      // -w, writes go to the image file
+#endif
+
+uint16_t proto_room(){
+    return sizeof(out) - outLen > 0xFFFF ? 0xFFFF : sizeof(out) - outLen;
+}
+
+void proto_send(uint8_t c){
+    out[outLen++] = c;
+}
+
+#ifdef ELF_SAMPLE
+static void on_alarm(int){
+    sample_take();
+}
+
+void sample_timer(uint16_t hz){
+    struct itimerval it;
+    long us = hz ? 1000000L / hz : 0;
+
+    it.it_interval.tv_sec  = us / 1000000;
+    it.it_interval.tv_usec = us % 1000000;
+    it.it_value = it.it_interval;
+    setitimer(ITIMER_REAL, &it, NULL);
+}
+
+uint8_t sample_hold(){
+    sigset_t s;
+    sigemptyset(&s);
+    sigaddset(&s, SIGALRM);
+    sigprocmask(SIG_BLOCK, &s, NULL);
+    return 0;
+}
+
+void sample_release(uint8_t){
+    sigset_t s;
+    sigemptyset(&s);
+    sigaddset(&s, SIGALRM);
+    sigprocmask(SIG_UNBLOCK, &s, NULL);
+}
+#endif
+
+static void drain(){
+    size_t done = 0;
+    while(done < outLen){
+        ssize_t n = write(master, out + done, outLen - done);
+        if(n < 0){
+            perror("write");
+            exit(1);
+        }
+        done += n;
+    }
+    outLen = 0;
+}
+
+static int open_pty(const char *link){
+    struct termios tio;
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if(master < 0 || grantpt(master) || unlockpt(master)){
+        perror("pty");
+        return 0;
+    }
+    const char *name = ptsname(master);
+
+    // Raw slave, kept open so the master never sees a hang up
+    int slave = open(name, O_RDWR | O_NOCTTY);
+    if(slave < 0 || tcgetattr(slave, &tio)){
+        perror(name);
+        return 0;
+    }
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    if(link){
+        unlink(link);
+        if(symlink(name, link)){
+            perror(link);
+            return 0;
+        }
+        printf("%s -> %s\n", link, name);
+    }else{
+        printf("%s\n", name);
+    }
+    fflush(stdout);
+    return 1;
+}
+
+static int load_image(const char *path){
+#ifdef MEM_MAPPED
+    return mem_map(path, shared ? MM_SHARED : MM_PRIVATE) != NULL;
+#else
+    FILE *f = fopen(path, "rb");
+    if(!f){
+        perror(path);
+        return 0;
+    }
+    fread(mem, 1, MEM_SIZE, f);
+    fclose(f);
+    return 1;
+#endif
+}
+
+int main(int argc, char **argv){
+    const char *link = NULL, *image = NULL;
+
+    board_init(&elf);
+    board = &elf;
+    memset(&cpu, 0, sizeof(cpu));
+    cpu_reset();
+
+    for(int i=1; i<argc; i++){
+        if(!strcmp(argv[i], "-i") && i+1<argc){
+            image = argv[++i];
+        }else if(!strcmp(argv[i], "-l") && i+1<argc){
+            link = argv[++i];
+        }else if(!strcmp(argv[i], "-w")){
+#ifdef MEM_MAPPED
+            shared = 1;
+#else
+            fprintf(stderr, "-w needs a build with -DMEM_MAPPED\n");
+            return 1;
+#endif
+        }else{
+            fprintf(stderr, "usage: elfserve [-i image.bin] [-l link] [-w]\n");
+            return 1;
+        }
+    }
+#ifdef MEM_MAPPED
+    if(!image && !mem_map(NULL, MM_PRIVATE)) return 1;
+#endif
+    if(image && !load_image(image)) return 1;
+    if(!open_pty(link)) return 1;
+#ifdef ELF_SAMPLE
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_alarm;
+    sa.sa_flags   = SA_RESTART;
+    sigaction(SIGALRM, &sa, NULL);
+#endif
+
+    for(;;){
+        struct pollfd pfd = { master, POLLIN, 0 };
+        uint8_t in[512];
+
+        if(poll(&pfd, 1, proto_running() ? 0 : 10) > 0){
+            ssize_t n = read(master, in, sizeof(in));
+            for(ssize_t i=0; i<n; i++){
+                while(proto_busy()){
+                    proto_flush();
+                    drain();
+                }
+                proto_feed(in[i]);
+            }
+        }
+        if(proto_running()){
+            for(int i=0; i<64 && proto_running(); i++){
+                proto_execute();
+            }
+        }
+        proto_flush();
+        drain();
+    }
+}
@@ -0,0 +1,74 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+/**
+ * Live memory viewer
+ *
+ *   elfview image.bin [addr:len] [-t ms] [-1]
+ *
+ * Maps the image of a machine run with a shared mapping (elfserve -w,
+ * elfuino-run -w) read only and redraws the range every time it
+ * changes, reading the running machine's pages directly. -1 prints
+ * once and exits. Build with -DMEM_MAPPED.
+ */
+#include <Arduino.h>
+#include <unistd.h>
+#include "mem.h"
+#include "memmap.h"
+
+int main(int argc, char **argv){
+    const char *path = NULL;
+    unsigned    addr = 0, len = 0x100;
+    int         period = 100, once = 0;
+    uint8_t     last[MEM_SIZE];
+
+    for(int i=1; i<argc; i++){
+        if(!strcmp(argv[i], "-t") && i+1<argc){
+            period = atoi(argv[++i]);
+        }else if(!strcmp(argv[i], "-1")){
+            once = 1;
+        }else if(argv[i][0] != '-' && !path){
+            path = argv[i];
+        }else if(argv[i][0] != '-' && sscanf(argv[i], "%x:%x", &addr, &len) == 2){
+        }else{
+            path = NULL;
+            break;
+        }
+    }
+    if(!path){
+        fprintf(stderr, "usage: elfview image.bin [addr:len] [-t ms] [-1]\n");
+        return 1;
+    }
+    if(!mem_map(path, MM_READONLY)) return 1;
+    if(len > MEM_SIZE) len = MEM_SIZE;
+
+    for(int first=1; ; first=0){
+        int changed = first;
+        for(unsigned i=0; i<len; i++){
+            uint8_t v = RD_M(addr + i);
+            if(v != last[i]){
+                last[i] = v;
+                changed = 1;
+            }
+        }
+        if(changed){
+            char line[80];
+            if(!once) printf("\033[H\033[2J");
+            for(unsigned i=0; i<len; i+=16){
+                dumpMem((uint16_t)(addr + i), line);
+                printf("%s\n", line);
+            }
+            fflush(stdout);
+        }
+        if(once) break;
+        usleep(period * 1000);
+    }
+    mem_unmap();
+    return 0;
+}
@@ -0,0 +1,57 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "cpu.h"
+#include "io.h"
+#include "hostio.h"
+
+thread_local Board *board;
+
+void board_init(Board *b){
+    memset(b, 0, sizeof(Board));
+}
+
+void cpu_outputQ(){
+    if(!board) return;
+    board->q = cpu.Q;
+    if(board->outputQ) board->outputQ(board, cpu.Q);
+}
+
+uint8_t cpu_input(uint8_t Nlines){
+    if(board->input) return board->input(board, Nlines);
+    return board->switches;
+}
+
+void cpu_output(uint8_t data, uint8_t Nlines){
+    board->leds = data;
+    if(board->output) board->output(board, data, Nlines);
+}
+
+/**
+ * Read External flags
+ * The hook may refresh board->ef before it is sampled
+ */
+void cpu_testFlags(){
+    if(board->flags) board->flags(board);
+    cpu.EF1 = (board->ef>>0)&1;
+    cpu.EF2 = (board->ef>>1)&1;
+    cpu.EF3 = (board->ef>>2)&1;
+    cpu.EF4 = (board->ef>>3)&1;
+}
+
+/**
+ * IDL
+ * There is no IN button to wait for, the program counter is moved
+ * back so IDL repeats like the real chip does until DMA or interrupt.
+ */
+void cpu_idle(){
+    board->idle = 1;
+    cpu.R[cpu.P]--;
+}
@@ -0,0 +1,39 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __HOSTIO_H__
+#define __HOSTIO_H__
+
+#include <stdint.h>
+
+/**
+ * Host side Elf board: switches, LEDs, EF lines and Q.
+ * It replaces io.cpp on the host build, every machine thread
+ * points 'board' to its own instance.
+ * The hooks are optional, when NULL the plain latches are used.
+ */
+typedef struct Board{
+    uint8_t switches;   // Value read by INP
+    uint8_t leds;       // Last value written by OUT
+    uint8_t ef;         // EF1..EF4 levels, bit 0 is EF1
+    uint8_t q;          // Last Q level
+    uint8_t idle;       // Set while the CPU executes IDL
+
+    void    (*output) (struct Board *b, uint8_t data, uint8_t Nlines);
+    uint8_t (*input)  (struct Board *b, uint8_t Nlines);
+    void    (*outputQ)(struct Board *b, uint8_t q);
+    void    (*flags)  (struct Board *b);
+    void    *user;
+} Board;
+
+extern thread_local Board *board;
+
+void board_init(Board *b);
+
+#endif
@@ -0,0 +1,792 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <vector>
+#include "cpu.h"
+#include "mem.h"
+#include "hostio.h"
+#include "jit.h"
+
+#if !defined(__x86_64__)
+#error "the JIT writes x86-64 code"
+#endif
+#if MEM_SIZE != 65536 || defined(ELF_COVERAGE) || defined(ELF_SPI_SRAM) || defined(ELF_EEPROM_MEM)
+#error "the JIT needs the plain 64 KB memory"
+#endif
+#ifndef MEM_WRITE_HOOK
+#error "build the JIT with -DMEM_WRITE_HOOK=jit_write"
+#endif
+
+/**
+ * State the host code reaches off RBP. The registers while a block
+ * runs:
+ *
+ *   RBX &cpu   RBP &ctx   R12 mem   R13 D   R14 DF   R15 cycles left
+ *
+ * RAX, RCX, RDX, RSI and RDI are scratch within an instruction.
+ */
+typedef struct JitCtx{
+    int64_t   cyclesLeft;       // To the limit
+    int64_t   instrLeft;
+    CDP1802  *cpu;
+    uint8_t  *mem;
+    uint32_t  smcAddr;          // Byte of a block a native store hit
+    uint8_t   smc;              // A hook dropped a block
+    uint16_t  code[65536];      // Live blocks over each byte
+} JitCtx;
+
+typedef struct JitBlock{
+    uint16_t  pc, last;         // First and last byte, in one or two pages
+    uint8_t   p, x;
+    uint8_t   dead;
+    uint32_t  cycles, instr;    // Of the longest path
+    uint8_t  *code;
+    JitBlock *next;             // Others at the same PC
+    std::vector<uint32_t> incoming;     // Exits linked to it
+} JitBlock;
+
+// An exit to a known address, linked once a block is there
+typedef struct JitExit{
+    uint8_t  *jump;             // rel32 of its JMP
+    uint8_t  *stub;             // Returns it to the dispatcher
+    uint16_t  pc;
+    uint8_t   p, x;
+} JitExit;
+
+// Dispatcher return codes, an exit to link returns EXIT_LINK + its index
+#define EXIT_PLAIN 0
+#define EXIT_SMC   1
+#define EXIT_LINK  16
+
+// Most doublings of the heat a PC needs again after its blocks get dropped
+#define JIT_BACKOFF 8
+
+ELF_TLS uint32_t jit_hot = JIT_HOT;
+ELF_TLS uint64_t jit_native;
+ELF_TLS uint32_t jit_blocks;
+ELF_TLS uint32_t jit_dropped;
+ELF_TLS uint32_t jit_flushes;
+
+static ELF_TLS JitCtx   *ctx;
+static ELF_TLS uint8_t  *buf, *at, *codeStart;
+static ELF_TLS uint8_t  *exitCode, *budgetCode;
+static ELF_TLS uint32_t (*enter)(const uint8_t *code, JitCtx *c);
+static ELF_TLS JitBlock *byPc[65536];
+static ELF_TLS uint32_t  heat[65536];
+static ELF_TLS uint8_t   cold[65536];    // Drops of blocks from each PC
+static ELF_TLS uint8_t   stops[65536];
+static ELF_TLS std::vector<JitBlock*> *pages;   // Blocks over each page
+static ELF_TLS std::vector<JitBlock*> *blocks;
+static ELF_TLS std::vector<JitExit>   *exits;
+
+// Native stores inline unless the build has a write hook of its own
+static void (*const writeHook)(uint16_t, uint8_t) = MEM_WRITE_HOOK;
+
+/**************************** Encoder ****************************/
+enum { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+// Memory operand base + index*2^scale + disp, index -1 for none
+typedef struct Mem{
+    int     base, index, scale;
+    int32_t disp;
+} Mem;
+
+static Mem at_cpu(size_t offset)       { Mem m = { RBX, -1, 0, (int32_t)offset }; return m; }
+static Mem at_ctx(size_t offset)       { Mem m = { RBP, -1, 0, (int32_t)offset }; return m; }
+static Mem at_reg(uint8_t n)           { return at_cpu(offsetof(CDP1802, R) + 2*n); }
+static Mem at_mem()                    { Mem m = { R12, RCX, 0, 0 }; return m; }
+static Mem at_code()                   { Mem m = { RBP, RCX, 1, (int32_t)offsetof(JitCtx, code) }; return m; }
+
+static void b(uint8_t v){ *at++ = v; }
+static void d16(uint16_t v){ memcpy(at, &v, 2); at += 2; }
+static void d32(uint32_t v){ memcpy(at, &v, 4); at += 4; }
+
+// force: a REX even without bits, for SPL-DIL as byte registers
+static void rex(uint8_t w, int reg, int index, int base, uint8_t force){
+    uint8_t r = 0x40 | w<<3 | (reg>>3&1)<<2 | (index>>3&1)<<1 | (base>>3&1);
+    if(r != 0x40 || force) b(r);
+}
+
+static void opcode(uint16_t op){
+    if(op > 0xFF) b(op >> 8);
+    b(op);
+}
+
+static void x_mem(uint8_t w, uint8_t p66, uint16_t op, int reg, Mem m){
+    if(p66) b(0x66);
+    rex(w, reg, m.index < 0 ? 0 : m.index, m.base, (op == 0x88 || op == 0x0FB6) && reg >= RSP && reg <= RDI);
+    opcode(op);
+    int rm = m.base & 7;
+    uint8_t mod = m.disp == 0 && rm != 5 ? 0 : m.disp >= -128 && m.disp < 128 ? 1 : 2;
+    if(m.index >= 0 || rm == 4){
+        b(mod<<6 | (reg&7)<<3 | 4);
+        b(m.scale<<6 | ((m.index >= 0 ? m.index : RSP) & 7)<<3 | rm);
+    }else{
+        b(mod<<6 | (reg&7)<<3 | rm);
+    }
+    if(mod == 1) b(m.disp);
+    if(mod == 2) d32(m.disp);
+}
+
+static void x_reg(uint8_t w, uint16_t op, int reg, int rm){
+    rex(w, reg, 0, rm, op == 0x0FB6 && rm >= RSP && rm <= RDI);
+    opcode(op);
+    b(0xC0 | (reg&7)<<3 | (rm&7));
+}
+
+// Group 1 extensions of 81 /n
+#define G_ADD 0
+#define G_OR  1
+#define G_AND 4
+#define G_SUB 5
+#define G_XOR 6
+#define G_CMP 7
+
+// Two register forms, op r/m32, r32
+#define OP_ADD  0x01
+#define OP_OR   0x09
+#define OP_AND  0x21
+#define OP_XOR  0x31
+#define OP_TEST 0x85
+#define OP_MOV  0x89
+
+#define CC_E  0x4
+#define CC_NE 0x5
+#define CC_L  0xC
+#define CC_LE 0xE
+
+static void movzx_w (int r, Mem m)               { x_mem(0, 0, 0x0FB7, r, m); }
+static void movzx_b (int r, Mem m)               { x_mem(0, 0, 0x0FB6, r, m); }
+static void movzx_rb(int r, int src)             { x_reg(0, 0x0FB6, r, src); }
+static void store_b (Mem m, int r)               { x_mem(0, 0, 0x88, r, m); }
+static void store_d (Mem m, int r)               { x_mem(0, 0, 0x89, r, m); }
+static void store_q (Mem m, int r)               { x_mem(1, 0, 0x89, r, m); }
+static void load_q  (int r, Mem m)               { x_mem(1, 0, 0x8B, r, m); }
+static void mov_w_i (Mem m, uint16_t v)          { x_mem(0, 1, 0xC7, 0, m); d16(v); }
+static void mov_b_i (Mem m, uint8_t v)           { x_mem(0, 0, 0xC6, 0, m); b(v); }
+static void inc_w   (Mem m)                      { x_mem(0, 1, 0xFF, 0, m); }
+static void dec_w   (Mem m)                      { x_mem(0, 1, 0xFF, 1, m); }
+static void grp_m   (uint8_t w, int g, Mem m, int32_t v){ x_mem(w, 0, 0x81, g, m); d32(v); }
+static void grp_r   (uint8_t w, int g, int r, int32_t v){ x_reg(w, 0x81, g, r); d32(v); }
+static void op_rr   (uint16_t op, int dst, int src)      { x_reg(0, op, src, dst); }
+static void shr_i   (int r, uint8_t n)           { x_reg(0, 0xC1, 5, r); b(n); }
+static void shl_i   (int r, uint8_t n)           { x_reg(0, 0xC1, 4, r); b(n); }
+
+static void mov_i(int r, uint32_t v){
+    rex(0, 0, 0, r, 0);
+    b(0xB8 + (r&7));
+    d32(v);
+}
+
+// Jumps return their rel32 to patch
+static uint8_t *jcc(uint8_t cc){
+    b(0x0F); b(0x80 | cc); d32(0);
+    return at - 4;
+}
+
+static uint8_t *jmp(){
+    b(0xE9); d32(0);
+    return at - 4;
+}
+
+static void patch(uint8_t *rel, const uint8_t *target){
+    int32_t d = (int32_t)(target - (rel + 4));
+    memcpy(rel, &d, 4);
+}
+
+/**************************** Runtime code ****************************/
+static const int saved[] = { RBX, RBP, R12, R13, R14, R15 };
+
+/**
+ * enter(code, ctx) loads the host registers and jumps to a block,
+ * the exit code stores them back and returns EAX
+ */
+static void emit_runtime(){
+    enter = (uint32_t (*)(const uint8_t*, JitCtx*))at;
+    for(int r : saved){
+        rex(0, 0, 0, r, 0);
+        b(0x50 + (r&7));
+    }
+    b(0x48); b(0x83); b(0xEC); b(0x08);             // sub rsp, 8
+    x_reg(1, 0x89, RSI, RBP);                       // mov rbp, rsi
+    load_q(RBX, at_ctx(offsetof(JitCtx, cpu)));
+    load_q(R12, at_ctx(offsetof(JitCtx, mem)));
+    movzx_b(R13, at_cpu(offsetof(CDP1802, D)));
+    movzx_b(R14, at_cpu(offsetof(CDP1802, DF)));
+    load_q(R15, at_ctx(offsetof(JitCtx, cyclesLeft)));
+    b(0xFF); b(0xE7);                               // jmp rdi
+
+    exitCode = at;
+    store_b(at_cpu(offsetof(CDP1802, D)), R13);
+    store_b(at_cpu(offsetof(CDP1802, DF)), R14);
+    store_q(at_ctx(offsetof(JitCtx, cyclesLeft)), R15);
+    b(0x48); b(0x83); b(0xC4); b(0x08);             // add rsp, 8
+    for(int i=5; i>=0; i--){
+        rex(0, 0, 0, saved[i], 0);
+        b(0x58 + (saved[i]&7));
+    }
+    b(0xC3);
+
+    // Out of budget, or a dropped block: nothing run from here
+    budgetCode = at;
+    op_rr(OP_XOR, RAX, RAX);
+    patch(jmp(), exitCode);
+    codeStart = at;
+}
+
+static void flush(){
+    if(blocks){
+        for(JitBlock *bl : *blocks) delete bl;
+        blocks->clear();
+        exits->clear();
+        for(int i=0; i<256; i++) pages[i].clear();
+    }
+    memset(byPc, 0, sizeof(byPc));
+    memset(ctx->code, 0, sizeof(ctx->code));
+    at = codeStart;
+}
+
+static void setup(){
+    if(buf) return;
+    buf = (uint8_t*)mmap(NULL, JIT_CODE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(buf == MAP_FAILED){
+        perror("jit");
+        exit(1);
+    }
+    ctx    = new JitCtx();
+    pages  = new std::vector<JitBlock*>[256];
+    blocks = new std::vector<JitBlock*>;
+    exits  = new std::vector<JitExit>;
+    at = buf;
+    emit_runtime();
+    flush();
+}
+
+/**************************** Translator ****************************/
+// State of the block being written at one of its exits
+typedef struct Tail{
+    uint8_t  *jump;             // Jcc or JMP to the stub
+    uint16_t  pc;               // R(P) after
+    uint16_t  in;               // I and N
+    uint32_t  cycles, instr;
+    uint8_t   x, kind;
+} Tail;
+
+#define TAIL_EXIT 0             // To pc, linked later
+#define TAIL_SMC  1             // A native store hit a block
+#define TAIL_HOOK 2             // The write hook dropped a block
+
+static ELF_TLS Tail     tails[3*JIT_BLOCK + 4];
+static ELF_TLS uint32_t ntails;
+
+static void sync(const Tail *t, uint8_t p){
+    mov_w_i(at_reg(p), t->pc);
+    mov_w_i(at_cpu(offsetof(CDP1802, I)), t->in);
+    grp_m(1, G_SUB, at_ctx(offsetof(JitCtx, instrLeft)), t->instr);
+    grp_r(1, G_SUB, R15, t->cycles);
+}
+
+// An exit jumps to its stub first, linking retargets the JMP
+static void emit_exit(const Tail *t, uint8_t p){
+    JitExit e;
+    sync(t, p);
+    e.jump = jmp();
+    e.stub = at;
+    e.pc   = t->pc;
+    e.p    = p;
+    e.x    = t->x;
+    mov_i(RAX, EXIT_LINK + exits->size());
+    patch(jmp(), exitCode);
+    patch(e.jump, e.stub);
+    exits->push_back(e);
+}
+
+// Instructions the interpreter runs, they end a block
+static uint8_t foreign(uint8_t op, uint8_t p, uint8_t x){
+    uint8_t i = op >> 4, n = op & 0x0F;
+    switch(i){
+        case 0x0: return n == 0 || n == p;
+        case 0x1: case 0x2: case 0x4: case 0x5:
+        case 0x8: case 0x9: case 0xA: case 0xB:
+            return n == p;
+        case 0x3: return (n & 7) >= 4 && n != 0x8;
+        case 0x6: return n == 0 ? x == p : n != 8;
+        case 0x7:
+            if(n == 0x0 || n == 0x1 || n == 0x9 || n == 0xA || n == 0xB) return 1;
+            return n <= 0x8 && n != 0x6 && x == p;
+        case 0xD: return 1;
+        case 0xF: return n <= 0x7 && n != 0x6 && x == p;
+    }
+    return 0;
+}
+
+// The store of an instruction, always its last effect
+static void emit_store(int value, Tail *t){
+    if(writeHook == jit_write){
+        store_b(at_mem(), value);
+        x_mem(0, 1, 0x83, G_CMP, at_code()); b(0);     // cmp word [code+addr*2], 0
+        t->kind = TAIL_SMC;
+    }else{
+        op_rr(OP_MOV, RDI, RCX);
+        op_rr(OP_MOV, RSI, value);
+        b(0x48); b(0xB8);                           // mov rax, hook
+        uint64_t h = (uint64_t)writeHook;
+        memcpy(at, &h, 8);
+        at += 8;
+        b(0xFF); b(0xD0);                           // call rax
+        x_mem(0, 0, 0x80, G_CMP, at_ctx(offsetof(JitCtx, smc))); b(0);
+        t->kind = TAIL_HOOK;
+    }
+    t->jump = jcc(CC_NE);
+    ntails++;
+}
+
+// D = eax + src + carry, DF = the carry out; carry 0, 1 or 2 for DF
+static void emit_add(int src, uint8_t carry){
+    op_rr(OP_ADD, RAX, src);
+    if(carry == 1) grp_r(0, G_ADD, RAX, 1);
+    if(carry == 2) op_rr(OP_ADD, RAX, R14);
+    op_rr(OP_MOV, R14, RAX);
+    shr_i(R14, 8);
+    movzx_rb(R13, RAX);
+}
+
+// EDX = ~D
+static void not_d(){
+    op_rr(OP_MOV, RDX, R13);
+    grp_r(0, G_XOR, RDX, 0xFF);
+}
+
+static JitBlock *find(uint16_t pc, uint8_t p, uint8_t x){
+    for(JitBlock *bl = byPc[pc]; bl; bl = bl->next){
+        if(bl->p == p && bl->x == x) return bl;
+    }
+    return NULL;
+}
+
+static JitBlock *translate(uint16_t start, uint8_t p, uint8_t x0){
+    if(JIT_CODE - (at - buf) < 32768){
+        flush();
+        jit_flushes++;
+    }
+    uint8_t  *entry = at;
+    uint16_t  pc = start, last = start;
+    uint32_t  cycles = 0, instr = 0;
+    uint8_t   x = x0, done = 0;
+    uint16_t  in = 0;
+    Tail     *t;
+
+    // Nothing runs unless the whole block fits the budgets
+    uint8_t *cyclesImm, *instrImm;
+    grp_r(1, G_CMP, R15, 0);
+    cyclesImm = at - 4;
+    patch(jcc(CC_LE), budgetCode);
+    grp_m(1, G_CMP, at_ctx(offsetof(JitCtx, instrLeft)), 0);
+    instrImm = at - 4;
+    patch(jcc(CC_L), budgetCode);
+
+    ntails = 0;
+    while(!done){
+        uint8_t op = MEM_RD(pc);
+        if(instr && (instr >= JIT_BLOCK || stops[pc] || (pc >> 8) != (start >> 8))) break;
+        if(foreign(op, p, x)) break;
+
+        uint8_t  i = op >> 4, n = op & 0x0F, len = 1, c = i == 0xC ? 3 : 2;
+        uint16_t next;
+        if(i == 0xC && (n <= 0x3 || (n >= 0x9 && n <= 0xB))) len = 3;
+        if(i == 0x3 || (i == 0x7 && n >= 0xC && n != 0xE) || (i == 0xF && n >= 0x8 && n != 0xE)) len = 2;
+        uint8_t k  = MEM_RD((uint16_t)(pc + 1));
+        uint16_t lk = (uint16_t)k << 8 | MEM_RD((uint16_t)(pc + 2));
+        uint16_t pc1 = pc + 1;
+        next = pc + len;
+        in = i | n << 8;
+        cycles += c;
+        instr++;
+        uint16_t end = pc + len - 1;
+        if((uint16_t)(end - start) > (uint16_t)(last - start)) last = end;
+
+        t = &tails[ntails];
+        t->pc = next; t->in = in; t->cycles = cycles; t->instr = instr; t->x = x;
+
+        switch(i){
+            case 0x0:   // LDN
+                movzx_w(RCX, at_reg(n));
+                movzx_b(R13, at_mem());
+                break;
+            case 0x1: inc_w(at_reg(n)); break;
+            case 0x2: dec_w(at_reg(n)); break;
+            case 0x3:{
+                // Short branches and SKP, the target is in the page of the operand
+                uint16_t target = (pc1 & 0xFF00) | k;
+                uint8_t  cc = 0xFF;
+                switch(n){
+                    case 0x0:
+                        t->pc = target;
+                        t->jump = jmp();
+                        t->kind = TAIL_EXIT;
+                        ntails++;
+                        done = 1;
+                        break;
+                    case 0x8: next = pc + 2; break;
+                    case 0x1: case 0x9:
+                        x_mem(0, 0, 0x80, G_CMP, at_cpu(offsetof(CDP1802, Q))); b(0);
+                        cc = n == 0x1 ? CC_NE : CC_E;
+                        break;
+                    case 0x2: case 0xA:
+                        op_rr(OP_TEST, R13, R13);
+                        cc = n == 0x2 ? CC_E : CC_NE;
+                        break;
+                    case 0x3: case 0xB:
+                        op_rr(OP_TEST, R14, R14);
+                        cc = n == 0x3 ? CC_NE : CC_E;
+                        break;
+                }
+                if(cc != 0xFF){
+                    t->pc = target;
+                    t->jump = jcc(cc);
+                    t->kind = TAIL_EXIT;
+                    ntails++;
+                }
+                break;
+            }
+            case 0x4:   // LDA
+                movzx_w(RCX, at_reg(n));
+                movzx_b(R13, at_mem());
+                inc_w(at_reg(n));
+                break;
+            case 0x5:   // STR
+                movzx_w(RCX, at_reg(n));
+                emit_store(R13, t);
+                break;
+            case 0x6:   // IRX, 68 does nothing
+                if(n == 0) inc_w(at_reg(x));
+                break;
+            case 0x7:
+                switch(n){
+                    case 0x2:   // LDXA
+                        movzx_w(RCX, at_reg(x));
+                        movzx_b(R13, at_mem());
+                        inc_w(at_reg(x));
+                        break;
+                    case 0x3:   // STXD
+                        movzx_w(RCX, at_reg(x));
+                        dec_w(at_reg(x));
+                        emit_store(R13, t);
+                        break;
+                    case 0x4:   // ADC
+                        movzx_w(RCX, at_reg(x));
+                        movzx_b(RAX, at_mem());
+                        emit_add(R13, 2);
+                        break;
+                    case 0x5:   // SDB
+                        movzx_w(RCX, at_reg(x));
+                        movzx_b(RAX, at_mem());
+                        not_d();
+                        emit_add(RDX, 2);
+                        break;
+                    case 0x6:   // SHRC
+                        op_rr(OP_MOV, RAX, R13);
+                        shr_i(R13, 1);
+                        shl_i(R14, 7);
+                        op_rr(OP_OR, R13, R14);
+                        grp_r(0, G_AND, RAX, 1);
+                        op_rr(OP_MOV, R14, RAX);
+                        break;
+                    case 0x7:   // SMB
+                        movzx_w(RCX, at_reg(x));
+                        movzx_b(RAX, at_mem());
+                        grp_r(0, G_XOR, RAX, 0xFF);
+                        emit_add(R13, 2);
+                        break;
+                    case 0x8:   // SAV
+                        movzx_w(RCX, at_reg(x));
+                        movzx_b(RDX, at_cpu(offsetof(CDP1802, T)));
+                        emit_store(RDX, t);
+                        break;
+                    case 0xC:   // ADCI
+                        mov_i(RAX, k);
+                        emit_add(R13, 2);
+                        break;
+                    case 0xD:   // SDBI
+                        mov_i(RAX, k);
+                        not_d();
+                        emit_add(RDX, 2);
+                        break;
+                    case 0xE:   // SHLC
+                        op_rr(OP_MOV, RAX, R13);
+                        shl_i(R13, 1);
+                        op_rr(OP_OR, R13, R14);
+                        grp_r(0, G_AND, R13, 0xFF);
+                        shr_i(RAX, 7);
+                        op_rr(OP_MOV, R14, RAX);
+                        break;
+                    case 0xF:   // SMBI
+                        mov_i(RAX, k ^ 0xFF);
+                        emit_add(R13, 2);
+                        break;
+                }
+                break;
+            case 0x8: movzx_b(R13, at_reg(n)); break;
+            case 0x9: { Mem m = at_reg(n); m.disp++; movzx_b(R13, m); break; }
+            case 0xA: store_b(at_reg(n), R13); break;
+            case 0xB: { Mem m = at_reg(n); m.disp++; store_b(m, R13); break; }
+            case 0xC:{
+                // Long branches and skips, 3 cycles
+                uint8_t cc = 0xFF, skip = n >= 4 && n != 0x9 && n != 0xA && n != 0xB;
+                switch(n & 3){
+                    case 0x0:
+                        if(n == 0x4){
+                            skip = 0;       // NOP
+                        }else if(n == 0xC){
+                            x_mem(0, 0, 0x80, G_CMP, at_cpu(offsetof(CDP1802, IE))); b(0);
+                            cc = CC_NE;     // LSIE, as cpu_execute() tests IE
+                        }else if(n == 0x8){
+                            next = pc + 3;  // LSKP
+                            skip = 0;
+                        }else{
+                            t->pc = lk;     // LBR
+                            t->jump = jmp();
+                            t->kind = TAIL_EXIT;
+                            ntails++;
+                            done = 1;
+                            skip = 0;
+                        }
+                        break;
+                    case 0x1:
+                        x_mem(0, 0, 0x80, G_CMP, at_cpu(offsetof(CDP1802, Q))); b(0);
+                        cc = n == 0x1 || n == 0xD ? CC_E : CC_NE;
+                        break;
+                    case 0x2:
+                        op_rr(OP_TEST, R13, R13);
+                        cc = n == 0x2 || n == 0xE ? CC_NE : CC_E;
+                        break;
+                    case 0x3:
+                        op_rr(OP_TEST, R14, R14);
+                        cc = n == 0x3 || n == 0xF ? CC_E : CC_NE;
+                        break;
+                }
+                if(cc != 0xFF){
+                    // Taken leaves, cc is the condition to go on at pc+1 or pc+3
+                    t->pc = skip ? (uint16_t)(pc + 3) : lk;
+                    t->jump = jcc(cc ^ 1);
+                    t->kind = TAIL_EXIT;
+                    ntails++;
+                    next = skip ? pc + 1 : pc + 3;
+                }
+                break;
+            }
+            case 0xE:   // SEX
+                mov_b_i(at_cpu(offsetof(CDP1802, X)), n);
+                x = n;
+                break;
+            case 0xF:
+                if(n <= 0x7 && n != 0x6) movzx_w(RCX, at_reg(x));
+                switch(n){
+                    case 0x0: movzx_b(R13, at_mem()); break;
+                    case 0x1: movzx_b(RAX, at_mem()); op_rr(OP_OR,  R13, RAX); break;
+                    case 0x2: movzx_b(RAX, at_mem()); op_rr(OP_AND, R13, RAX); break;
+                    case 0x3: movzx_b(RAX, at_mem()); op_rr(OP_XOR, R13, RAX); break;
+                    case 0x4: movzx_b(RAX, at_mem()); emit_add(R13, 0); break;
+                    case 0x5: movzx_b(RAX, at_mem()); not_d(); emit_add(RDX, 1); break;
+                    case 0x6:   // SHR
+                        op_rr(OP_MOV, R14, R13);
+                        grp_r(0, G_AND, R14, 1);
+                        shr_i(R13, 1);
+                        break;
+                    case 0x7:
+                        movzx_b(RAX, at_mem());
+                        grp_r(0, G_XOR, RAX, 0xFF);
+                        emit_add(R13, 1);
+                        break;
+                    case 0x8: mov_i(R13, k); break;
+                    case 0x9: grp_r(0, G_OR,  R13, k); break;
+                    case 0xA: grp_r(0, G_AND, R13, k); break;
+                    case 0xB: grp_r(0, G_XOR, R13, k); break;
+                    case 0xC: mov_i(RAX, k); emit_add(R13, 0); break;
+                    case 0xD: mov_i(RAX, k); not_d(); emit_add(RDX, 1); break;
+                    case 0xE:   // SHL
+                        op_rr(OP_MOV, R14, R13);
+                        shr_i(R14, 7);
+                        shl_i(R13, 1);
+                        grp_r(0, G_AND, R13, 0xFF);
+                        break;
+                    case 0xF: mov_i(RAX, k ^ 0xFF); emit_add(R13, 1); break;
+                }
+                break;
+        }
+        pc = next;
+    }
+    if(!instr){
+        at = entry;
+        return NULL;
+    }
+
+    // Falling off the end
+    if(!done){
+        t = &tails[ntails++];
+        t->pc = pc; t->in = in; t->cycles = cycles; t->instr = instr; t->x = x;
+        t->kind = TAIL_EXIT;
+        t->jump = jmp();
+    }
+    for(uint32_t j=0; j<ntails; j++){
+        t = &tails[j];
+        patch(t->jump, at);
+        if(t->kind == TAIL_SMC){
+            sync(t, p);
+            store_d(at_ctx(offsetof(JitCtx, smcAddr)), RCX);
+            mov_i(RAX, EXIT_SMC);
+            patch(jmp(), exitCode);
+        }else if(t->kind == TAIL_HOOK){
+            sync(t, p);
+            mov_i(RAX, EXIT_PLAIN);
+            patch(jmp(), exitCode);
+        }else{
+            emit_exit(t, p);
+        }
+    }
+    uint32_t v = cycles;
+    memcpy(cyclesImm, &v, 4);
+    memcpy(instrImm, &instr, 4);
+
+    JitBlock *bl = new JitBlock();
+    bl->pc     = start;
+    bl->last   = last;
+    bl->p      = p;
+    bl->x      = x0;
+    bl->cycles = cycles;
+    bl->instr  = instr;
+    bl->code   = entry;
+    bl->next   = byPc[start];
+    byPc[start] = bl;
+    blocks->push_back(bl);
+    pages[start >> 8].push_back(bl);
+    if((last >> 8) != (start >> 8)) pages[last >> 8].push_back(bl);
+    for(uint16_t a = start; ; a++){
+        ctx->code[a]++;
+        if(a == last) break;
+    }
+    jit_blocks++;
+    return bl;
+}
+
+/**************************** Dispatcher ****************************/
+static void drop(JitBlock *bl){
+    bl->dead = 1;
+    for(uint32_t k : bl->incoming){
+        patch((*exits)[k].jump, (*exits)[k].stub);
+    }
+    bl->incoming.clear();
+
+    // Whatever still jumps here goes back to the dispatcher
+    bl->code[0] = 0xE9;
+    patch(bl->code + 1, budgetCode);
+
+    for(JitBlock **l = &byPc[bl->pc]; *l; l = &(*l)->next){
+        if(*l == bl){
+            *l = bl->next;
+            break;
+        }
+    }
+    for(uint16_t pg : { (uint16_t)(bl->pc >> 8), (uint16_t)(bl->last >> 8) }){
+        std::vector<JitBlock*> &v = pages[pg];
+        for(size_t i=0; i<v.size(); i++){
+            if(v[i] == bl){
+                v.erase(v.begin() + i);
+                break;
+            }
+        }
+    }
+    for(uint16_t a = bl->pc; ; a++){
+        ctx->code[a]--;
+        if(a == bl->last) break;
+    }
+    // Code written as it runs is interpreted longer before the next try
+    if(cold[bl->pc] < JIT_BACKOFF) cold[bl->pc]++;
+    jit_dropped++;
+}
+
+void jit_touch(uint16_t addr){
+    if(!ctx || !ctx->code[addr]) return;
+    std::vector<JitBlock*> hit;
+    for(JitBlock *bl : pages[addr >> 8]){
+        if((uint16_t)(addr - bl->pc) <= (uint16_t)(bl->last - bl->pc)) hit.push_back(bl);
+    }
+    for(JitBlock *bl : hit){
+        drop(bl);
+    }
+    ctx->smc = 1;
+}
+
+void jit_write(uint16_t addr, uint8_t value){
+    mem[addr] = value;
+    jit_touch(addr);
+}
+
+void jit_stop(uint16_t addr){
+    stops[addr] = 1;
+}
+
+void jit_init(){
+    setup();
+    flush();
+    memset(heat, 0, sizeof(heat));
+    memset(cold, 0, sizeof(cold));
+}
+
+static void link(uint32_t k){
+    JitExit  *e  = &(*exits)[k];
+    JitBlock *to = find(e->pc, e->p, e->x);
+    if(!to || stops[e->pc]) return;
+    patch(e->jump, to->code);
+    to->incoming.push_back(k);
+}
+
+uint64_t jit_run(uint64_t limit, uint64_t maxInstr){
+    uint64_t n = 0;
+
+    setup();
+    ctx->cpu = &cpu;
+    ctx->mem = mem;
+    while(!board->idle && n < maxInstr){
+        uint64_t now = GET_CYCLES();
+        if(now >= limit) break;
+
+        uint16_t  pc = cpu.R[cpu.P];
+        JitBlock *bl = find(pc, cpu.P, cpu.X);
+        if(!bl && ++heat[pc] >= jit_hot << cold[pc]){
+            heat[pc] = 0;
+            bl = translate(pc, cpu.P, cpu.X);
+        }
+        if(bl && limit - now > bl->cycles && maxInstr - n >= bl->instr){
+            int64_t cycles = limit - now > INT64_MAX ? INT64_MAX : limit - now;
+            int64_t instr  = maxInstr - n > INT64_MAX ? INT64_MAX : maxInstr - n;
+            ctx->cyclesLeft = cycles;
+            ctx->instrLeft  = instr;
+            ctx->smc        = 0;
+            uint32_t r = enter(bl->code, ctx);
+            SET_CYCLES(now + (cycles - ctx->cyclesLeft));
+            n          += instr - ctx->instrLeft;
+            jit_native += instr - ctx->instrLeft;
+            if(r == EXIT_SMC){
+                jit_touch(ctx->smcAddr);
+            }else if(r >= EXIT_LINK){
+                link(r - EXIT_LINK);
+            }
+        }else{
+            cpu_execute();
+            n++;
+        }
+        if(stops[cpu.R[cpu.P]]) break;
+    }
+    return n;
+}
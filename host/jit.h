@@ -0,0 +1,71 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __JIT_H__
+#define __JIT_H__
+
+#include "cpu.h"
+
+/**
+ * x86-64 recompiler of the host build
+ *
+ * The dispatcher interprets and counts the fetches of every PC, a
+ * PC fetched JIT_HOT times starts a block: the straight run of
+ * instructions from it for the current P and X, up to the end of
+ * its page, a SEP, an I/O instruction, an EF branch, IDL or another
+ * one the interpreter has to see. Conditional branches and skips
+ * leave the block on their taken side, their other side goes on.
+ *
+ * D and DF live in host registers and R(P) is only written when a
+ * block is left; the scratchpad registers stay in the cpu struct,
+ * addressed off a host register. A block leaving to a known address
+ * is linked straight to the block there once that one exists, blocks
+ * only return to the dispatcher at the cycle or instruction limit,
+ * a stop address, an untranslated address or a device instruction.
+ *
+ * A block only runs when it can not cross the limits, so runs stop
+ * on the same instruction as the interpreter. A write, native or
+ * through WR_M, to a byte of a block drops that block and leaves the
+ * running one after the writing instruction.
+ */
+#ifndef JIT_HOT
+#define JIT_HOT   16            // Fetches of a PC before it gets a block
+#endif
+#ifndef JIT_BLOCK
+#define JIT_BLOCK 64            // Most instructions in a block
+#endif
+#ifndef JIT_CODE
+#define JIT_CODE  (16UL << 20)  // Bytes of host code, all dropped when full
+#endif
+
+extern ELF_TLS uint32_t jit_hot;        // JIT_HOT, can be changed between runs
+
+// Statistics
+extern ELF_TLS uint64_t jit_native;     // Instructions run in blocks
+extern ELF_TLS uint32_t jit_blocks;     // Blocks translated
+extern ELF_TLS uint32_t jit_dropped;    // Blocks dropped by writes
+extern ELF_TLS uint32_t jit_flushes;    // Code buffer refills
+
+// Drops every block, call it after memory is loaded from outside
+void     jit_init();
+
+// Runs return when R(P) gets to addr
+void     jit_stop(uint16_t addr);
+
+// MEM_WRITE_HOOK of a JIT build; a build with a hook of its own calls jit_touch from it
+void     jit_write(uint16_t addr, uint8_t value);
+void     jit_touch(uint16_t addr);
+
+/**
+ * Runs until the cycle count gets to limit, maxInstr instructions,
+ * IDL or a stop address, returns the instructions run
+ */
+uint64_t jit_run(uint64_t limit, uint64_t maxInstr);
+
+#endif
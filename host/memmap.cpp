@@ -0,0 +1,79 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mem.h"
+#include "memmap.h"
+
+#ifndef MEM_MAPPED
+#error memmap.cpp needs -DMEM_MAPPED
+#endif
+
+static ELF_TLS uint8_t mapMode;
+
+uint8_t *mem_map(const char *path, uint8_t mode){
+    struct stat st;
+    void *base;
+
+    // Zeroed space first, the file goes over the part it covers
+    base = mmap(NULL, MEM_SIZE, mode == MM_READONLY ? PROT_READ : PROT_READ|PROT_WRITE,
+                MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if(base == MAP_FAILED){
+        perror("mmap");
+        return NULL;
+    }
+    if(!path){
+        mapMode = MM_PRIVATE;
+        return mem = (uint8_t *)base;
+    }
+
+    int fd = open(path, mode == MM_SHARED ? O_RDWR|O_CREAT : O_RDONLY, 0644);
+    if(fd < 0 || fstat(fd, &st)){
+        perror(path);
+        munmap(base, MEM_SIZE);
+        return NULL;
+    }
+    if(mode == MM_SHARED && st.st_size < MEM_SIZE){
+        if(ftruncate(fd, MEM_SIZE)){
+            perror(path);
+            close(fd);
+            munmap(base, MEM_SIZE);
+            return NULL;
+        }
+        st.st_size = MEM_SIZE;
+    }
+
+    size_t len = st.st_size < MEM_SIZE ? st.st_size : MEM_SIZE;
+    if(len){
+        int prot  = mode == MM_READONLY ? PROT_READ : PROT_READ|PROT_WRITE;
+        int flags = (mode == MM_PRIVATE ? MAP_PRIVATE : MAP_SHARED) | MAP_FIXED;
+        if(mmap(base, len, prot, flags, fd, 0) == MAP_FAILED){
+            perror(path);
+            close(fd);
+            munmap(base, MEM_SIZE);
+            return NULL;
+        }
+    }
+    close(fd);
+    mapMode = mode;
+    return mem = (uint8_t *)base;
+}
+
+void mem_unmap(){
+    if(!mem) return;
+    if(mapMode == MM_SHARED){
+        msync(mem, MEM_SIZE, MS_SYNC);
+    }
+    munmap(mem, MEM_SIZE);
+    mem = NULL;
+}
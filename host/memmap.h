@@ -0,0 +1,39 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __MEMMAP_H__
+#define __MEMMAP_H__
+
+#include <stdint.h>
+
+/**
+ * File backed address space for builds with -DMEM_MAPPED
+ *
+ * The image file is mapped as 'mem' of the calling thread, pages
+ * fault in when the CPU touches them so there is no load loop.
+ *
+ *   MM_SHARED    writes go to the file, other processes see them live
+ *   MM_PRIVATE   copy on write, the file is never changed
+ *   MM_READONLY  watchers, a viewer maps the file of a running machine
+ *
+ * A shared image shorter than MEM_SIZE is extended with zeros, the
+ * others read zeros past the end of the file. A NULL path maps
+ * plain zeroed memory.
+ */
+#define MM_SHARED    0
+#define MM_PRIVATE   1
+#define MM_READONLY  2
+
+// Returns the mapping, also set as 'mem', or NULL after printing why
+uint8_t *mem_map(const char *path, uint8_t mode);
+
+// Writes a shared mapping back to the file and releases it
+void     mem_unmap();
+
+#endif
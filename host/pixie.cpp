@@ -0,0 +1,43 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include "cpu.h"
+#include "mem.h"
+#include "pixie.h"
+
+uint16_t pixieKeys;
+
+static uint8_t latched;
+
+static void pixie_output(Board *, uint8_t data, uint8_t Nlines){
+    if(Nlines == 2) latched = data & 0x0F;
+}
+
+static void pixie_flags(Board *b){
+    uint8_t frame = (GET_CYCLES() / PIXIE_FRAME) & 1;
+    uint8_t key   = (pixieKeys >> latched) & 1;
+    b->ef = (b->ef & ~0b0101) | frame | key<<2;
+}
+
+void pixie_attach(Board *b){
+    latched   = 0;
+    b->output = pixie_output;
+    b->flags  = pixie_flags;
+}
+
+void pixie_draw(FILE *f, uint8_t page){
+    for(uint16_t a=0; a<256; a++){
+        uint8_t bits = MEM_RD((uint16_t)(page << 8 | a));
+        for(uint8_t i=0; i<8; i++){
+            fputc(bits & (0x80 >> i) ? '#' : '.', f);
+        }
+        if((a & 7) == 7) fputc('\n', f);
+    }
+}
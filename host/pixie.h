@@ -0,0 +1,33 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __PIXIE_H__
+#define __PIXIE_H__
+
+#include <stdio.h>
+#include "hostio.h"
+
+/**
+ * COSMAC VIP I/O on the host board
+ *
+ * The 1861 Pixie shows a 256 byte page as 64x32 pixels, a frame is
+ * 262 lines of 14 machine cycles. EF1 toggles every frame, a level
+ * a polling program can not miss. OUT 2 latches a key of the hex
+ * keypad and EF3 is set while that key is down. Q is the tone.
+ */
+#define PIXIE_FRAME (262*14)
+
+extern uint16_t pixieKeys;      // Bit per key held down
+
+void pixie_attach(Board *b);
+
+// The page as text, '#' for a pixel
+void pixie_draw(FILE *f, uint8_t page);
+
+#endif
@@ -0,0 +1,314 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#include <Arduino.h>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include "cpu.h"
+#include "mem.h"
+#include "rewind.h"
+
+#ifdef ELF_SPI_SRAM
+#error "rewind.cpp needs the memory in 'mem'"
+#endif
+
+// cpu struct, board latches and memory, in whole 16 byte blocks
+#define CPU_BYTES   ((sizeof(CDP1802) + 15) & ~(size_t)15)
+#define BOARD_AT    CPU_BYTES
+#define MEM_AT      (CPU_BYTES + 16)
+#define STATE_SIZE  ((MEM_AT + MEM_SIZE + 15) & ~(size_t)15)
+
+typedef uint8_t v16 __attribute__((vector_size(16)));
+
+typedef struct Snap{
+    uint64_t cycle;
+    uint8_t  key;
+    std::vector<uint8_t> data;
+} Snap;
+
+typedef struct Input{
+    uint64_t cycle;
+    uint8_t  value;
+} Input;
+
+uint64_t rewindNext = 0;
+
+alignas(16) static uint8_t bufA[STATE_SIZE], bufB[STATE_SIZE], delta[STATE_SIZE];
+static uint8_t *cur = bufA, *prev = bufB;
+
+static std::deque<Snap> ring;
+static size_t   ringBytes;
+static uint32_t sinceKey;
+
+// EF levels in 0, INP values by N lines in 1-7
+static std::vector<Input> logs[8];
+
+// Calls before it replay the log
+static uint64_t frontier;
+
+static void    (*origOutput) (Board *b, uint8_t data, uint8_t Nlines);
+static uint8_t (*origInput)  (Board *b, uint8_t Nlines);
+static void    (*origOutputQ)(Board *b, uint8_t q);
+static void    (*origFlags)  (Board *b);
+
+/**************************** State ****************************/
+static void capture(uint8_t *s){
+    memset(s, 0, MEM_AT);
+    memcpy(s, &cpu, sizeof(cpu));
+    s[BOARD_AT+0] = board->switches;
+    s[BOARD_AT+1] = board->leds;
+    s[BOARD_AT+2] = board->ef;
+    s[BOARD_AT+3] = board->q;
+    s[BOARD_AT+4] = board->idle;
+    memcpy(s + MEM_AT, &mem[0], MEM_SIZE);
+}
+
+static void restore(const uint8_t *s){
+    memcpy(&cpu, s, sizeof(cpu));
+    board->switches = s[BOARD_AT+0];
+    board->leds     = s[BOARD_AT+1];
+    board->ef       = s[BOARD_AT+2];
+    board->q        = s[BOARD_AT+3];
+    board->idle     = s[BOARD_AT+4];
+    memcpy(&mem[0], s + MEM_AT, MEM_SIZE);
+}
+
+// d = a ^ b, 16 bytes at a time
+static void xor_state(uint8_t *d, const uint8_t *a, const uint8_t *b){
+    for(size_t i=0; i<STATE_SIZE; i+=16){
+        v16 x = *(const v16 *)(a + i) ^ *(const v16 *)(b + i);
+        *(v16 *)(d + i) = x;
+    }
+}
+
+static uint8_t block_zero(const uint8_t *p){
+    uint64_t lo, hi;
+    memcpy(&lo, p, 8);
+    memcpy(&hi, p + 8, 8);
+    return !(lo | hi);
+}
+
+/**
+ * Runs of zeros and literal bytes, both lengths as 7 bit groups:
+ *
+ *   zeros  count  literal bytes ..
+ */
+static void put_len(std::vector<uint8_t> &o, size_t n){
+    while(n >= 0x80){
+        o.push_back((uint8_t)(n | 0x80));
+        n >>= 7;
+    }
+    o.push_back((uint8_t)n);
+}
+
+static size_t get_len(const uint8_t **p){
+    size_t  n = 0;
+    uint8_t shift = 0, b;
+    do{
+        b = *(*p)++;
+        n |= (size_t)(b & 0x7F) << shift;
+        shift += 7;
+    }while(b & 0x80);
+    return n;
+}
+
+static void rle_pack(std::vector<uint8_t> &o, const uint8_t *s){
+    size_t i = 0;
+    while(i < STATE_SIZE){
+        size_t z = i;
+        for(;;){
+            if(!(z & 15) && z < STATE_SIZE && block_zero(s + z)){
+                z += 16;
+            }else if(z < STATE_SIZE && !s[z]){
+                z++;
+            }else{
+                break;
+            }
+        }
+        // Literals up to two zeros in a row
+        size_t l = z;
+        while(l < STATE_SIZE && (s[l] || (l+1 < STATE_SIZE && s[l+1]))) l++;
+        put_len(o, z - i);
+        put_len(o, l - z);
+        o.insert(o.end(), s + z, s + l);
+        i = l;
+    }
+}
+
+// Writes the state, or XORs a delta into it
+static void rle_unpack(const std::vector<uint8_t> &in, uint8_t *d, uint8_t isDelta){
+    const uint8_t *p = in.data(), *end = p + in.size();
+    size_t i = 0;
+    while(p < end){
+        size_t z = get_len(&p);
+        if(!isDelta) memset(d + i, 0, z);
+        i += z;
+        size_t l = get_len(&p);
+        for(size_t k=0; k<l; k++){
+            d[i+k] = isDelta ? d[i+k] ^ p[k] : p[k];
+        }
+        p += l;
+        i += l;
+    }
+}
+
+/**************************** History ****************************/
+static size_t log_bytes(){
+    size_t n = 0;
+    for(int k=0; k<8; k++){
+        n += logs[k].size() * sizeof(Input);
+    }
+    return n;
+}
+
+// Drops entries before cycle, the one in force then stays
+static void trim_logs(uint64_t cycle){
+    for(int k=0; k<8; k++){
+        std::vector<Input> &l = logs[k];
+        size_t n = 0;
+        while(n+1 < l.size() && l[n+1].cycle <= cycle) n++;
+        l.erase(l.begin(), l.begin() + n);
+    }
+}
+
+static void trim(){
+    while(ringBytes + log_bytes() > REWIND_BUDGET){
+        size_t k = 1;
+        while(k < ring.size() && !ring[k].key) k++;
+        if(k == ring.size()){
+            // Only the newest group is left, start another one
+            sinceKey = REWIND_KEYFRAME;
+            return;
+        }
+        for(size_t i=0; i<k; i++){
+            ringBytes -= ring.front().data.size();
+            ring.pop_front();
+        }
+        trim_logs(ring.front().cycle);
+    }
+}
+
+void rewind_take(){
+    uint64_t now = GET_CYCLES();
+    rewindNext = (now / REWIND_INTERVAL + 1) * REWIND_INTERVAL;
+    // Replaying, the history is already there
+    if(!ring.empty() && now <= ring.back().cycle) return;
+
+    Snap s;
+    s.cycle = now;
+    s.key   = ring.empty() || sinceKey >= REWIND_KEYFRAME;
+    capture(cur);
+    if(s.key){
+        rle_pack(s.data, cur);
+        sinceKey = 1;
+    }else{
+        xor_state(delta, cur, prev);
+        rle_pack(s.data, delta);
+        sinceKey++;
+    }
+    std::swap(cur, prev);
+
+    ringBytes += s.data.size();
+    ring.push_back(std::move(s));
+    trim();
+}
+
+uint8_t rewind_seek(uint64_t cycle){
+    frontier = std::max(frontier, GET_CYCLES());
+    if(ring.empty() || cycle < ring.front().cycle || cycle > frontier) return 0;
+
+    // The last snapshot at or before cycle, back to its keyframe
+    size_t i = std::upper_bound(ring.begin(), ring.end(), cycle,
+                                [](uint64_t c, const Snap &s){ return c < s.cycle; }) - ring.begin() - 1;
+    size_t k = i;
+    while(!ring[k].key) k--;
+    rle_unpack(ring[k].data, delta, 0);
+    while(k < i){
+        rle_unpack(ring[++k].data, delta, 1);
+    }
+    restore(delta);
+
+    while(GET_CYCLES() < cycle){
+        cpu_execute();
+    }
+    rewindNext = (GET_CYCLES() / REWIND_INTERVAL + 1) * REWIND_INTERVAL;
+    return 1;
+}
+
+uint64_t rewind_oldest(){
+    return ring.empty() ? 0 : ring.front().cycle;
+}
+
+uint32_t rewind_snapshots(){
+    return ring.size();
+}
+
+size_t rewind_bytes(){
+    return ringBytes + log_bytes();
+}
+
+/**************************** Board ****************************/
+static uint8_t replaying(){
+    return GET_CYCLES() < frontier;
+}
+
+static void log_input(uint8_t kind, uint8_t value){
+    std::vector<Input> &l = logs[kind];
+    if(!l.empty() && l.back().value == value) return;
+    l.push_back({ GET_CYCLES(), value });
+}
+
+static uint8_t replay_input(uint8_t kind){
+    const std::vector<Input> &l = logs[kind];
+    auto it = std::upper_bound(l.begin(), l.end(), GET_CYCLES(),
+                               [](uint64_t c, const Input &e){ return c < e.cycle; });
+    return it == l.begin() ? 0 : (it - 1)->value;
+}
+
+static void rewind_flags(Board *b){
+    if(replaying()){
+        b->ef = (b->ef & 0xF0) | replay_input(0);
+        return;
+    }
+    if(origFlags) origFlags(b);
+    log_input(0, b->ef & 0x0F);
+}
+
+static uint8_t rewind_input(Board *b, uint8_t Nlines){
+    if(replaying()){
+        // The latch shows what the program read, not later panel changes
+        uint8_t v = replay_input(Nlines & 7);
+        if(!origInput) b->switches = v;
+        return v;
+    }
+    uint8_t v = origInput ? origInput(b, Nlines) : b->switches;
+    log_input(Nlines & 7, v);
+    return v;
+}
+
+static void rewind_output(Board *b, uint8_t data, uint8_t Nlines){
+    if(!replaying() && origOutput) origOutput(b, data, Nlines);
+}
+
+static void rewind_outputQ(Board *b, uint8_t q){
+    if(!replaying() && origOutputQ) origOutputQ(b, q);
+}
+
+void rewind_attach(Board *b){
+    origOutput  = b->output;
+    origInput   = b->input;
+    origOutputQ = b->outputQ;
+    origFlags   = b->flags;
+    b->output   = rewind_output;
+    b->input    = rewind_input;
+    b->outputQ  = rewind_outputQ;
+    b->flags    = rewind_flags;
+    rewind_take();
+}
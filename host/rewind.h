@@ -0,0 +1,61 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __REWIND_H__
+#define __REWIND_H__
+
+#include <stddef.h>
+#include "cpu.h"
+#include "hostio.h"
+
+/**
+ * Rewind history of a long run
+ *
+ * Every REWIND_INTERVAL cycles the machine state, the cpu struct,
+ * the board latches and the memory, is kept in a ring. Every
+ * REWIND_KEYFRAME-th snapshot is whole, the ones in between are
+ * the XOR against the previous snapshot; both are stored as runs
+ * of zeros and literal bytes, so an idle machine costs a few bytes
+ * a snapshot. The oldest keyframe and its deltas are dropped when
+ * the ring goes over its budget.
+ *
+ * The EF levels and INP values the program saw are logged when
+ * they change. A seek restores the snapshot before the cycle and
+ * runs forward to it with the logged inputs and the output hooks
+ * muted, the run itself must not be changed meanwhile.
+ */
+#ifndef REWIND_INTERVAL
+#define REWIND_INTERVAL 100000UL    // Machine cycles, about 0.45 s at 1.79 MHz
+#endif
+#ifndef REWIND_KEYFRAME
+#define REWIND_KEYFRAME 64
+#endif
+#ifndef REWIND_BUDGET
+#define REWIND_BUDGET   (16UL << 20)    // Bytes
+#endif
+
+extern uint64_t rewindNext;         // Cycle of the next snapshot
+
+// Wraps the input, flag and output hooks of the board, call it last
+void     rewind_attach(Board *b);
+
+// Between instructions, takes the snapshot when it is due
+void     rewind_take();
+static inline void rewind_poll(){
+    if(GET_CYCLES() >= rewindNext) rewind_take();
+}
+
+// Machine at the first instruction boundary at or after cycle, 0 when it is not in the history
+uint8_t  rewind_seek(uint64_t cycle);
+
+uint64_t rewind_oldest();           // First cycle a seek can reach
+uint32_t rewind_snapshots();
+size_t   rewind_bytes();            // Snapshots and input log
+
+#endif
@@ -0,0 +1,44 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied, 
+ * distributed and/or modify for any purposes, 
+ * except commercial purposes. 
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __SPSC_H__
+#define __SPSC_H__
+
+#include <atomic>
+#include <stddef.h>
+
+/**
+ * Single producer / single consumer lock-free ring.
+ * SIZE must be a power of two. head is only written by the
+ * consumer and tail only by the producer.
+ */
+template<typename T, size_t SIZE>
+struct Spsc{
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    T ring[SIZE];
+
+    bool push(const T &v){
+        size_t t = tail.load(std::memory_order_relaxed);
+        if(t - head.load(std::memory_order_acquire) == SIZE) return false;
+        ring[t & (SIZE-1)] = v;
+        tail.store(t+1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &v){
+        size_t h = head.load(std::memory_order_relaxed);
+        if(h == tail.load(std::memory_order_acquire)) return false;
+        v = ring[h & (SIZE-1)];
+        head.store(h+1, std::memory_order_release);
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,55 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+/**
+ * Host stand-in for the 23LC512 behind sram.cpp
+ *
+ * The chip is an array, every transfer is counted with its command
+ * and address bytes so sram_report() can tell the hit rate and the
+ * time the board would spend on the bus. Build with -DELF_SPI_SRAM
+ * -DSRAM_STATS and CDP1802/sram.cpp.
+ */
+#include <Arduino.h>
+#include "mem.h"
+
+// Bit banged SPI on the UNO, sramspi.cpp
+#define SPI_US_PER_BYTE 3.0
+
+static uint8_t  chip[65536];
+static uint64_t spiBytes, spiTransfers;
+
+void spi_sram_begin(){
+    spiBytes = spiTransfers = 0;
+}
+
+void spi_sram_read(uint16_t addr, uint8_t *buf, uint8_t len){
+    for(uint8_t i=0; i<len; i++){
+        buf[i] = chip[(uint16_t)(addr + i)];
+    }
+    spiBytes += 3 + len;
+    spiTransfers++;
+}
+
+void spi_sram_write(uint16_t addr, const uint8_t *buf, uint8_t len){
+    for(uint8_t i=0; i<len; i++){
+        chip[(uint16_t)(addr + i)] = buf[i];
+    }
+    spiBytes += 3 + len;
+    spiTransfers++;
+}
+
+void sram_report(FILE *f){
+    uint32_t hits = sramAccesses - sramMisses;
+    fprintf(f, "sram         %u accesses, %.2f%% hits, %u misses, %u write backs\n",
+            sramAccesses, sramAccesses ? 100.0 * hits / sramAccesses : 0.0,
+            sramMisses, sramWritebacks);
+    fprintf(f, "spi          %llu transfers, %llu bytes, %.3f s on the board bus\n",
+            (unsigned long long)spiTransfers, (unsigned long long)spiBytes,
+            spiBytes * SPI_US_PER_BYTE / 1e6);
+}
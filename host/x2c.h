@@ -0,0 +1,42 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+#ifndef __X2C_H__
+#define __X2C_H__
+
+#include <stdint.h>
+
+/**
+ * Interface between the C code written by elf2c and the runtime
+ * in x2crun.cpp.
+ *
+ * Every block is a straight run of 1802 instructions translated
+ * for a fixed P. It leaves R(P), I, N and cycles exactly as the
+ * interpreter would and returns to the dispatch trampoline.
+ */
+typedef struct X2cBlock{
+    uint16_t addr;          // First byte
+    uint16_t last;          // Last translated byte
+    uint8_t  p;             // Program counter register
+    uint16_t cycles;        // Cycles of the longest path
+    void   (*fn)(void);
+} X2cBlock;
+
+extern const X2cBlock x2c_blocks[];
+extern const uint16_t x2c_nblocks;
+extern const uint8_t  x2c_code[8192];   // Bitmap of translated bytes
+
+// Set by the write hook when a translated byte changes
+extern uint8_t x2c_smc;
+
+void x2c_write(uint16_t addr, uint8_t value);
+void x2c_init();
+void x2c_run(uint64_t limit);
+
+#endif
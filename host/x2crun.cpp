@@ -0,0 +1,150 @@
+/********************************************************
+ * There is no warranty for this software.
+ * This software you have permission to be copied,
+ * distributed and/or modify for any purposes,
+ * except commercial purposes.
+ * For commercial purposes contacted me:
+ *    diegocueva@gmail.com
+ *    www.diegocueva.com
+ ********************************************************/
+/**
+ * Runtime of the code written by elf2c, and a harness that runs the
+ * same image on the interpreter and on the translation, then checks
+ * registers, memory and cycles are identical.
+ *
+ *   x2crun image.bin [cycles]
+ *
+ * Build it with -DMEM_WRITE_HOOK=x2c_write so writes to translated
+ * bytes are seen.
+ */
+#include <Arduino.h>
+#include <chrono>
+#include "cpu.h"
+#include "mem.h"
+#include "hostio.h"
+#include "x2c.h"
+
+uint8_t x2c_smc;
+
+static const X2cBlock *table[65536];
+static uint8_t         dirty[256];      // Pages with modified translated bytes
+static uint64_t        blocksRun, interpreted;
+
+void x2c_write(uint16_t addr, uint8_t value){
+    if((x2c_code[addr>>3]>>(addr&7)) & 1 && mem[addr] != value){
+        dirty[addr>>8] = 1;
+        x2c_smc = 1;
+    }
+    mem[addr] = value;
+}
+
+void x2c_init(){
+    memset(table, 0, sizeof(table));
+    memset(dirty, 0, sizeof(dirty));
+    for(int i=0; i<x2c_nblocks; i++){
+        const X2cBlock *b = &x2c_blocks[i];
+        if(!table[b->addr]) table[b->addr] = b;
+    }
+    blocksRun = interpreted = 0;
+}
+
+/**
+ * Trampoline, a block only runs when it can not cross the limit,
+ * so both engines stop on the same instruction
+ */
+void x2c_run(uint64_t limit){
+    while(!board->idle){
+        uint64_t now = GET_CYCLES();
+        if(now >= limit) break;
+        const X2cBlock *b = table[cpu.R[cpu.P]];
+        if(b && b->p == cpu.P && now + b->cycles < limit &&
+           !dirty[b->addr>>8] && !dirty[b->last>>8]){
+            x2c_smc = 0;
+            b->fn();
+            blocksRun++;
+        }else{
+            cpu_execute();
+            interpreted++;
+        }
+    }
+}
+
+/**************************** Harness ****************************/
+static uint8_t image[MEM_SIZE];
+static Board   elf;
+
+static void machine_reset(){
+    board_init(&elf);
+    board = &elf;
+    memset(&cpu, 0, sizeof(cpu));
+    memcpy(mem, image, MEM_SIZE);
+    cpu_reset();
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point t0){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char **argv){
+    static uint8_t refMem[MEM_SIZE];
+    CDP1802  refCpu;
+    uint64_t limit = 100000000;
+
+    if(argc < 2){
+        fprintf(stderr, "usage: x2crun image.bin [cycles]\n");
+        return 1;
+    }
+    FILE *f = fopen(argv[1], "rb");
+    if(!f){
+        perror(argv[1]);
+        return 1;
+    }
+    fread(image, 1, sizeof(image), f);
+    fclose(f);
+    if(argc > 2) limit = strtoull(argv[2], NULL, 0);
+
+    // Reference, one opcode at a time
+    x2c_init();
+    machine_reset();
+    auto t0 = std::chrono::steady_clock::now();
+    while(!board->idle && GET_CYCLES() < limit){
+        cpu_execute();
+    }
+    double tRef = seconds_since(t0);
+    refCpu = cpu;
+    memcpy(refMem, mem, MEM_SIZE);
+
+    // Translated
+    x2c_init();
+    machine_reset();
+    t0 = std::chrono::steady_clock::now();
+    x2c_run(limit);
+    double tX2c = seconds_since(t0);
+
+    printf("cycles      %llu\n", (unsigned long long)GET_CYCLES());
+    printf("interpreter %.3f s\n", tRef);
+    printf("translated  %.3f s, %llu blocks, %llu interpreted, x%.2f\n",
+           tX2c, (unsigned long long)blocksRun, (unsigned long long)interpreted,
+           tRef/tX2c);
+
+    int diff = 0;
+    for(int i=0; i<16; i++){
+        if(cpu.R[i] != refCpu.R[i]){
+            printf("R%X %04X != %04X\n", i, cpu.R[i], refCpu.R[i]);
+            diff++;
+        }
+    }
+    #define CHECK(f) if(cpu.f != refCpu.f){ printf(#f " %X != %X\n", cpu.f, refCpu.f); diff++; }
+    CHECK(D)  CHECK(T)  CHECK(P)  CHECK(X)  CHECK(I)  CHECK(N)
+    CHECK(DF) CHECK(IE) CHECK(Q)
+    CHECK(EF1) CHECK(EF2) CHECK(EF3) CHECK(EF4)
+    CHECK(cycles) CHECK(cyclesHigh)
+    for(int i=0; i<MEM_SIZE; i++){
+        if(mem[i] != refMem[i]){
+            printf("M(%04X) %02X != %02X\n", i, mem[i], refMem[i]);
+            if(++diff > 20) break;
+        }
+    }
+    printf(diff ? "MISMATCH\n" : "match\n");
+    return diff ? 2 : 0;
+}